@@ -5,20 +5,37 @@
 echo "Building Task Manager with HTTP API support..."
 
 # Compile all source files except the main files
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/TaskManager.cpp -o obj/TaskManager.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/ChatManager.cpp -o obj/ChatManager.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/Task.cpp -o obj/Task.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/Chat.cpp -o obj/Chat.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/User.cpp -o obj/User.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/NetworkUtils.cpp -o obj/NetworkUtils.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/SocketAbstraction.cpp -o obj/SocketAbstraction.o
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude -c src/HTTPServer.cpp -o obj/HTTPServer.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/TaskManager.cpp -o obj/TaskManager.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/ChatManager.cpp -o obj/ChatManager.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/UserManager.cpp -o obj/UserManager.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/PubSub.cpp -o obj/PubSub.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/EventBus.cpp -o obj/EventBus.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/WorkerPool.cpp -o obj/WorkerPool.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/AdmissionControl.cpp -o obj/AdmissionControl.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/TimingWheel.cpp -o obj/TimingWheel.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/OutboundQueue.cpp -o obj/OutboundQueue.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/TCPServer.cpp -o obj/TCPServer.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/IoUring.cpp -o obj/IoUring.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/EventLoop.cpp -o obj/EventLoop.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/WebSocketServer.cpp -o obj/WebSocketServer.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/DetachableServer.cpp -o obj/DetachableServer.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/HTTPStreams.cpp -o obj/HTTPStreams.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/Task.cpp -o obj/Task.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/Chat.cpp -o obj/Chat.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/User.cpp -o obj/User.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/NetworkUtils.cpp -o obj/NetworkUtils.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/JsonWriter.cpp -o obj/JsonWriter.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/JsonReader.cpp -o obj/JsonReader.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/SocketAbstraction.cpp -o obj/SocketAbstraction.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/Framing.cpp -o obj/Framing.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/BinaryProtocol.cpp -o obj/BinaryProtocol.o
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude -c src/HTTPServer.cpp -o obj/HTTPServer.o
 
 # Compile server with all command processing
-g++ -std=c++11 -Wall -Wextra -pthread -Iinclude \
+g++ -std=c++17 -Wall -Wextra -pthread -Iinclude \
     src/server.cpp src/HTTPServer.cpp \
-    obj/TaskManager.o obj/ChatManager.o obj/Task.o obj/Chat.o obj/User.o \
-    obj/NetworkUtils.o obj/SocketAbstraction.o \
+    obj/TaskManager.o obj/ChatManager.o obj/UserManager.o obj/PubSub.o obj/EventBus.o obj/WorkerPool.o obj/AdmissionControl.o obj/TimingWheel.o obj/OutboundQueue.o obj/TCPServer.o obj/IoUring.o obj/EventLoop.o obj/WebSocketServer.o obj/DetachableServer.o obj/HTTPStreams.o obj/Task.o obj/Chat.o obj/User.o \
+    obj/NetworkUtils.o obj/JsonWriter.o obj/JsonReader.o obj/SocketAbstraction.o obj/Framing.o obj/BinaryProtocol.o \
     -o server_api
 
 echo "Build complete! Run with: ./server_api"
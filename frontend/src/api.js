@@ -1,11 +1,15 @@
 import axios from 'axios';
 
 const API_BASE_URL = 'http://localhost:8081/api';
+const WS_URL = 'ws://localhost:8082';
 
 class APIClient {
     constructor() {
         this.token = localStorage.getItem('token') || null;
         this.user = JSON.parse(localStorage.getItem('user') || 'null');
+        this.socket = null;
+        this.eventSource = null;
+        this.eventHandlers = {};
     }
 
     setAuthToken(token) {
@@ -19,6 +23,7 @@ class APIClient {
     }
 
     clearAuth() {
+        this.closeEventStream();
         this.token = null;
         this.user = null;
         localStorage.removeItem('token');
@@ -58,8 +63,10 @@ class APIClient {
     }
 
     // Tasks
-    async getTasks() {
-        const response = await axios.get(`${API_BASE_URL}/tasks`, {
+    // Pass the version from a previous response to fetch only changed tasks
+    async getTasks(since = null) {
+        const query = since !== null ? `?since=${since}` : '';
+        const response = await axios.get(`${API_BASE_URL}/tasks${query}`, {
             headers: this.getHeaders()
         });
         return response.data;
@@ -79,6 +86,14 @@ class APIClient {
         return response.data;
     }
 
+    // Long poll: resolves when tasks change after `since` or the server times out
+    async waitForTaskChanges(since) {
+        const response = await axios.get(`${API_BASE_URL}/tasks/wait?since=${since}`, {
+            headers: this.getHeaders()
+        });
+        return response.data;
+    }
+
     async createTask(title, description, deadlineDays = 7) {
         const response = await axios.post(`${API_BASE_URL}/tasks`, {
             title,
@@ -99,9 +114,54 @@ class APIClient {
         return response.data;
     }
 
+    // One change to many tasks: action is 'status', 'priority' or 'assign',
+    // fields its value, e.g. { status: 'IN_PROGRESS' } or { assigneeId: 3 }
+    async bulkUpdateTasks(action, taskIds, fields) {
+        const response = await axios.post(`${API_BASE_URL}/tasks/bulk`, {
+            action,
+            taskIds,
+            ...fields
+        }, {
+            headers: this.getHeaders()
+        });
+        return response.data;
+    }
+
+    // tasks: [{ title, description, deadlineDays }]
+    async bulkCreateTasks(tasks) {
+        const response = await axios.post(`${API_BASE_URL}/tasks/bulk`, {
+            action: 'create',
+            tasks
+        }, {
+            headers: this.getHeaders()
+        });
+        return response.data;
+    }
+
+    // Several task operations in one request, e.g.
+    // [{ op: 'createTask', title }, { op: 'assignTask', taskRef: 0, assigneeId: 3 }]
+    // atomic: all of them are applied or none
+    async batch(operations, atomic = false) {
+        const response = await axios.post(`${API_BASE_URL}/batch`, {
+            atomic,
+            operations
+        }, {
+            headers: this.getHeaders()
+        });
+        return response.data;
+    }
+
     // Chat
-    async getMessages() {
-        const response = await axios.get(`${API_BASE_URL}/chat`, {
+    async getMessages(channel = 'team', limit = 50, after = 0) {
+        const response = await axios.get(`${API_BASE_URL}/chat?channel=${channel}&limit=${limit}&after=${after}`, {
+            headers: this.getHeaders()
+        });
+        return response.data;
+    }
+
+    // Long poll: resolves when newer messages arrive or the server times out
+    async waitForMessages(after, channel = 'team') {
+        const response = await axios.get(`${API_BASE_URL}/chat/wait?channel=${channel}&after=${after}`, {
             headers: this.getHeaders()
         });
         return response.data;
@@ -116,6 +176,92 @@ class APIClient {
         return response.data;
     }
 
+    // Live events: one shared connection per tab, WebSocket first with the
+    // Server-Sent Events stream as fallback.
+    // Types: task, chat, private, presence, typing, plus 'resync' whenever the
+    // connection (re)opens or missed events, so callers refetch with their cursors.
+    onEvent(type, handler) {
+        if (!this.eventHandlers[type]) {
+            this.eventHandlers[type] = new Set();
+        }
+        this.eventHandlers[type].add(handler);
+        this.openEventStream();
+        return () => {
+            this.eventHandlers[type].delete(handler);
+            if (Object.values(this.eventHandlers).every(handlers => handlers.size === 0)) {
+                this.closeEventStream();
+            }
+        };
+    }
+
+    dispatchEvent(type, payload) {
+        (this.eventHandlers[type] || []).forEach(handler => handler(payload));
+    }
+
+    openEventStream() {
+        if (this.socket || this.eventSource || !this.token) return;
+
+        const socket = new WebSocket(`${WS_URL}/?token=${encodeURIComponent(this.token)}`);
+        let opened = false;
+        socket.onopen = () => {
+            opened = true;
+            this.dispatchEvent('resync');
+        };
+        socket.onmessage = (e) => {
+            const message = JSON.parse(e.data);
+            this.dispatchEvent(message.type, message.data);
+        };
+        socket.onclose = () => {
+            if (this.socket !== socket) return; // closed on purpose
+            this.socket = null;
+            if (opened) {
+                setTimeout(() => this.openEventStream(), 1000);
+            } else {
+                this.openServerSentEvents(); // WebSocket port unreachable
+            }
+        };
+        this.socket = socket;
+    }
+
+    openServerSentEvents() {
+        const source = new EventSource(`${API_BASE_URL}/events?token=${encodeURIComponent(this.token)}`);
+        ['task', 'tasks', 'chat', 'private', 'presence'].forEach(type => {
+            source.addEventListener(type, (e) => this.dispatchEvent(type, JSON.parse(e.data)));
+        });
+        source.addEventListener('resync', () => this.dispatchEvent('resync'));
+        source.onopen = () => this.dispatchEvent('resync');
+        source.onerror = () => {
+            // The browser retries dropped streams itself; a refused one is closed
+            if (source.readyState === EventSource.CLOSED && this.eventSource === source) {
+                this.eventSource = null;
+                setTimeout(() => this.openEventStream(), 5000);
+            }
+        };
+        this.eventSource = source;
+    }
+
+    closeEventStream() {
+        if (this.socket) {
+            const socket = this.socket;
+            this.socket = null;
+            socket.close();
+        }
+        if (this.eventSource) {
+            this.eventSource.close();
+            this.eventSource = null;
+        }
+    }
+
+    // Sends over the WebSocket; returns false when it is not open so the
+    // caller can fall back to the REST endpoint
+    sendRealtime(type, fields = {}) {
+        if (!this.socket || this.socket.readyState !== WebSocket.OPEN) {
+            return false;
+        }
+        this.socket.send(JSON.stringify({ type, ...fields }));
+        return true;
+    }
+
     // Users
     async getOnlineUsers() {
         const response = await axios.get(`${API_BASE_URL}/users/online`, {
@@ -212,16 +358,18 @@ class APIClient {
         return response.data;
     }
 
-    async getPrivateMessages(userId) {
-        const response = await axios.get(`${API_BASE_URL}/chat/private/${userId}`, {
+    async getPrivateMessages(userId, limit = 0, after = 0) {
+        const query = `?limit=${limit}&after=${after}`;
+        const response = await axios.get(`${API_BASE_URL}/chat/private/${userId}${query}`, {
             headers: this.getHeaders()
         });
         return response.data;
     }
 
     // Task Messages
-    async getTaskMessages(taskId) {
-        const response = await axios.get(`${API_BASE_URL}/tasks/${taskId}/messages`, {
+    async getTaskMessages(taskId, limit = 0) {
+        const query = limit > 0 ? `?limit=${limit}` : '';
+        const response = await axios.get(`${API_BASE_URL}/tasks/${taskId}/messages${query}`, {
             headers: this.getHeaders()
         });
         return response.data;
@@ -6,24 +6,56 @@ function Chat({ user }) {
     const [messages, setMessages] = useState([])
     const [newMessage, setNewMessage] = useState('')
     const [loading, setLoading] = useState(true)
+    const [typingUser, setTypingUser] = useState(null)
     const messagesEndRef = useRef(null)
+    const lastMessageId = useRef(0)
+    const lastTypingSent = useRef(0)
 
     useEffect(() => {
         loadMessages()
-        // Refresh messages every 3 seconds
-        const interval = setInterval(loadMessages, 3000)
-        return () => clearInterval(interval)
+        // New messages are pushed over the event stream; a resync refetches
+        // everything after the last message we hold
+        const offChat = api.onEvent('chat', (message) => {
+            if (message.type === 'CHAT') appendMessages([message])
+        })
+        const offResync = api.onEvent('resync', loadMessages)
+
+        // Typing indicators (WebSocket only) fade after 3 seconds
+        let typingTimer = null
+        const offTyping = api.onEvent('typing', (typing) => {
+            if (typing.targetUserId !== -1 || typing.userId === user.id) return
+            setTypingUser(typing.username)
+            clearTimeout(typingTimer)
+            typingTimer = setTimeout(() => setTypingUser(null), 3000)
+        })
+        return () => {
+            offChat()
+            offResync()
+            offTyping()
+            clearTimeout(typingTimer)
+        }
     }, [])
 
     useEffect(() => {
         scrollToBottom()
     }, [messages])
 
+    const appendMessages = (newMessages) => {
+        if (newMessages.length === 0) return
+        lastMessageId.current = Math.max(lastMessageId.current, newMessages[newMessages.length - 1].id)
+        setMessages(prev => {
+            // Pushed events and refetches may deliver the same message twice
+            const lastId = prev.length > 0 ? prev[prev.length - 1].id : 0
+            return [...prev, ...newMessages.filter(m => m.id > lastId)]
+        })
+    }
+
     const loadMessages = async () => {
         try {
-            const response = await api.getMessages()
+            // Only fetch messages newer than the last one we have
+            const response = await api.getMessages('team', 50, lastMessageId.current)
             if (response.success && response.data) {
-                setMessages(response.data)
+                appendMessages(response.data)
             }
         } catch (error) {
             console.error('Failed to load messages:', error)
@@ -41,14 +73,26 @@ function Chat({ user }) {
         if (!newMessage.trim()) return
 
         try {
-            await api.sendMessage(newMessage)
+            // The message comes back through the 'chat' event either way
+            if (!api.sendRealtime('chat', { content: newMessage })) {
+                await api.sendMessage(newMessage)
+                loadMessages()
+            }
             setNewMessage('')
-            loadMessages()
         } catch (error) {
             console.error('Failed to send message:', error)
         }
     }
 
+    const handleInputChange = (e) => {
+        setNewMessage(e.target.value)
+        const now = Date.now()
+        if (now - lastTypingSent.current > 2000) {
+            lastTypingSent.current = now
+            api.sendRealtime('typing')
+        }
+    }
+
     const formatTime = (timestamp) => {
         const date = new Date(timestamp)
         return date.toLocaleTimeString('en-US', {
@@ -90,11 +134,15 @@ function Chat({ user }) {
                 <div ref={messagesEndRef} />
             </div>
 
+            {typingUser && (
+                <div className="typing-indicator">{typingUser} is typing...</div>
+            )}
+
             <form onSubmit={handleSendMessage} className="chat-input-form">
                 <input
                     type="text"
                     value={newMessage}
-                    onChange={(e) => setNewMessage(e.target.value)}
+                    onChange={handleInputChange}
                     placeholder="Type a message..."
                     className="chat-input"
                 />
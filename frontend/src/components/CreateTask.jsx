@@ -48,21 +48,17 @@ function CreateTask({ onClose, onTaskCreated }) {
         setLoading(true)
 
         try {
-            const response = await api.createTask(title, description, deadlineDays)
-
-            if (response.success && response.data) {
-                const taskId = response.data.id
-
-                // Update priority if not default
-                if (priority !== 'MEDIUM') {
-                    await api.updateTaskPriority(taskId, priority)
-                }
-
-                // Assign task if assignee selected
-                if (assigneeId) {
-                    await api.assignTask(taskId, parseInt(assigneeId))
-                }
+            // One round trip: the follow-ups refer to the new task by index
+            const operations = [{ op: 'createTask', title, description, deadlineDays }]
+            if (priority !== 'MEDIUM') {
+                operations.push({ op: 'updateTaskPriority', taskRef: 0, priority })
+            }
+            if (assigneeId) {
+                operations.push({ op: 'assignTask', taskRef: 0, assigneeId: parseInt(assigneeId) })
+            }
+            const response = await api.batch(operations, true)
 
+            if (response.success) {
                 onTaskCreated()
             } else {
                 setError(response.error || 'Failed to create task')
@@ -1,4 +1,4 @@
-import { useState, useEffect } from 'react'
+import { useState, useEffect, useRef } from 'react'
 import api from '../api'
 import TaskList from './TaskList'
 import Chat from './Chat'
@@ -14,18 +14,55 @@ function Dashboard({ user, onLogout }) {
     const [showPrivateChat, setShowPrivateChat] = useState(false)
     const [loading, setLoading] = useState(true)
     const [stats, setStats] = useState(null)
+    const taskVersion = useRef(null)
 
     useEffect(() => {
+        taskVersion.current = null
         loadTasks()
         loadStats()
-        // Refresh tasks every 5 seconds
-        const interval = setInterval(() => {
+
+        // Changed tasks are pushed over the event stream. Filtered views and
+        // stats are computed server-side, so a burst of changes triggers one
+        // refetch a second later
+        let refreshTimer = null
+        const scheduleRefresh = () => {
+            if (refreshTimer) return
+            refreshTimer = setTimeout(() => {
+                refreshTimer = null
+                if (activeView !== 'all') loadTasks()
+                loadStats()
+            }, 1000)
+        }
+        const offTask = api.onEvent('task', (task) => {
+            if (activeView === 'all') mergeTasks([task])
+            scheduleRefresh()
+        })
+        // A bulk change arrives as one event carrying every task
+        const offTasks = api.onEvent('tasks', (tasks) => {
+            if (activeView === 'all') mergeTasks(tasks)
+            scheduleRefresh()
+        })
+        const offResync = api.onEvent('resync', () => {
             loadTasks()
             loadStats()
-        }, 5000)
-        return () => clearInterval(interval)
+        })
+        return () => {
+            offTask()
+            offTasks()
+            offResync()
+            clearTimeout(refreshTimer)
+        }
     }, [activeView])
 
+    const mergeTasks = (changed) => {
+        if (changed.length === 0) return
+        setTasks(prev => {
+            const byId = new Map(prev.map(t => [t.id, t]))
+            changed.forEach(t => byId.set(t.id, t))
+            return [...byId.values()].sort((a, b) => a.id - b.id)
+        })
+    }
+
     const loadTasks = async () => {
         try {
             let response
@@ -36,7 +73,17 @@ function Dashboard({ user, onLogout }) {
             } else if (activeView === 'due-soon') {
                 response = await api.getDueSoonTasks(3)
             } else {
-                response = await api.getTasks()
+                // After the first load only tasks changed since our version come back
+                response = await api.getTasks(taskVersion.current)
+                if (response.success && response.data) {
+                    const changed = response.data
+                    const isIncremental = taskVersion.current !== null
+                    taskVersion.current = response.version
+                    if (isIncremental) {
+                        mergeTasks(changed)
+                        return
+                    }
+                }
             }
 
             if (response.success && response.data) {
@@ -1,4 +1,4 @@
-import { useState, useEffect } from 'react'
+import { useState, useEffect, useRef } from 'react'
 import api from '../api'
 import './PrivateChat.css'
 
@@ -8,17 +8,32 @@ function PrivateChat({ currentUser, onClose }) {
     const [messages, setMessages] = useState([])
     const [newMessage, setNewMessage] = useState('')
     const [loading, setLoading] = useState(false)
+    const lastMessageId = useRef(0)
 
     useEffect(() => {
         loadUsers()
+        const offPresence = api.onEvent('presence', (changed) => {
+            setUsers(prev => prev.map(u => (u.id === changed.id ? changed : u)))
+        })
+        return offPresence
     }, [])
 
     useEffect(() => {
         if (selectedUser) {
+            lastMessageId.current = 0
+            setMessages([])
             loadMessages()
-            // Auto-refresh messages every 3 seconds
-            const interval = setInterval(loadMessages, 3000)
-            return () => clearInterval(interval)
+            // The server only streams private messages we sent or received
+            const offPrivate = api.onEvent('private', (message) => {
+                if (message.senderId === selectedUser.id || message.targetUserId === selectedUser.id) {
+                    appendMessages([message])
+                }
+            })
+            const offResync = api.onEvent('resync', loadMessages)
+            return () => {
+                offPrivate()
+                offResync()
+            }
         }
     }, [selectedUser])
 
@@ -39,24 +54,37 @@ function PrivateChat({ currentUser, onClose }) {
         if (!selectedUser) return
 
         try {
-            const response = await api.getPrivateMessages(selectedUser.id)
+            const response = await api.getPrivateMessages(selectedUser.id, 0, lastMessageId.current)
             if (response.success) {
-                setMessages(response.data)
+                appendMessages(response.data)
             }
         } catch (error) {
             console.error('Failed to load messages:', error)
         }
     }
 
+    const appendMessages = (newMessages) => {
+        if (newMessages.length === 0) return
+        lastMessageId.current = Math.max(lastMessageId.current, newMessages[newMessages.length - 1].id)
+        setMessages(prev => {
+            // Pushed events and refetches may deliver the same message twice
+            const lastId = prev.length > 0 ? prev[prev.length - 1].id : 0
+            return [...prev, ...newMessages.filter(m => m.id > lastId)]
+        })
+    }
+
     const handleSendMessage = async (e) => {
         e.preventDefault()
         if (!newMessage.trim() || !selectedUser) return
 
         setLoading(true)
         try {
-            await api.sendPrivateMessage(selectedUser.id, newMessage)
+            const fields = { targetUserId: selectedUser.id, content: newMessage }
+            if (!api.sendRealtime('private', fields)) {
+                await api.sendPrivateMessage(selectedUser.id, newMessage)
+                await loadMessages()
+            }
             setNewMessage('')
-            await loadMessages()
         } catch (error) {
             console.error('Failed to send message:', error)
         } finally {
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Load shedding shared by the TCP and HTTP servers.
+ *
+ * Work is admitted while fewer than maxInFlight items are queued or
+ * running. Lower priorities may only fill part of that budget, so as load
+ * grows bulk listings are refused first, then ordinary updates, and logins
+ * and chat last. Admitted work that then waited longer than maxQueueWait
+ * before starting is refused too (except HIGH), since its client has
+ * probably given up. A refusal costs the client a short "busy, retry
+ * after" answer instead of a place in a queue.
+ *
+ * Thread-safe; every counter is atomic.
+ */
+class AdmissionControl {
+public:
+  enum class Priority { HIGH, NORMAL, LOW };
+
+  struct Limits {
+    size_t maxInFlight = 4096;                    // 0 = no limit
+    std::chrono::milliseconds maxQueueWait{5000}; // 0 = no limit
+    unsigned retryAfterSeconds = 1;               // suggested to refused clients
+  };
+
+  struct Stats {
+    uint64_t inFlight;
+    uint64_t admitted;
+    uint64_t shed;    // refused on arrival
+    uint64_t expired; // refused after waiting too long
+  };
+
+  explicit AdmissionControl(Limits l);
+
+  /**
+   * Reserve room for one item of work
+   * @param priority Decides how much of the budget it may use
+   * @return false if it should be refused; nothing to release then
+   */
+  bool tryAdmit(Priority priority);
+
+  // Give back what tryAdmit reserved, once the work is done or refused
+  void release();
+
+  /**
+   * Check an admitted item as it starts; counts it if too old
+   * @param queuedAt When it was admitted
+   * @param priority HIGH never expires
+   * @return true if it should be refused (the caller still releases it)
+   */
+  bool expired(std::chrono::steady_clock::time_point queuedAt,
+               Priority priority);
+
+  unsigned retryAfter() const { return limits.retryAfterSeconds; }
+  Stats stats() const;
+
+private:
+  Limits limits;
+  std::atomic<size_t> inFlight;
+  std::atomic<uint64_t> admitted;
+  std::atomic<uint64_t> shed;
+  std::atomic<uint64_t> expiredCount;
+
+  // How much of maxInFlight a priority may fill; at least one
+  size_t budget(Priority priority) const;
+};
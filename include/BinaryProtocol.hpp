@@ -0,0 +1,130 @@
+#pragma once
+#include "Chat.hpp"
+#include "Task.hpp"
+#include "TaskManager.hpp"
+#include "User.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Appends message fields: unsigned integers as varints, signed ones as
+ * zigzag varints (so -1 takes one byte), strings as a varint length and
+ * the bytes.
+ */
+class BinaryWriter {
+public:
+  explicit BinaryWriter(std::string &out) : out(out) {}
+
+  void writeByte(uint8_t value) { out += static_cast<char>(value); }
+  void writeVarint(uint64_t value);
+  void writeSigned(int64_t value);
+  void writeString(const std::string &value);
+
+private:
+  std::string &out;
+};
+
+/**
+ * Reads fields written by BinaryWriter. Reads fail once the message is
+ * exhausted or malformed, and every read after that fails too.
+ */
+class BinaryReader {
+public:
+  explicit BinaryReader(const std::string &message)
+      : data(message.data()), size(message.size()) {}
+
+  bool readByte(uint8_t &value);
+  bool readVarint(uint64_t &value);
+  bool readSigned(int64_t &value);
+  bool readInt(int &value); // a signed field that must fit an int
+  bool readString(std::string &value);
+
+  bool ok() const { return !failed; }
+  bool atEnd() const { return offset >= size; } // for optional fields
+
+private:
+  const char *data;
+  size_t size;
+  size_t offset = 0;
+  bool failed = false;
+};
+
+/**
+ * Compact binary alternative to the TCP text protocol, for automation
+ * clients that would otherwise scrape the human-readable replies.
+ *
+ * Negotiation: a connection starts in text mode. If the first frame a
+ * client sends is "PROTOCOL BINARY <version>", naming the highest version
+ * it speaks, everything it sends after that line is length-prefixed
+ * binary. The server answers with the line "PROTOCOL BINARY <version>"
+ * carrying the version in use, after any text already queued (such as the
+ * welcome), and sends binary frames from then on.
+ *
+ * Every binary frame holds one message: a Type byte and its fields.
+ * Replies without a typed form travel as TEXT, so nothing a text client
+ * can see is lost. A COMMAND that carries a request id is answered by
+ * exactly one REPLY with that id, wrapping whatever the command said
+ * (possibly nothing), so a client can pipeline commands and match the
+ * answers.
+ */
+class BinaryProtocol {
+public:
+  static constexpr unsigned VERSION = 1;
+
+  enum class Type : uint8_t {
+    COMMAND = 1,   // client: command line, e.g. "/list"; optionally a
+                   // request id after it
+    TEXT = 2,      // text reply
+    TASK_LIST = 3, // count, then that many tasks
+    TASK = 4,      // change, task
+    CHAT = 5,      // chat or private message
+    PRESENCE = 6,  // user id, username, role, online
+    EVENT = 7,     // any other event: type name, JSON data
+    PING = 8,      // server: heartbeat, no fields
+    PONG = 9,      // client: answer to PING, no fields
+    REPLY = 10,    // request id, count, then that many messages, each
+                   // as a string: everything a tagged command answered
+    TASKS = 11,    // change, count, then that many tasks: one bulk change
+  };
+
+  /**
+   * Recognize the negotiation line
+   * @param frame First frame of a connection
+   * @param version Set to the version both sides speak
+   * @return false if frame is not a negotiation request
+   */
+  static bool parseUpgrade(const std::string &frame, unsigned &version);
+  // The negotiation line, sent by the client and echoed by the server
+  static std::string upgradeLine(unsigned version = VERSION);
+
+  // Encoders: each returns one message, without the length prefix
+  static std::string command(const std::string &command,
+                             const std::string &requestId = "");
+  static std::string text(const std::string &text);
+  static std::string ping();
+  static std::string pong();
+  static std::string reply(const std::string &requestId,
+                           const std::vector<std::string> &messages);
+  static std::string taskList(const std::vector<Task> &tasks);
+  static std::string taskChange(const Task &task, TaskChange change);
+  static std::string taskChanges(const std::vector<Task> &tasks,
+                                 TaskChange change);
+  static std::string chat(const Chat &chat);
+  static std::string presence(const std::string &username, const User &user);
+  static std::string event(const std::string &type, const std::string &data);
+
+  /**
+   * Read a message's type and position the reader on its fields
+   * @return false if the message is empty
+   */
+  static bool readType(BinaryReader &reader, Type &type);
+
+  // Decoders for the fields after the type byte; false if malformed
+  static bool readTask(BinaryReader &reader, Task &task);
+  static bool readChat(BinaryReader &reader, Chat &chat);
+  static bool readPresence(BinaryReader &reader, User &user);
+
+private:
+  static void writeTask(BinaryWriter &writer, const Task &task);
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Fixed-capacity lock-free queue, safe for any number of producers and
+ * consumers. Each slot carries a sequence number that tells producers and
+ * consumers whose turn it is, so push and pop are a single compare-and-swap
+ * on the shared position plus a write to the slot; neither side ever waits
+ * for the other. tryPush fails instead of blocking when the queue is full.
+ */
+template <typename T> class BoundedQueue {
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  size_t mask; // capacity - 1, capacity is a power of two
+  alignas(64) std::atomic<size_t> enqueuePos;
+  alignas(64) std::atomic<size_t> dequeuePos;
+
+  static size_t roundUpPow2(size_t n) {
+    size_t size = 2;
+    while (size < n) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+public:
+  explicit BoundedQueue(size_t capacity)
+      : cells(new Cell[roundUpPow2(capacity)]),
+        mask(roundUpPow2(capacity) - 1), enqueuePos(0), dequeuePos(0) {
+    for (size_t i = 0; i <= mask; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /**
+   * Append a value
+   * @return false if the queue is full (value is left untouched)
+   */
+  bool tryPush(const T &value) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells[pos & mask];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Remove the oldest value
+   * @return false if the queue is empty
+   */
+  bool tryPop(T &out) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells[pos & mask];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+          out = std::move(cell.value);
+          cell.value = T();
+          cell.sequence.store(pos + mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Approximate: exact only while no push or pop is in flight
+  size_t size() const {
+    size_t head = dequeuePos.load(std::memory_order_acquire);
+    size_t tail = enqueuePos.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t capacity() const { return mask + 1; }
+};
@@ -29,8 +29,8 @@ public:
     // Getters
     int getMessageId() const { return messageId; }
     int getSenderId() const { return senderId; }
-    std::string getSenderName() const { return senderName; }
-    std::string getContent() const { return content; }
+    const std::string& getSenderName() const { return senderName; }
+    const std::string& getContent() const { return content; }
     MessageType getType() const { return type; }
     int getTargetUserId() const { return targetUserId; }
     int getRelatedTaskId() const { return relatedTaskId; }
@@ -1,16 +1,48 @@
 #pragma once
 #include "Chat.hpp"
+#include "RingBuffer.hpp"
 #include "User.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <vector>
 #include <map>
-#include <mutex>
+#include <shared_mutex>
+
+// Public channels with their own recent-history buffer (private messages
+// are served from the conversation index instead)
+enum class ChatChannel {
+    TEAM,
+    SYSTEM,
+    TASK_UPDATES
+};
 
 class ChatManager {
+public:
+    static constexpr size_t CHANNEL_HISTORY_SIZE = 500; // messages kept per channel
+
 private:
     std::vector<Chat> messages;
     std::map<int, std::vector<int>> userConnections; // user -> socket IDs
+    std::map<std::pair<int, int>, std::vector<int>> conversationIndex; // (lower userId, higher userId) -> message IDs
+    std::map<int, std::vector<int>> taskMessageIndex; // taskId -> message IDs
+    RingBuffer<int> teamChannel;   // recent GENERAL message IDs
+    RingBuffer<int> systemChannel; // recent SYSTEM message IDs
+    RingBuffer<int> taskChannel;   // recent TASK_UPDATE message IDs
+    int firstMessageId; // ID of messages[0]; IDs are assigned sequentially
     int nextMessageId;
-    mutable std::mutex chatMutex;
+    mutable std::shared_mutex chatMutex;
+    mutable std::condition_variable_any messageArrived; // signalled on every new message
+    std::function<void(const Chat&)> messageListener;   // invoked under chatMutex
+
+    // Internal helpers - caller must hold chatMutex exclusively
+    int storeMessage(Chat& message);
+    const Chat& messageById(int messageId) const;
+    static std::pair<int, int> conversationKey(int userId1, int userId2);
+    const RingBuffer<int>& channelBuffer(ChatChannel channel) const;
+    static MessageType channelType(ChatChannel channel);
+    static void selectPage(const int*& first, const int*& last, size_t limit, int afterId);
+    std::vector<Chat> collect(const std::vector<int>& ids, size_t limit, int afterId) const;
 
 public:
     ChatManager();
@@ -24,9 +56,23 @@ public:
     // Query operations
     std::vector<Chat> getAllMessages() const;
     std::vector<Chat> getRecentMessages(int limit = 50) const;
+    std::vector<Chat> getRecentMessages(ChatChannel channel, size_t limit) const;
+    // Visits channel messages (oldest first) in place, under a shared lock;
+    // limit and afterId page like the reads below. An afterId older than
+    // the channel buffer is resumed from the full message log, so the page
+    // has no gap.
+    void visitRecentMessages(ChatChannel channel, size_t limit, const std::function<void(const Chat&)>& visitor, int afterId = 0) const;
     std::vector<Chat> getMessagesByUser(int userId) const;
-    std::vector<Chat> getTaskMessages(int taskId) const;
-    std::vector<Chat> getPrivateMessages(int userId1, int userId2) const;
+    // Paged reads: without afterId the newest `limit` messages, with afterId
+    // the first `limit` messages whose ID is greater (limit 0 = no limit)
+    std::vector<Chat> getTaskMessages(int taskId, size_t limit = 0, int afterId = 0) const;
+    std::vector<Chat> getPrivateMessages(int userId1, int userId2, size_t limit = 0, int afterId = 0) const;
+    int getLatestMessageId() const;
+    
+    // Blocks until a message with ID > afterId exists or the deadline passes
+    bool waitForMessage(int afterId, std::chrono::steady_clock::time_point deadline) const;
+    // Called with every stored message; must not call back into ChatManager
+    void setMessageListener(std::function<void(const Chat&)> listener);
     
     // Connection management
     void addUserConnection(int userId, int socketId);
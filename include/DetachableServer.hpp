@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SocketAbstraction.hpp"
+#include "httplib.h"
+#include <functional>
+#include <string>
+
+/**
+ * httplib::Server whose handlers can take their connection away from it.
+ *
+ * httplib serves a connection on one pool thread from accept to close, so
+ * a request that waits for something (a long poll, an event stream) would
+ * hold that thread for as long as it waits. A handler that calls detach()
+ * instead gets the socket once httplib has read the request: the response
+ * httplib would send is discarded, the keep-alive loop ends, and the
+ * socket is left open for the receiver, which then owns it. Bytes the
+ * client pipelined after the request are lost, as they are in httplib.
+ */
+class DetachableServer : public httplib::Server {
+public:
+  using Receiver = std::function<void(SocketHandle socket)>;
+
+  // httplib listens with a backlog of 5, too few for a burst of re-polls
+  static constexpr int LISTEN_BACKLOG = 512;
+
+  // As httplib::Server::listen, with LISTEN_BACKLOG
+  bool listen(const std::string &host, int port);
+
+  /**
+   * From inside a handler: hand this request's connection to receiver
+   * @param receiver Runs on the same thread after the handler returns
+   */
+  static void detach(Receiver receiver);
+
+  /**
+   * Serve a connection's next requests, e.g. one a receiver has finished
+   * with. Runs until the connection closes, so call it from a pool thread.
+   */
+  void serve(SocketHandle socket) { process_and_close_socket(socket); }
+
+private:
+  bool process_and_close_socket(socket_t sock) override;
+};
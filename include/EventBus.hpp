@@ -0,0 +1,100 @@
+#pragma once
+#include "BinaryProtocol.hpp"
+#include "ChatManager.hpp"
+#include "PubSub.hpp"
+#include "TaskManager.hpp"
+#include "UserManager.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * In-process event bus between the managers and every transport.
+ *
+ * Every TaskManager, ChatManager and UserManager change is queued by its
+ * listener, which only copies the changed object while the manager holds
+ * its lock. A dispatcher thread drains whatever has accumulated as one
+ * batch. It encodes each event once per wire format (TCP text line, TCP
+ * binary message, SSE frame, WebSocket frame) and fans the batch out
+ * through PubSub. Each subscriber is woken once per batch, and the TCP and
+ * WebSocket transports write the encoded bytes from the shared message
+ * without copying them.
+ *
+ * Changes therefore reach TCP, SSE and WebSocket clients alike, whichever
+ * transport caused them. A bulk task operation becomes a single "tasks"
+ * event whose data is the array of changed tasks.
+ */
+class EventBus {
+public:
+  // Builds one wire format from a message's type, data and seq
+  using Encoder = std::function<std::string(const PubSubMessage &)>;
+
+private:
+  struct PendingEvent {
+    std::vector<std::string> topics;
+    // Fills type, data, actorId and the TEXT and BINARY encodings
+    std::function<void(PubSubMessage &)> render;
+  };
+
+  TaskManager &taskManager;
+  ChatManager &chatManager;
+  UserManager &userManager;
+  PubSub &pubSub;
+
+  std::mutex queueMutex;
+  std::condition_variable queueReady;
+  std::vector<PendingEvent> pending;                 // guarded by queueMutex
+  std::array<Encoder, WIRE_FORMATS> encoders;        // guarded by queueMutex
+  bool running;                                      // guarded by queueMutex
+  std::thread dispatcher;
+  std::atomic<uint64_t> lastSeq;
+
+  void post(PendingEvent event);
+  void dispatchLoop();
+
+  // TCP text lines; empty when CLI clients do not show the event
+  static std::string describeTaskChange(const Task &task, TaskChange change);
+  static std::string describeTaskChanges(const std::vector<Task> &tasks,
+                                         TaskChange change);
+  static std::string describeMessage(const Chat &chat);
+  static std::string describePresence(const std::string &username,
+                                      const User &user);
+
+public:
+  EventBus(TaskManager &tm, ChatManager &cm, UserManager &um, PubSub &ps);
+  ~EventBus();
+
+  /**
+   * Attach to the managers and start the dispatcher thread
+   */
+  void start();
+
+  /**
+   * Detach from the managers, deliver what is still queued and stop
+   */
+  void stop();
+
+  /**
+   * Register the encoder for a wire format (SSE, WEBSOCKET); nullptr
+   * removes it. TEXT and BINARY are produced by the bus itself.
+   */
+  void setEncoder(Wire format, Encoder encoder);
+
+  /**
+   * Queue an event that does not come from a manager (e.g. typing)
+   * @param topics Topics to publish to
+   * @param type Event type
+   * @param data JSON payload
+   * @param actorId User who caused the event
+   */
+  void publish(std::vector<std::string> topics, const std::string &type,
+               const std::string &data, int actorId = -1);
+
+  uint64_t getLatestSeq() const { return lastSeq.load(); }
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "OutboundQueue.hpp"
+#include "SocketAbstraction.hpp"
+#include "TimingWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One event-loop thread for connections that spend most of their life
+ * waiting: parked long polls, event streams and WebSockets. Each watched
+ * socket is non-blocking and has a callback that runs on the loop thread
+ * when the EventPoller reports it readable or writable; deadlines live in
+ * a TimingWheel; other threads hand work over with post(). A connection
+ * therefore costs a table entry and a timer instead of a thread.
+ *
+ * Everything except start(), stop() and post() belongs to the loop
+ * thread: call it from a socket callback, a timer or a posted function.
+ */
+class EventLoop {
+public:
+  using SocketCallback = std::function<void(bool readable, bool writable)>;
+
+  static constexpr std::chrono::milliseconds TIMER_TICK{100};
+
+  EventLoop() = default;
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  /**
+   * Start the loop thread
+   * @param name Used in error messages
+   * @return false if the poller could not be created
+   */
+  bool start(const std::string &name);
+
+  /**
+   * Stop and join the loop thread. Work posted before the call still
+   * runs, so owners close their sockets in a posted function first; work
+   * posted afterwards never does.
+   */
+  void stop();
+
+  // Run task on the loop thread; callable from any thread
+  void post(std::function<void()> task);
+
+  /**
+   * Watch a non-blocking socket; the loop does not own or close it
+   * @param callback Runs on every readiness change until unwatch()
+   * @return false if the poller refused the socket
+   */
+  bool watch(SocketHandle socket, SocketCallback callback);
+  void unwatch(SocketHandle socket); // before closing the socket
+
+  // Ask for writable events while output is pending (needed off Linux)
+  void setWriteInterest(SocketHandle socket, bool enabled);
+
+  TimingWheel &timers() { return wheel; }
+
+  // Time as of the current loop iteration
+  std::chrono::steady_clock::time_point now() const { return loopTime; }
+
+  size_t watchedCount() const { return sockets.size(); }
+
+  /**
+   * Write as much of batch as the socket takes without blocking
+   * @return false if the connection failed; batch is then cleared
+   */
+  static bool send(SocketHandle socket, WriteBatch &batch);
+
+private:
+  EventPoller poller;
+  TimingWheel wheel{TIMER_TICK};
+  std::chrono::steady_clock::time_point loopTime =
+      std::chrono::steady_clock::now();
+  // Shared so a callback may unwatch its own socket while it runs
+  std::unordered_map<SocketHandle, std::shared_ptr<SocketCallback>> sockets;
+
+  std::mutex postedMutex;
+  std::vector<std::function<void()>> posted; // guarded by postedMutex
+
+  std::atomic<bool> running{false};
+  std::thread thread;
+  std::string loopName;
+
+  void run();
+  int waitTimeout() const;
+};
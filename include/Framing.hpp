@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Line framing for the CLI TCP protocol.
+ *
+ * Every command and every message is one frame: a line ending in '\n'.
+ * Backslashes, newlines and carriage returns inside it are escaped as
+ * "\\\\", "\\n" and "\\r", so a multi-line reply such as /list stays one
+ * frame. A bare '\r' before the '\n' is dropped, which lets telnet and nc
+ * be used by hand.
+ *
+ * Connections that negotiate the binary protocol (see BinaryProtocol)
+ * switch to length-prefixed frames: a varint byte count, then the message.
+ *
+ * Heartbeat: the server sends the line PING to a client that has been
+ * silent for a while, and closes the connection if nothing comes back in
+ * time. Clients answer PONG, which is not a command; any other input
+ * proves liveness just as well, so an empty line will do by hand.
+ */
+class Framing {
+public:
+  static constexpr const char *PING = "PING";
+  static constexpr const char *PONG = "PONG";
+
+  /**
+   * Append payload to out as one frame
+   * @param out Output buffer
+   * @param payload Message to frame
+   */
+  static void encode(std::string &out, const std::string &payload);
+
+  static std::string encode(const std::string &payload);
+
+  /**
+   * Append payload to out as one length-prefixed frame
+   * @param out Output buffer
+   * @param payload Encoded binary message
+   */
+  static void encodeBinary(std::string &out, const std::string &payload);
+
+  // Base-128 varint, low bits first: values below 128 take one byte
+  static void putVarint(std::string &out, uint64_t value);
+
+  /**
+   * Decode a varint
+   * @param data Bytes to read from
+   * @param length Bytes available
+   * @param value Decoded value
+   * @return Bytes consumed; 0 if data ends first or the value does not fit
+   *         in a uint64_t
+   */
+  static size_t getVarint(const char *data, size_t length, uint64_t &value);
+
+  static constexpr size_t MAX_VARINT_SIZE = 10;
+};
+
+/**
+ * Growable receive buffer that turns a byte stream into frames. A read may
+ * carry part of a frame or many pipelined frames; complete ones come out
+ * of next() in order and the rest waits for more data.
+ */
+class FrameReader {
+public:
+  enum class Mode { LINES, LENGTH_PREFIXED };
+
+  // Longest frame accepted before the stream is treated as garbage
+  static constexpr size_t MAX_FRAME_SIZE = 1024 * 1024;
+
+  /**
+   * Add received bytes
+   * @param data Received bytes
+   * @param length Number of bytes
+   */
+  void append(const char *data, size_t length);
+
+  /**
+   * Take the next complete frame, unescaped in LINES mode
+   * @param frame Filled with the payload
+   * @return false if no complete frame is buffered
+   */
+  bool next(std::string &frame);
+
+  /**
+   * @return true once a frame exceeds MAX_FRAME_SIZE or its length prefix
+   *         is malformed
+   */
+  bool overflowed() const;
+
+  /**
+   * Parse the bytes after the current frame differently, e.g. once the
+   * connection has negotiated the binary protocol
+   */
+  void setMode(Mode m);
+  Mode getMode() const { return mode; }
+
+private:
+  Mode mode = Mode::LINES;
+  bool invalid = false; // bad length prefix
+  std::string buffer;
+  size_t start = 0; // first byte not yet returned
+  size_t scan = 0;  // bytes from start already searched for '\n'
+
+  bool nextLine(std::string &frame);
+  bool nextPrefixed(std::string &frame);
+  void consume(size_t length);
+};
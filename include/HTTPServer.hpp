@@ -1,12 +1,26 @@
 #pragma once
 
+#include "AdmissionControl.hpp"
 #include "ChatManager.hpp"
+#include "DetachableServer.hpp"
+#include "EventBus.hpp"
+#include "HTTPStreams.hpp"
+#include "JsonReader.hpp"
+#include "PubSub.hpp"
 #include "TaskManager.hpp"
+#include "TimingWheel.hpp"
 #include "User.hpp"
+#include "UserManager.hpp"
+#include "WebSocketServer.hpp"
 #include "httplib.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -14,21 +28,71 @@
  * Runs alongside the TCP socket server on port 8081
  */
 class HTTPServer {
+public:
+  // Long polling: a request with nothing to report yet is detached from
+  // httplib's worker pool and parked on the HTTPStreams event loop, where
+  // it holds a socket and a timer but no thread. The cap bounds file
+  // descriptors; over it a long poll answers at once like a plain poll.
+  static constexpr int HTTP_WORKER_THREADS = 64;
+  static constexpr size_t MAX_PARKED_REQUESTS = 10000;
+  static constexpr int LONG_POLL_TIMEOUT_SECONDS = 25;
+  // Server-Sent Events: streams live on the same loop, so their cap too
+  // only bounds file descriptors
+  static constexpr size_t MAX_EVENT_STREAMS = 10000;
+  static constexpr int EVENT_HEARTBEAT_SECONDS = 15;
+  // Load shedding: ordinary requests running at once. Long polls and event
+  // streams have their caps above and are not counted.
+  static constexpr size_t DEFAULT_MAX_IN_FLIGHT = HTTP_WORKER_THREADS;
+  // Sessions end after this long without a request using their token
+  static constexpr int SESSION_TIMEOUT_SECONDS = 30 * 60;
+  // Tasks one POST /api/tasks/bulk may touch
+  static constexpr size_t MAX_BULK_TASKS = 10000;
+  // Operations one POST /api/batch may carry
+  static constexpr size_t MAX_BATCH_OPERATIONS = 100;
+
 private:
-  httplib::Server server;
+  DetachableServer server;
   TaskManager &taskManager;
   ChatManager &chatManager;
-  std::map<std::string, User> &users;
-  std::mutex &serverMutex;
+  UserManager &userManager;
+  PubSub &pubSub;
+  EventBus &eventBus;
 
   // Session management
-  std::map<std::string, std::string> sessions; // token -> username
+  struct Session {
+    std::string username;
+    std::chrono::steady_clock::time_point lastUsed;
+    TimingWheel::TimerId expiry = 0;
+  };
+  std::unordered_map<std::string, Session> sessions; // token -> session
   std::mutex sessionMutex;
+  // Expiry, all guarded by sessionMutex: each session has one timer, which
+  // re-arms from lastUsed when it fires, so a request only stamps the
+  // session. One thread sleeps until the wheel's next deadline.
+  std::chrono::seconds sessionTimeout{SESSION_TIMEOUT_SECONDS};
+  TimingWheel sessionTimers{std::chrono::seconds(1)};
+  std::vector<std::string> expiredUsers; // set offline outside the lock
+  std::condition_variable sessionsChanged;
+  bool stoppingReaper = false;
+  std::thread sessionReaper;
+
+  // httplib's pool, for connections handed back after a long poll
+  std::atomic<httplib::TaskQueue *> workers{nullptr};
+  HTTPStreams streams; // parked long polls and SSE streams
+
+  WebSocketServer webSocketServer; // same events plus chat send and typing
+  AdmissionControl admission;
+
+  std::function<std::string()> connectionStats; // JSON object, optional
 
   // Helper methods
   std::string generateToken(const std::string &username);
   bool validateToken(const std::string &token, std::string &username);
   std::string getUsernameFromToken(const std::string &token);
+  void addSession(const std::string &token, const std::string &username);
+  void removeSession(const std::string &token);
+  void expireSession(const std::string &token); // caller holds sessionMutex
+  void reapSessions();
 
   // Helper function to escape JSON strings
   std::string escapeJSON(const std::string &str);
@@ -40,13 +104,68 @@ private:
   std::string chatsToJSON(const std::vector<Chat> &chats);
   std::string userToJSON(const User &user, const std::string &username);
   std::string usersToJSON(const std::map<std::string, User> &users);
+  std::string channelToJSON(ChatChannel channel, size_t limit, int afterId,
+                            size_t &count);
   std::string errorJSON(const std::string &message);
+  // Parse a JSON object request body; on failure the error reply is set
+  bool parseBody(const httplib::Request &req, httplib::Response &res,
+                 JsonValue &body);
   std::string successJSON(const std::string &message,
                           const std::string &data = "");
+  std::string successJSON(const std::string &message, const std::string &data,
+                          uint64_t version);
+  // Task listings are written straight into the response, not copied in
+  std::string successJSON(const std::string &message,
+                          const std::vector<Task> &tasks);
+  std::string successJSON(const std::string &message,
+                          const std::vector<Task> &tasks, uint64_t version);
+
+  /**
+   * Non-negative integer query parameter, clamped to max
+   * @param fallback Value when the parameter is absent
+   * @return false, with a 400 reply set, if it is malformed or negative
+   */
+  bool queryParam(const httplib::Request &req, httplib::Response &res,
+                  const std::string &name, long long fallback, long long max,
+                  long long &value);
+  static ChatChannel parseChannel(const std::string &name);
+  // Admission priority of a request; false for long polls and streams,
+  // which are not subject to it
+  static bool requestPriority(const httplib::Request &req,
+                              AdmissionControl::Priority &priority);
+  // Refuse requests over the admission limits with 503 and Retry-After
+  void setupAdmission();
+  bool longPollDeadline(const httplib::Request &req, httplib::Response &res,
+                        std::chrono::steady_clock::time_point &deadline);
+  // Detach the request's connection and park it until respond has an
+  // answer or the deadline passes; key names what the answer depends on
+  void parkLongPoll(const httplib::Request &req, const std::string &topic,
+                    const std::string &key,
+                    std::chrono::steady_clock::time_point deadline,
+                    HTTPStreams::Responder respond);
+  void resumeConnection(SocketHandle socket);
 
 public:
-  HTTPServer(TaskManager &tm, ChatManager &cm, std::map<std::string, User> &u,
-             std::mutex &m);
+  /**
+   * @param admissionLimits In-flight and queue-wait limits for requests
+   */
+  HTTPServer(TaskManager &tm, ChatManager &cm, UserManager &um, PubSub &ps,
+             EventBus &bus, AdmissionControl::Limits admissionLimits);
+  ~HTTPServer();
+
+  /**
+   * Report another transport's connection metrics under "connections" in
+   * GET /api/stats
+   * @param stats Returns a JSON object; called per request
+   */
+  void setConnectionStats(std::function<std::string()> stats);
+
+  /**
+   * Idle time after which a login token stops working and its user is
+   * shown offline; applies to sessions created from then on
+   * @param timeout 0 keeps sessions until logout
+   */
+  void setSessionTimeout(std::chrono::seconds timeout);
 
   /**
    * Setup all API routes
@@ -59,6 +178,13 @@ public:
    */
   void start(int port = 8081);
 
+  /**
+   * Start the WebSocket server on its own port (non-blocking)
+   * @param port Port to listen on (default: 8082)
+   * @return true on success, false on failure
+   */
+  bool startWebSocket(int port = WebSocketServer::DEFAULT_PORT);
+
   /**
    * Stop the HTTP server
    */
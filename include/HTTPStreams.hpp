@@ -0,0 +1,157 @@
+#pragma once
+
+#include "EventLoop.hpp"
+#include "OutboundQueue.hpp"
+#include "PubSub.hpp"
+#include "SocketAbstraction.hpp"
+#include "TimingWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * HTTP requests that wait for something to happen, served from one
+ * EventLoop instead of a thread each.
+ *
+ * A long poll is parked here once its handler has found nothing to report
+ * and detached the connection from httplib (see DetachableServer). The
+ * loop holds the socket, a timer for the deadline and the callback that
+ * builds the answer. Events published to the topic the poll waits on
+ * re-run that callback, once per key: polls waiting for the same thing
+ * (e.g. tasks changed since one version) share the body it builds. When
+ * there is an answer, or the deadline passes, the response is written
+ * without blocking. A keep-alive connection then
+ * stays on the loop until its next request arrives, and only that goes
+ * back to httplib; one left idle past httplib's keep-alive timeout is
+ * closed.
+ *
+ * A Server-Sent Events stream is detached the same way and stays here until
+ * the client goes away. Its subscription's notifier wakes the loop, which
+ * takes queued events only once the previous write has drained: a reader
+ * that falls behind backs up into its bounded queue, loses what overflows
+ * and is sent "event: resync" to refetch. A comment line goes out after a
+ * quiet heartbeat interval so proxies keep the stream open and vanished
+ * peers are noticed.
+ */
+class HTTPStreams {
+public:
+  /**
+   * Builds a long poll's JSON answer
+   * @param final true at the deadline, when an answer is required
+   * @param body Set to the response body
+   * @return false if there is nothing to report yet
+   */
+  using Responder = std::function<bool(bool final, std::string &body)>;
+  // Takes back a connection whose next request is waiting to be read
+  using Resume = std::function<void(SocketHandle socket)>;
+
+  /**
+   * @param headers Extra response header lines, each ending in "\r\n"
+   * @param resume Serves a keep-alive connection's next requests
+   */
+  HTTPStreams(PubSub &ps, std::string headers, Resume resume);
+  ~HTTPStreams();
+
+  bool start();
+  void stop(); // closes every parked connection and event stream
+
+  /**
+   * Take over a detached long poll; callable from any thread
+   * @param socket Connection, with its request already read
+   * @param topic PubSub topic whose events may change the answer
+   * @param key What respond depends on; polls with equal keys and topics
+   *            get one shared answer per wakeup
+   * @param deadline When to answer regardless
+   * @param keepAlive Whether the client keeps the connection open
+   * @param respond Builds the answer; runs on the loop thread
+   */
+  void park(SocketHandle socket, const std::string &topic,
+            const std::string &key,
+            std::chrono::steady_clock::time_point deadline, bool keepAlive,
+            Responder respond);
+
+  size_t parkedCount() const { return parked.load(); }
+
+  /**
+   * Take over a detached event-stream request; callable from any thread
+   * @param socket Connection, with its request already read
+   * @param topics PubSub topics whose events the client receives
+   * @param heartbeat Longest silence before a keepalive comment
+   */
+  void streamEvents(SocketHandle socket, const std::vector<std::string> &topics,
+                    std::chrono::seconds heartbeat);
+
+  size_t eventStreamCount() const { return streaming.load(); }
+
+private:
+  struct LongPoll {
+    SocketHandle socket;
+    std::string topic;
+    std::string key;
+    bool keepAlive = true;
+    Responder respond;
+    TimingWheel::TimerId timer = 0;
+    bool answered = false;
+    WriteBatch output; // response not yet taken by the kernel
+    bool idle = false; // answered; waiting for the next keep-alive request
+  };
+  using LongPollPtr = std::shared_ptr<LongPoll>;
+
+  // A topic's subscription, shared by every poll waiting on it
+  struct Topic {
+    SubscriptionPtr subscription;
+    std::unordered_set<LongPollPtr> polls;
+    std::atomic<bool> wakePosted{false};
+  };
+
+  struct EventStream {
+    SocketHandle socket;
+    SubscriptionPtr subscription;
+    std::atomic<bool> wakePosted{false};
+    bool started = false; // watched by the loop
+    uint64_t dropped = 0; // subscription's count when last checked
+    std::chrono::seconds heartbeat{0};
+    TimingWheel::TimerId timer = 0;
+    // When events or a heartbeat were last queued
+    std::chrono::steady_clock::time_point lastSent;
+    WriteBatch output;
+  };
+  using EventStreamPtr = std::shared_ptr<EventStream>;
+
+  PubSub &pubSub;
+  std::string extraHeaders;
+  Resume resume;
+  EventLoop loop;
+  std::atomic<size_t> parked{0};
+  std::atomic<size_t> streaming{0};
+
+  // Loop thread only
+  std::unordered_set<LongPollPtr> polls; // every poll until finished
+  std::unordered_map<std::string, std::shared_ptr<Topic>> topics;
+  std::unordered_set<EventStreamPtr> eventStreams;
+
+  void startPoll(const LongPollPtr &poll);
+  void wake(const std::shared_ptr<Topic> &topic);
+  void check(const LongPollPtr &poll, bool final);
+  void answer(const LongPollPtr &poll,
+              const std::shared_ptr<const std::string> &body);
+  void stopWaiting(const LongPollPtr &poll);
+  void readFrom(const LongPollPtr &poll);
+  void writeTo(const LongPollPtr &poll);
+  void waitForNextRequest(const LongPollPtr &poll);
+  void finish(const LongPollPtr &poll, bool reuse);
+  void startStream(const EventStreamPtr &stream);
+  bool takeEvents(const EventStreamPtr &stream);
+  void pump(const EventStreamPtr &stream);
+  void scheduleHeartbeat(const EventStreamPtr &stream);
+  void drain(const EventStreamPtr &stream);
+  void closeStream(const EventStreamPtr &stream);
+  void closeAll();
+  std::shared_ptr<Topic> topic(const std::string &name);
+};
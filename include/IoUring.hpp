@@ -0,0 +1,130 @@
+#pragma once
+
+#include "SocketAbstraction.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// io_uring needs Linux and its uapi header; -DTASKMANAGER_NO_IO_URING (CMake
+// option USE_IO_URING=OFF) builds without it
+#if defined(__linux__) && !defined(TASKMANAGER_NO_IO_URING)
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TASKMANAGER_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+/**
+ * Completion-based socket IO on one io_uring instance, without liburing.
+ *
+ * Operations are only queued by the prepare*() calls. submitAndWait()
+ * submits everything queued since the last call and collects completions,
+ * all in one io_uring_enter, so a loop iteration costs one system call no
+ * matter how many sockets it reads and writes. Accept and receive are
+ * multishot: armed once, they keep completing until the socket ends.
+ * Receives land in a ring of buffers registered with the kernel up front,
+ * which the caller hands back with recycleBuffer().
+ *
+ * Like EventPoller, every method except wakeup() must be called from the
+ * thread that calls submitAndWait(). Where io_uring is unavailable (other
+ * platforms, old kernels, seccomp) isValid() is false.
+ */
+class IoUring {
+public:
+  struct Completion {
+    uint64_t userData;
+    int32_t result;    // bytes, accepted socket, or -errno
+    bool more;         // a multishot operation stays armed
+    int bufferId;      // registered buffer holding received data, or -1
+  };
+
+  static constexpr unsigned DEFAULT_ENTRIES = 256;
+  static constexpr unsigned BUFFER_COUNT = 256; // registered receive buffers
+
+  /**
+   * @param entries Submission queue size, a power of two
+   * @param bufferSize Size of each registered receive buffer
+   */
+  IoUring(unsigned entries, size_t bufferSize);
+  ~IoUring();
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  /**
+   * Check that the ring, its buffers and the kernel features it relies on
+   * (multishot accept/recv, buffer rings) are all available
+   * @return true if usable, false otherwise
+   */
+  bool isValid() const;
+
+  /**
+   * Queue a multishot accept; each connection completes with its socket
+   * @param listenSocket Listening socket handle
+   * @param userData Returned with every completion
+   */
+  void prepareAccept(SocketHandle listenSocket, uint64_t userData);
+
+  /**
+   * Queue a multishot receive into the registered buffers
+   * @param socket Connected socket handle
+   * @param userData Returned with every completion
+   */
+  void prepareReceive(SocketHandle socket, uint64_t userData);
+
+  /**
+   * Queue a vectored send (sendmsg); the message, its iovecs and the bytes
+   * they point to must stay valid until it completes
+   * @param socket Connected socket handle
+   * @param message msg_iov and msg_iovlen name the buffers
+   * @param userData Returned with the completion
+   */
+  void prepareSendMessage(SocketHandle socket, const struct msghdr *message,
+                          uint64_t userData);
+
+  /**
+   * Submit the queued operations and wait for completions
+   * @param completions Filled with what completed
+   * @param timeoutMs Maximum wait in milliseconds, -1 for no limit
+   * @return Number of completions, or -1 on error
+   */
+  int submitAndWait(std::vector<Completion> &completions, int timeoutMs);
+
+  /**
+   * @param bufferId Completion::bufferId of a receive
+   * @return Start of the received bytes
+   */
+  const char *buffer(int bufferId) const;
+
+  /**
+   * Give a receive buffer back to the kernel once its data is consumed
+   * @param bufferId Completion::bufferId of a receive
+   */
+  void recycleBuffer(int bufferId);
+
+  /**
+   * Interrupt a submitAndWait() in progress from any thread
+   */
+  void wakeup();
+
+  /**
+   * @return System calls made so far (io_uring_enter and wakeups)
+   */
+  uint64_t syscalls() const { return syscallCount.load(); }
+
+private:
+  struct Rings; // mmap'ed kernel queues
+
+  std::unique_ptr<Rings> rings;
+  std::atomic<bool> wakePending;
+  std::atomic<uint64_t> syscallCount;
+  int wakeFd;          // eventfd, read through the ring
+  uint64_t wakeValue;  // target of that read
+  size_t bufferSize;
+  std::vector<char> buffers;
+  unsigned queued; // prepared but not yet submitted
+
+  void *nextEntry(); // submits early when the queue is full
+  void prepareWakeRead();
+};
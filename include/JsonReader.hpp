@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+class JsonIterator;
+
+/**
+ * Read-only view of one value in a JSON document. It holds only a type and
+ * the value's text, so looking up members and walking arrays never copies
+ * or allocates; strings are unescaped only when read with get().
+ *
+ * Values come from JsonReader::parse(), which has validated the whole
+ * document, and stay valid as long as the text they point into.
+ */
+class JsonValue {
+public:
+  enum class Type { MISSING, NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+  JsonValue() = default;
+
+  Type type() const { return kind; }
+  bool isMissing() const { return kind == Type::MISSING; }
+  bool isObject() const { return kind == Type::OBJECT; }
+  bool isArray() const { return kind == Type::ARRAY; }
+  // Exact source text: strings keep their quotes and escapes
+  std::string_view text() const { return span; }
+
+  /**
+   * Member of an object (the first one, if a key repeats)
+   * @return A MISSING value if this is not an object or lacks the key
+   */
+  JsonValue operator[](std::string_view key) const;
+
+  // Typed reads: false, with out untouched, if the value is missing or
+  // of another type. Integers must be whole numbers that fit in an int.
+  bool get(std::string &out) const;
+  bool get(int &out) const;
+  bool get(bool &out) const;
+
+  // Like get(), but a missing or null value is accepted and leaves out
+  // as it was, so out can hold the default
+  template <typename T> bool getOptional(T &out) const {
+    return kind == Type::MISSING || kind == Type::NUL || get(out);
+  }
+
+  // Elements of an array; an empty range for anything else
+  JsonIterator begin() const;
+  JsonIterator end() const;
+  size_t size() const;
+
+private:
+  friend class JsonIterator;
+  friend class JsonReader;
+
+  Type kind = Type::MISSING;
+  std::string_view span;
+
+  JsonValue(Type type, std::string_view text) : kind(type), span(text) {}
+  // The value starting at position, in text that has been validated
+  static JsonValue at(const char *position, const char *limit);
+};
+
+// Forward iterator over the elements of an array value
+class JsonIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = JsonValue;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const JsonValue *;
+  using reference = const JsonValue &;
+
+  reference operator*() const { return current; }
+  pointer operator->() const { return &current; }
+  JsonIterator &operator++();
+  bool operator==(const JsonIterator &other) const {
+    return current.span.data() == other.current.span.data();
+  }
+  bool operator!=(const JsonIterator &other) const { return !(*this == other); }
+
+private:
+  friend class JsonValue;
+  JsonValue current; // MISSING, pointing at the closing ']', at the end
+  const char *limit = nullptr;
+  JsonIterator() = default;
+  JsonIterator(const char *position, const char *limit);
+};
+
+/**
+ * Validating JSON parser for request bodies. One pass checks the full
+ * grammar (strings and escapes, numbers, literals, nesting) without
+ * building anything; the result is a JsonValue over the original text.
+ */
+class JsonReader {
+public:
+  // Deeper documents are refused, which bounds the recursion
+  static constexpr int MAX_DEPTH = 64;
+
+  /**
+   * Validate text as exactly one JSON value, surrounded by optional
+   * whitespace
+   * @param text Document; must outlive root
+   * @param root Set to the top-level value on success
+   * @param error If given, set to a message with the byte offset on failure
+   * @return false if text is not valid JSON
+   */
+  static bool parse(std::string_view text, JsonValue &root,
+                    std::string *error = nullptr);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <type_traits>
+
+/**
+ * Append-only JSON writer over a caller-owned string, so a whole response
+ * is built in one buffer: no streams, and no intermediate string per
+ * object or escaped field. Commas between members and elements are placed
+ * automatically.
+ *
+ * Structure is not checked: callers close what they open, and every object
+ * member starts with key(). Keys are written as given, so they must be
+ * literals that need no escaping.
+ */
+class JsonWriter {
+public:
+  explicit JsonWriter(std::string &out) : out(out) {}
+
+  JsonWriter &beginObject();
+  JsonWriter &endObject();
+  JsonWriter &beginArray();
+  JsonWriter &endArray();
+  JsonWriter &key(const char *name);
+
+  JsonWriter &value(const std::string &text) {
+    return value(text.data(), text.size());
+  }
+  JsonWriter &value(const char *text);
+  JsonWriter &value(const char *text, size_t length);
+  JsonWriter &value(bool flag);
+  template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+  JsonWriter &value(T number) {
+    if (std::is_signed<T>::value) {
+      return writeSigned(static_cast<int64_t>(number));
+    }
+    return writeUnsigned(static_cast<uint64_t>(number));
+  }
+  JsonWriter &null();
+  // Already-encoded JSON, e.g. an object built elsewhere
+  JsonWriter &raw(const std::string &json);
+  // Local date as "YYYY-MM-DD"
+  JsonWriter &date(std::chrono::system_clock::time_point time);
+
+  template <typename T> JsonWriter &field(const char *name, const T &v) {
+    key(name);
+    return value(v);
+  }
+
+  /**
+   * Append text with JSON string escaping, without the quotes. Runs of
+   * bytes that need no escape are copied whole.
+   */
+  static void escape(std::string &out, const char *data, size_t length);
+
+private:
+  std::string &out;
+  bool separate = false; // a comma is due before the next value
+  // Tasks mostly share a few deadlines, so the last date is kept
+  std::time_t dateMinute = -1;
+  char dateText[10];
+
+  void comma() {
+    if (separate) {
+      out += ',';
+    }
+  }
+  JsonWriter &writeSigned(int64_t number);
+  JsonWriter &writeUnsigned(uint64_t number);
+};
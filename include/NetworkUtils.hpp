@@ -1,4 +1,6 @@
 #pragma once
+#include "AdmissionControl.hpp"
+#include "JsonWriter.hpp"
 #include <string>
 #include <vector>
 #include <map>
@@ -15,16 +17,25 @@ public:
     // Message formatting
     static std::string formatMessage(const std::string& type, const std::string& data);
     static std::pair<std::string, std::string> parseMessage(const std::string& message);
+    // The command in a TCP frame: binary COMMAND frames carry it as is, text
+    // frames as "CMD:<command>" or bare; false for other text message types
+    static bool parseCommand(const std::string& frame, bool binary, std::string& command);
     
     // JSON-like serialization
     static std::string serializeTask(const class Task& task);
     static std::string serializeChat(const class Chat& chat);
     static std::string serializeUser(const class User& user);
     
-    // Broadcasting
-    static void broadcastToAll(const std::vector<ClientInfo>& clients, const std::string& message);
-    static void broadcastToUsers(const std::vector<ClientInfo>& clients, const std::vector<int>& userIds, const std::string& message);
-    static void sendToUser(const std::vector<ClientInfo>& clients, int userId, const std::string& message);
+    // JSON objects shared by the HTTP API and the event streams
+    static std::string taskToJSON(const class Task& task);
+    static std::string chatToJSON(const class Chat& chat);
+    static std::string userToJSON(const class User& user, const std::string& username);
+    static std::string admissionToJSON(const AdmissionControl::Stats& stats);
+    // The same objects appended to a response being written
+    static void writeTask(JsonWriter& json, const class Task& task);
+    static void writeChat(JsonWriter& json, const class Chat& chat);
+    static void writeUser(JsonWriter& json, const class User& user, const std::string& username);
+    static void writeAdmission(JsonWriter& json, const AdmissionControl::Stats& stats);
     
     // Authentication
     static bool authenticateUser(const std::string& username, const std::string& password);
@@ -34,4 +45,9 @@ public:
     static std::string getCurrentTimestamp();
     static std::vector<std::string> splitString(const std::string& str, char delimiter);
     static std::string trim(const std::string& str);
+    static std::string escapeJSON(const std::string& str);
+    
+    // Encoding helpers (WebSocket handshake)
+    static std::string sha1(const std::string& data); // raw 20-byte digest
+    static std::string base64Encode(const std::string& data);
 };
\ No newline at end of file
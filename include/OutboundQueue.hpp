@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include "SocketAbstraction.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Encoded bytes shared by every queue they are sent from, never modified
+using SharedFrame = std::shared_ptr<const std::string>;
+
+/**
+ * Frames on their way to one socket, written with vectored sends straight
+ * from the shared buffers. Tracks how much of them the kernel has taken;
+ * a frame is released once it is sent in full.
+ */
+class WriteBatch {
+public:
+  // Frames handed to the kernel per vectored write, well under IOV_MAX;
+  // shared by every writer so they batch alike
+  static constexpr size_t MAX_FRAMES = 256;
+
+  void add(SharedFrame frame);
+
+  /**
+   * Drop what the kernel accepted
+   * @param sent Bytes written, at most bytes()
+   */
+  void consume(size_t sent);
+
+  void clear();
+
+  /**
+   * The unsent bytes, one slice per frame; valid until the batch changes
+   * @param count Set to the number of slices
+   */
+  const IoSlice *slices(size_t &count);
+
+  bool empty() const { return frames.empty(); }
+  size_t bytes() const { return remaining; }
+  size_t frameCount() const { return frames.size(); }
+
+private:
+  std::deque<SharedFrame> frames;
+  size_t offset = 0; // into the first frame
+  size_t remaining = 0;
+  std::vector<IoSlice> io;
+};
+
+/**
+ * A connection's frames waiting for the socket, bounded by a high-water
+ * mark in bytes. A consumer that falls behind the mark is handled by
+ * policy: its oldest frames are dropped (DROP_OLDEST, COALESCE) or it is
+ * disconnected (DISCONNECT). Under COALESCE a queued frame is also
+ * replaced by a newer one with the same key, so a backlog holds the latest
+ * state of each thing rather than every step. Frames already taken for
+ * writing are never dropped, so the peer never sees half a frame.
+ *
+ * Not thread-safe; the owner's lock guards it.
+ */
+class OutboundQueue {
+public:
+  enum class Policy { DROP_OLDEST, COALESCE, DISCONNECT };
+
+  struct Limits {
+    size_t highWater = 1024 * 1024; // queued bytes before the policy applies
+    Policy policy = Policy::DROP_OLDEST;
+  };
+
+  explicit OutboundQueue(Limits l) : limits(l) {}
+
+  /**
+   * Queue a frame, then apply the policy if the mark is passed
+   * @param frame Encoded bytes, possibly queued for other connections too
+   * @param key Frames sharing a non-empty key are successive states of one
+   *            thing (e.g. a task's status); COALESCE keeps the newest
+   * @return false if the mark was passed under DISCONNECT
+   */
+  bool push(SharedFrame frame, std::string key = "");
+
+  /**
+   * Move whole frames to out, oldest first, until out holds at least
+   * maxBytes or maxFrames, or the queue is empty
+   */
+  void take(WriteBatch &out, size_t maxBytes, size_t maxFrames);
+
+  void clear();
+
+  bool empty() const { return liveFrames == 0; }
+  size_t bytes() const { return queuedBytes; }
+  size_t depth() const { return liveFrames; }
+  uint64_t droppedCount() const { return dropped; }
+  uint64_t coalescedCount() const { return coalesced; }
+
+private:
+  struct Frame {
+    SharedFrame bytes;
+    std::string key;
+    uint64_t seq;
+  };
+  struct Newest {
+    uint64_t seq;
+    size_t size;
+  };
+
+  Limits limits;
+  // Superseded frames stay here until they reach the front, so replacing
+  // one costs a map update instead of a search; they are not counted in
+  // queuedBytes or liveFrames
+  std::deque<Frame> frames;
+  std::unordered_map<std::string, Newest> newest; // COALESCE only
+  uint64_t nextSeq = 0;
+  size_t queuedBytes = 0;
+  size_t liveFrames = 0;
+  uint64_t dropped = 0;
+  uint64_t coalesced = 0;
+
+  // Remove the front frame; false if it had been superseded
+  bool popFront(Frame &frame);
+};
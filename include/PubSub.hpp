@@ -0,0 +1,157 @@
+#pragma once
+#include "BoundedQueue.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Wire formats an event is encoded into once, before fan-out. Each holds
+// complete frames for its transport (TEXT and BINARY: TCP Framing), so
+// subscribers can write the bytes as they are.
+enum class Wire { TEXT, SSE, WEBSOCKET, BINARY };
+constexpr size_t WIRE_FORMATS = 4;
+
+// One published event, shared by every subscriber that receives it
+struct PubSubMessage {
+  uint64_t seq = 0;  // global publish order
+  std::string type;  // event name: task, chat, private, presence, typing
+  std::string data;  // JSON payload
+  int actorId = -1;  // user who caused the event, -1 if none
+  // Events with the same key are successive states of one thing, so a
+  // backed-up transport may keep only the newest; empty = always distinct
+  std::string key;
+  std::array<std::string, WIRE_FORMATS> encoded; // empty = not sent that way
+
+  const std::string &wire(Wire format) const {
+    return encoded[static_cast<size_t>(format)];
+  }
+};
+using PubSubMessagePtr = std::shared_ptr<const PubSubMessage>;
+
+// One wire format of a message as a buffer that keeps the message alive, so
+// a transport can queue it for a socket without copying the bytes
+inline std::shared_ptr<const std::string> wireBuffer(
+    const PubSubMessagePtr &message, Wire format) {
+  return std::shared_ptr<const std::string>(message, &message->wire(format));
+}
+
+/**
+ * A subscriber's inbox: a bounded lock-free queue filled by publishers and
+ * drained by the subscriber's own transport thread. When it is full new
+ * messages are dropped and counted, so a slow consumer only ever loses its
+ * own messages and never slows a publisher down.
+ */
+class Subscription {
+public:
+  Subscription(size_t capacity, std::function<void()> notifier);
+
+  bool tryPop(PubSubMessagePtr &out);
+
+  /**
+   * Pop the next message, waiting for one if the queue is empty
+   * @return false on timeout or once the subscription is closed and empty
+   */
+  bool waitPop(PubSubMessagePtr &out,
+               std::chrono::steady_clock::time_point deadline);
+
+  bool hasPending() const { return queue.size() > 0; }
+  uint64_t droppedCount() const { return dropped.load(); }
+  bool isClosed() const { return closed.load(); }
+
+  // Stop accepting messages and wake a waiting consumer
+  void close();
+
+private:
+  friend class PubSub;
+
+  // Called by publishers; never blocks. Returns false if dropped.
+  bool deliver(const PubSubMessagePtr &message);
+  // Wake the consumer after one or more deliveries
+  void signal();
+
+  BoundedQueue<PubSubMessagePtr> queue;
+  std::function<void()> notifier; // optional, run when messages arrive
+  std::atomic<uint64_t> dropped;
+  std::atomic<bool> closed;
+  std::atomic<int> waiters;
+  std::mutex waitMutex;
+  std::condition_variable wakeup;
+  std::vector<std::string> topics; // guarded by PubSub::registryMutex
+};
+using SubscriptionPtr = std::shared_ptr<Subscription>;
+
+/**
+ * Topic-based fan-out shared by every transport (TCP, SSE, WebSocket).
+ * Topics: "chat" (public channels), "tasks" (every task change),
+ * "task:<id>" (one task's watchers), "user:<id>" (a user's private
+ * inbox) and "presence".
+ *
+ * The topic registry is copy-on-write: subscribing swaps in a new map
+ * while publishers read an immutable snapshot, so publish takes no lock.
+ * Messages arrive fully encoded (see EventBus); subscribers share the
+ * bytes for their wire format rather than copying them.
+ */
+class PubSub {
+public:
+  static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+  static const std::string TOPIC_CHAT;
+  static const std::string TOPIC_TASKS;
+  static const std::string TOPIC_PRESENCE;
+  static std::string taskTopic(int taskId);
+  static std::string userTopic(int userId);
+
+  // A message and the topics it goes to
+  struct Delivery {
+    std::vector<std::string> topics;
+    PubSubMessagePtr message;
+  };
+
+private:
+  using SubscriberList = std::vector<SubscriptionPtr>;
+  using TopicMap = std::map<std::string, std::shared_ptr<const SubscriberList>>;
+
+  std::shared_ptr<const TopicMap> topics; // read with std::atomic_load
+  std::mutex registryMutex;               // serializes registry updates
+
+  void addLocked(const SubscriptionPtr &subscription, const std::string &topic,
+                 TopicMap &map);
+
+public:
+  PubSub();
+
+  /**
+   * Create a subscription
+   * @param topicNames Topics to join
+   * @param capacity Queue size; messages beyond it are dropped
+   * @param notifier Optional callback when messages arrive; must not block
+   */
+  SubscriptionPtr subscribe(const std::vector<std::string> &topicNames,
+                            size_t capacity = DEFAULT_QUEUE_CAPACITY,
+                            std::function<void()> notifier = nullptr);
+
+  void addTopic(const SubscriptionPtr &subscription, const std::string &topic);
+
+  // Leave every topic and close the subscription
+  void unsubscribe(const SubscriptionPtr &subscription);
+
+  /**
+   * Deliver a message to every subscriber of any of its topics; a
+   * subscriber on several of them receives it once
+   */
+  void publish(const std::vector<std::string> &topicNames,
+               const PubSubMessagePtr &message);
+
+  /**
+   * Deliver several messages in order, waking each subscriber once for the
+   * whole batch instead of once per message
+   */
+  void publishBatch(const std::vector<Delivery> &batch);
+};
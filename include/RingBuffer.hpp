@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/**
+ * Fixed-capacity ring buffer that keeps its newest entries contiguous.
+ * Each element is stored twice (slot i and slot i + capacity), so any
+ * window of up to `capacity` recent entries is a single pointer range
+ * and can be read in place without copying or wrap-around handling.
+ */
+template <typename T> class RingBuffer {
+private:
+  std::vector<T> slots; // 2 * cap entries, second half mirrors the first
+  size_t cap;
+  size_t head;  // next write position in [0, cap)
+  size_t count; // number of valid entries, at most cap
+
+public:
+  explicit RingBuffer(size_t capacity)
+      : slots(2 * (capacity > 0 ? capacity : 1)),
+        cap(capacity > 0 ? capacity : 1), head(0), count(0) {}
+
+  /**
+   * Append a value, evicting the oldest entry when full
+   * @param value Value to store
+   */
+  void push(const T &value) {
+    slots[head] = value;
+    slots[head + cap] = value;
+    head = (head + 1) % cap;
+    if (count < cap) {
+      count++;
+    }
+  }
+
+  /**
+   * View of the newest entries, oldest first
+   * @param limit Maximum number of entries wanted
+   * @param outCount Receives the number of entries in the view
+   * @return Pointer to the first entry of a contiguous range
+   */
+  const T *tail(size_t limit, size_t &outCount) const {
+    outCount = (limit < count) ? limit : count;
+    size_t start = (head + cap - outCount) % cap;
+    return slots.data() + start;
+  }
+
+  size_t size() const { return count; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return count == 0; }
+};
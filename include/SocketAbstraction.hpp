@@ -2,6 +2,8 @@
 
 #include <string>
 #include <cstdint>
+#include <atomic>
+#include <vector>
 
 // Platform-specific includes and definitions
 #ifdef _WIN32
@@ -15,17 +17,35 @@
     #define SOCKET_ERROR_CODE WSAGetLastError()
 #else
     #include <sys/socket.h>
+    #include <sys/uio.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
     #include <arpa/inet.h>
     #include <unistd.h>
+    #include <fcntl.h>
     #include <cerrno>
     #include <cstring>
+    #ifdef __linux__
+        #include <sys/epoll.h>
+        #include <sys/eventfd.h>
+    #else
+        #include <poll.h>
+    #endif
     
     typedef int SocketHandle;
     #define INVALID_SOCKET_HANDLE -1
     #define SOCKET_ERROR_CODE errno
 #endif
 
+/**
+ * One buffer of a vectored write. Laid out like struct iovec, so on POSIX an
+ * array of these is passed to sendmsg() as is.
+ */
+struct IoSlice {
+    const char* data;
+    size_t length;
+};
+
 /**
  * Cross-platform socket abstraction layer
  * Provides unified interface for socket operations on Windows and POSIX systems
@@ -93,6 +113,15 @@ public:
      */
     static int sendData(SocketHandle socket, const char* data, size_t length);
     
+    /**
+     * Send several buffers with one system call (sendmsg / WSASend), in order
+     * @param socket Socket handle
+     * @param slices Buffers to send
+     * @param count Number of buffers
+     * @return Number of bytes sent, or -1 on error
+     */
+    static int sendVector(SocketHandle socket, const IoSlice* slices, size_t count);
+    
     /**
      * Receive data from socket
      * @param socket Socket handle
@@ -115,6 +144,43 @@ public:
      */
     static bool setReuseAddress(SocketHandle socket);
     
+    /**
+     * Let several sockets listen on the same port, with the kernel spreading
+     * incoming connections across them (SO_REUSEPORT)
+     * @param socket Socket handle, before bind
+     * @return false where the option is unsupported (non-Linux) or fails
+     */
+    static bool setReusePort(SocketHandle socket);
+    
+    /**
+     * Disable Nagle's algorithm so small writes go out immediately
+     * @param socket Socket handle
+     * @return true on success, false on failure
+     */
+    static bool setNoDelay(SocketHandle socket);
+    
+    /**
+     * Shut down both directions of a connection without closing the handle,
+     * waking any thread blocked in send or receive on it
+     * @param socket Socket handle
+     */
+    static void shutdownSocket(SocketHandle socket);
+    
+    /**
+     * Put a socket into non-blocking mode, or back into blocking mode
+     * @param socket Socket handle
+     * @param enabled false to make calls block again
+     * @return true on success, false on failure
+     */
+    static bool setNonBlocking(SocketHandle socket, bool enabled = true);
+    
+    /**
+     * Check whether the last failed call on a non-blocking socket only
+     * failed because it would have blocked (EAGAIN / WSAEWOULDBLOCK)
+     * @return true if the operation should be retried when ready
+     */
+    static bool wouldBlock();
+    
     /**
      * Get last socket error message
      * @return Error message string
@@ -128,3 +194,82 @@ public:
      */
     static bool isValidSocket(SocketHandle socket);
 };
+
+/**
+ * Readiness notification for many non-blocking sockets at once.
+ * Uses epoll in edge-triggered mode on Linux and poll()/WSAPoll elsewhere.
+ * Callers must always read or write until the operation would block, which
+ * is correct for both. Every method except wakeup() must be called from
+ * the thread that calls wait().
+ */
+class EventPoller {
+public:
+    struct Event {
+        SocketHandle socket;
+        bool readable; // data, end of stream or an error to pick up
+        bool writable;
+    };
+    
+    EventPoller();
+    ~EventPoller();
+    EventPoller(const EventPoller&) = delete;
+    EventPoller& operator=(const EventPoller&) = delete;
+    
+    /**
+     * Check that the poller was created successfully
+     * @return true if usable, false otherwise
+     */
+    bool isValid() const;
+    
+    /**
+     * Start watching a socket for reads and writes
+     * @param socket Non-blocking socket handle
+     * @return true on success, false on failure
+     */
+    bool add(SocketHandle socket);
+    
+    /**
+     * Ask for writable events only while output is pending. Edge-triggered
+     * epoll reports each transition anyway, so this is a no-op there.
+     * @param socket Watched socket handle
+     * @param enabled Whether to report writability
+     */
+    void setWriteInterest(SocketHandle socket, bool enabled);
+    
+    /**
+     * Stop watching a socket; call before closing it
+     * @param socket Watched socket handle
+     */
+    void remove(SocketHandle socket);
+    
+    /**
+     * Wait for readiness
+     * @param events Filled with the ready sockets
+     * @param timeoutMs Maximum wait in milliseconds, -1 for no limit
+     * @return Number of events, or -1 on error
+     */
+    int wait(std::vector<Event>& events, int timeoutMs);
+    
+    /**
+     * Interrupt a wait() in progress from any thread
+     */
+    void wakeup();
+    
+    /**
+     * @return System calls made so far, for IO benchmarks
+     */
+    uint64_t syscalls() const { return syscallCount.load(); }
+    
+private:
+    std::atomic<bool> wakePending;
+    std::atomic<uint64_t> syscallCount;
+#ifdef __linux__
+    int epollFd;
+    int wakeFd; // eventfd
+#else
+    std::vector<pollfd> watched;
+    #ifndef _WIN32
+    int wakePipe[2]; // self-pipe; Windows relies on a short wait timeout
+    #endif
+#endif
+};
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "AdmissionControl.hpp"
+#include "Framing.hpp"
+#include "IoUring.hpp"
+#include "OutboundQueue.hpp"
+#include "PubSub.hpp"
+#include "SocketAbstraction.hpp"
+#include "TimingWheel.hpp"
+#include "WorkerPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * TCP transport for the CLI clients.
+ *
+ * Sockets are served by N reactors. Each reactor is one thread with its own
+ * SO_REUSEPORT listening socket, EventPoller and connection table, so
+ * accepting, reading and writing scale with cores and a reconnect storm is
+ * spread by the kernel instead of queueing behind one accept loop. Reactor
+ * threads can optionally be pinned to a CPU each. Where SO_REUSEPORT is not
+ * available, the first reactor listens alone and hands accepted connections
+ * to the others in turn.
+ *
+ * Sockets are non-blocking and edge-triggered. Commands run on a shared
+ * work-stealing WorkerPool: each connection's commands run one at a time
+ * and in arrival order, while different connections run in parallel. A
+ * worker takes a connection's commands in turns of SESSION_QUANTUM, and a
+ * connection that queues more than Options::sessionQueueLimit has the
+ * excess refused rather than buffered. Under overload, AdmissionControl
+ * refuses commands by priority with a "[BUSY] ... retry after" reply, and
+ * connections past Options::maxConnections get that reply and are closed.
+ *
+ * Input and output are line frames (see Framing), or length-prefixed typed
+ * messages once a client negotiates the binary protocol (see
+ * BinaryProtocol). Each connection buffers partial input, and all frames
+ * completed by one read go to the workers together, so clients can pipeline
+ * commands. The replies to such a batch are held until it has run and then
+ * written together. A command may carry a request id ("@<id> " before a
+ * text frame, a field in a binary one); all it answers then comes back as
+ * one frame tagged with that id, even if that is nothing, so a script knows
+ * when each command is done. Replies from workers and events from the
+ * connection's PubSub subscription are framed into its OutboundQueue, which
+ * bounds what a slow reader can pile up. Only the connection's reactor
+ * writes that queue to the socket, so no sender ever waits on the network.
+ * Events arrive already framed by the EventBus and are queued by reference,
+ * so a broadcast is encoded once however many connections get it, and
+ * queued frames go out in vectored writes rather than being copied into one
+ * buffer.
+ *
+ * Each reactor keeps a TimingWheel for its connections' deadlines. A
+ * client silent for Options::heartbeatInterval is sent a PING and closed
+ * if Options::heartbeatTimeout passes without any input, so a peer that
+ * vanished without a FIN goes offline in seconds rather than when TCP
+ * gives up; optionally, clients that send no command for
+ * Options::idleTimeout are told so and closed. Input only stamps the
+ * connection; its single timer re-arms itself from that stamp when it
+ * fires, so busy connections cost the wheel nothing per read.
+ *
+ * Reactors drive their sockets through one of two backends: readiness
+ * with EventPoller (epoll) and non-blocking send/recv, or completions with
+ * IoUring, where accepts and receives are multishot and each loop
+ * iteration submits all its reads and writes in a single system call.
+ */
+class TCPServer {
+public:
+  static constexpr int DEFAULT_PORT = 8080;
+  // Bytes per read; a read may end mid-frame or hold many pipelined frames
+  static constexpr size_t READ_CHUNK_SIZE = 4096;
+  // Queued bytes handed to the kernel per vectored write, in at most
+  // WriteBatch::MAX_FRAMES frames
+  static constexpr size_t WRITE_BATCH_SIZE = 64 * 1024;
+  // Tasks a worker runs for one connection before the others get a turn
+  static constexpr size_t SESSION_QUANTUM = 8;
+  // Longest request id a command may carry
+  static constexpr size_t MAX_REQUEST_ID = 64;
+  // Resolution of connection deadlines
+  static constexpr std::chrono::milliseconds TIMER_TICK{100};
+  // How long an idle client told it is being closed may take to read it
+  static constexpr std::chrono::seconds CLOSE_GRACE{5};
+
+  // Application callbacks, all run on the worker pool and, for a given
+  // connection, one at a time in order
+  struct Handlers {
+    std::function<void(SocketHandle)> onConnect;
+    std::function<void(SocketHandle, const std::string &)> onCommand;
+    std::function<void(SocketHandle)> onDisconnect; // after the last command
+    // Optional: how a command ranks when the server sheds load (NORMAL
+    // if unset); runs on the reactor, so it must be cheap
+    std::function<AdmissionControl::Priority(const std::string &)> priority;
+  };
+
+  enum class IoBackend { EPOLL, IO_URING };
+
+  enum class Protocol { TEXT, BINARY };
+
+  struct Options {
+    size_t reactors = 1;      // event-loop threads, at least one
+    size_t workerThreads = 2; // threads running the handlers
+    // Commands a connection may have waiting for a worker; more are
+    // refused with an error reply, in order
+    size_t sessionQueueLimit = 1024;
+    // Open connections; more are told to retry and closed (0 = no limit)
+    size_t maxConnections = 0;
+    // Commands admitted across all connections, by priority
+    AdmissionControl::Limits admission;
+    // Silence before a client is pinged, and how long it then has to
+    // send anything before it is closed as dead (0 = no heartbeat)
+    std::chrono::seconds heartbeatInterval{30};
+    std::chrono::seconds heartbeatTimeout{15};
+    // Time without a command, pings not counted, before a client is
+    // closed (0 = never)
+    std::chrono::seconds idleTimeout{0};
+    bool pinToCpus = false;   // pin reactor i to CPU i (Linux only)
+    // IO_URING falls back to EPOLL where the kernel or build lacks it
+    IoBackend backend = IoBackend::EPOLL;
+    // Per-connection output bound and what happens to slow readers
+    OutboundQueue::Limits output;
+  };
+
+  // Counters for comparing the backends
+  struct IoStats {
+    uint64_t commands; // inputs handed to onCommand
+    uint64_t refused;  // over sessionQueueLimit, never run
+    uint64_t syscalls; // made by the reactors for socket IO and wakeups
+  };
+
+  // What admission control has refused, and what the deadlines closed
+  struct LoadStats {
+    AdmissionControl::Stats commands;
+    uint64_t rejectedConnections; // over maxConnections
+    uint64_t deadConnections;     // unanswered heartbeat
+    uint64_t idleConnections;     // over idleTimeout
+  };
+
+  // Output queues now, and what the slow-consumer policy has done so far
+  struct QueueStats {
+    uint64_t queuedBytes;     // across open connections
+    uint64_t deepestQueue;    // bytes, largest single connection
+    uint64_t dropped;         // frames
+    uint64_t coalesced;       // frames superseded by newer ones
+    uint64_t slowDisconnects; // connections closed under DISCONNECT
+  };
+
+private:
+  struct Reactor;
+
+  struct Connection {
+    explicit Connection(OutboundQueue::Limits limits) : output(limits) {}
+
+    SocketHandle socket;
+    Reactor *reactor = nullptr; // owns the socket once registered
+    std::mutex mutex;
+    FrameReader input;                       // reactor thread only
+    bool firstFrame = true;                  // reactor thread only
+    Protocol protocol = Protocol::TEXT;      // of output; set in order
+    OutboundQueue output;                    // frames not yet being written
+    WriteBatch sending;     // taken from output, not yet accepted by the
+                            // kernel; owned by the send in flight (io_uring)
+#ifndef _WIN32
+    msghdr sendMessage{};   // io_uring: names sending's slices
+#endif
+    bool writesFailed = false; // socket shut down; output is discarded
+    std::deque<std::function<void()>> tasks; // waiting for a worker
+    size_t queuedCommands = 0; // in tasks, not yet started
+    bool scheduled = false;    // a worker is running this connection's tasks
+    bool flushQueued = false;  // already posted to the reactor
+    bool corked = false;       // replies wait for the running batch to end
+    bool closing = false;      // peer gone or write failed
+    bool sendInFlight = false; // io_uring
+    bool closeAfterSend = false; // io_uring: finishDisconnect was deferred
+    bool closeWhenDrained = false; // shut down once output is written
+    SubscriptionPtr subscription;
+    int userId = -1;
+    uint64_t reportedDrops = 0;
+
+    // Liveness, reactor thread only
+    TimingWheel::TimerId deadline = 0;
+    std::chrono::steady_clock::time_point lastInput;   // pongs included
+    std::chrono::steady_clock::time_point lastCommand;
+    std::chrono::steady_clock::time_point pingedAt; // unanswered if later
+                                                    // than lastInput
+  };
+  using ConnectionPtr = std::shared_ptr<Connection>;
+
+  struct QueuedCommand {
+    std::string text;
+    std::string requestId; // empty if the client did not tag it
+    AdmissionControl::Priority priority = AdmissionControl::Priority::NORMAL;
+    bool admitted = false; // holds an admission slot until it has run
+  };
+
+  // Work handed to a reactor by other threads
+  struct PostedWork {
+    std::vector<ConnectionPtr> adopt; // accepted by another reactor
+    std::vector<ConnectionPtr> flush;
+    std::vector<ConnectionPtr> close;
+  };
+
+  // One event-loop thread and the sockets it owns
+  struct Reactor {
+    size_t index = 0;
+    EventPoller poller;
+    SocketHandle listenSocket = INVALID_SOCKET_HANDLE; // none if handed to
+    std::thread thread; // not started for reactor 0, which is start()'s caller
+
+    std::unordered_map<SocketHandle, ConnectionPtr> connections;
+    mutable std::shared_mutex connectionsMutex; // written by this reactor
+
+    std::mutex postedMutex;
+    PostedWork posted; // guarded by postedMutex
+
+    std::atomic<uint64_t> commands{0};
+    std::atomic<uint64_t> refusedCommands{0};
+    std::atomic<uint64_t> rejectedConnections{0};
+    std::atomic<uint64_t> syscalls{0}; // send/recv/accept on the epoll path
+    std::atomic<uint64_t> droppedFrames{0};
+    std::atomic<uint64_t> coalescedFrames{0};
+    std::atomic<uint64_t> slowDisconnects{0};
+    std::atomic<uint64_t> deadConnections{0};
+    std::atomic<uint64_t> idleConnections{0};
+
+    TimingWheel timers{TIMER_TICK};
+    std::chrono::steady_clock::time_point now; // as of this loop iteration
+
+    // Closed while io_uring operations may still point into them; released
+    // with the reactor, after the ring that is declared below them
+    std::vector<ConnectionPtr> retired;
+    std::unique_ptr<IoUring> ring; // IO_URING backend only
+
+    void wakeup() {
+      if (ring)
+        ring->wakeup();
+      else
+        poller.wakeup();
+    }
+  };
+
+  PubSub &pubSub;
+  Handlers handlers;
+  Options options;
+  AdmissionControl admission;
+  std::atomic<bool> running;
+  std::vector<std::unique_ptr<Reactor>> reactors;
+  std::atomic<size_t> nextReactor; // round-robin target for handed-off sockets
+
+  WorkerPool workers; // last, so it joins before the state its tasks use
+
+  bool listen(Reactor &reactor, int port, bool reusePort);
+  void eventLoop(Reactor &reactor);
+  void uringLoop(Reactor &reactor);
+  void processPosted(Reactor &reactor, PostedWork &work);
+  int waitTimeout(const Reactor &reactor) const; // ms to the next deadline
+  void checkLiveness(const ConnectionPtr &conn);
+  void closeIdle(const ConnectionPtr &conn);
+  void acceptConnections(Reactor &reactor);
+  void accepted(Reactor &reactor, SocketHandle socket);
+  void adopt(Reactor &reactor, const ConnectionPtr &conn);
+  void readFrom(const ConnectionPtr &conn);
+  void received(const ConnectionPtr &conn, const char *data, size_t length);
+  void runCommands(const ConnectionPtr &conn,
+                   const std::vector<QueuedCommand> &batch,
+                   std::chrono::steady_clock::time_point queuedAt);
+  void sendReply(const ConnectionPtr &conn, const std::string &requestId,
+                 const std::vector<std::string> &messages);
+  std::string busyMessage() const;
+  void flush(const ConnectionPtr &conn);
+  void startSend(Connection &conn);   // caller holds conn.mutex
+  void prepareSend(Connection &conn); // ditto; io_uring, sending non-empty
+  void sendCompleted(const ConnectionPtr &conn, int result);
+  void collectEvents(Connection &conn); // caller holds conn.mutex
+  void refill(Connection &conn);        // ditto
+  void append(Connection &conn, const std::string &message); // ditto
+  void appendBinary(Connection &conn, const std::string &message); // ditto
+  void queueFrame(Connection &conn, SharedFrame frame,
+                  const std::string &key = ""); // ditto
+  void failWrites(Connection &conn);       // ditto
+  bool markFlush(Connection &conn); // ditto; true if a flush must be posted
+  bool enqueue(SocketHandle socket, const std::string &message, bool binary);
+  void upgrade(SocketHandle socket, unsigned version);
+  void beginDisconnect(const ConnectionPtr &conn);
+  void finishDisconnect(const ConnectionPtr &conn);
+  void closeAll(Reactor &reactor);
+
+  void runInOrder(const ConnectionPtr &conn, std::function<void()> task);
+  void runTasks(const ConnectionPtr &conn);
+  void requestFlush(const ConnectionPtr &conn);
+  ConnectionPtr find(SocketHandle socket) const;
+  ConnectionPtr find(const Reactor &reactor, SocketHandle socket) const;
+
+public:
+  /**
+   * @param ps Event source for subscribe()
+   * @param opts Reactor, worker and backend settings
+   */
+  TCPServer(PubSub &ps, Options opts);
+  ~TCPServer();
+
+  void setHandlers(Handlers h);
+
+  /**
+   * Bind and run the reactors, the first on the calling thread (blocking
+   * call)
+   * @param port Port to listen on (default: 8080)
+   * @return false if the port could not be bound, true after stop()
+   */
+  bool start(int port = DEFAULT_PORT);
+
+  /**
+   * Stop every reactor and close every connection
+   */
+  void stop();
+
+  /**
+   * Queue a message for a connection; never blocks on the network
+   * @param socket Connection handle passed to the handlers
+   * @param message Payload, sent as one frame (a TEXT message to binary
+   *                clients)
+   * @return false if the connection is gone
+   */
+  bool send(SocketHandle socket, const std::string &message);
+
+  /**
+   * Queue a message encoded with BinaryProtocol
+   * @param socket Connection handle passed to the handlers
+   * @param message Encoded message
+   * @return false if the connection is gone or speaks the text protocol
+   */
+  bool sendBinary(SocketHandle socket, const std::string &message);
+
+  /**
+   * Protocol of a connection's replies. Handlers see the switch to BINARY
+   * in order: every command after the negotiation line runs after it.
+   */
+  Protocol protocol(SocketHandle socket) const;
+
+  /**
+   * Deliver events published to these topics to a connection
+   * @param socket Connection handle passed to the handlers
+   * @param userId Logged-in user, so their own private messages are skipped
+   * @param topics PubSub topics to join
+   */
+  void subscribe(SocketHandle socket, int userId,
+                 const std::vector<std::string> &topics);
+
+  size_t connectionCount() const;
+  size_t reactorCount() const { return reactors.size(); }
+  IoBackend backend() const { return options.backend; } // after start()
+  IoStats ioStats() const;
+  QueueStats queueStats() const;
+  LoadStats loadStats() const;
+};
@@ -46,13 +46,13 @@ public:
     
     // Getters
     int getTaskId() const { return taskId; }
-    std::string getTitle() const { return title; }
-    std::string getDescription() const { return description; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getDescription() const { return description; }
     TaskStatus getStatus() const { return status; }
     TaskPriority getPriority() const { return priority; }
     int getAssigneeId() const { return assigneeId; }
     int getReporterId() const { return reporterId; }
-    std::string getProjectKey() const { return projectKey; }
+    const std::string& getProjectKey() const { return projectKey; }
     std::chrono::system_clock::time_point getDeadline() const { return deadline; }
     std::chrono::system_clock::time_point getAssignedAt() const { return assignedAt; }
     std::string getDeadlineString() const;
@@ -73,5 +73,10 @@ public:
     
     std::string getStatusString() const;
     std::string getPriorityString() const;
+    
+    // Enum names as clients send them ("IN_PROGRESS", or "PROGRESS" on the
+    // CLI); false if the name is unknown
+    static bool parseStatus(const std::string& name, TaskStatus& status);
+    static bool parsePriority(const std::string& name, TaskPriority& priority);
     std::string toString() const;
 };
\ No newline at end of file
@@ -1,16 +1,73 @@
 #pragma once
 #include "Task.hpp"
 #include "User.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <map>
-#include <mutex>
+#include <shared_mutex>
+
+// Which mutation a change listener is being told about
+enum class TaskChange {
+    CREATED,
+    STATUS,
+    PRIORITY,
+    ASSIGNED,
+    COMMENTED,
+    LOADED
+};
+
+// A task to create through TaskManager::createTasks
+struct NewTask {
+    std::string title;
+    std::string description;
+    std::string projectKey = "PROJ";
+    int deadlineDays = 7;
+};
+
+// One step of TaskManager::applyOperations
+struct TaskOperation {
+    enum class Kind { CREATE, SET_STATUS, SET_PRIORITY, ASSIGN, COMMENT };
+    Kind kind = Kind::CREATE;
+    int taskId = -1;
+    int taskRef = -1;  // instead of taskId: index of an earlier CREATE in the batch
+    NewTask newTask;   // CREATE
+    TaskStatus status = TaskStatus::TODO;
+    TaskPriority priority = TaskPriority::MEDIUM;
+    int assigneeId = -1;
+    std::string comment;
+};
+
+struct TaskOperationResult {
+    bool ok = false;
+    Task task;          // as the operation left it
+    std::string error;  // when !ok
+};
 
 class TaskManager {
 private:
     std::vector<Task> tasks;
     std::map<std::string, std::vector<int>> projectTasks; // project -> task IDs
     int nextTaskId;
-    mutable std::mutex taskMutex;
+    std::map<int, uint64_t> taskVersions; // taskId -> change sequence of its last mutation
+    std::map<uint64_t, int> changeIndex;  // change sequence -> taskId, one entry per task
+    uint64_t changeSeq;                   // last issued change sequence number
+    mutable std::shared_mutex taskMutex;
+    mutable std::condition_variable_any taskChanged; // signalled on every recorded change
+    std::function<void(const Task&, TaskChange)> changeListener;  // invoked under taskMutex
+    std::function<void(const std::vector<Task>&, TaskChange)> batchListener; // likewise
+
+    // Internal helpers - caller must hold taskMutex
+    Task* getTaskById(int taskId);
+    const Task* getTaskById(int taskId) const;
+    int countActiveTasks(int userId) const;
+    // notify = false leaves waking waiters and listeners to finishBatch
+    void recordChange(int taskId, TaskChange change, bool notify = true);
+    std::vector<Task> updateTasks(const std::vector<int>& taskIds, TaskChange change,
+                                  const std::function<void(Task&)>& update);
+    void finishBatch(const std::vector<Task>& changed, TaskChange change);
 
 public:
     TaskManager();
@@ -23,6 +80,19 @@ public:
     bool assignTask(int taskId, int assigneeId, int userId);
     bool addTaskComment(int taskId, const std::string& comment, int userId);
     
+    // Bulk operations: the whole batch is applied under one lock, saved once
+    // and reported as one change. Each returns the tasks it changed, in ID
+    // order; unknown IDs and untitled new tasks are skipped.
+    std::vector<Task> createTasks(const std::vector<NewTask>& newTasks, int reporterId);
+    std::vector<Task> updateTasksStatus(const std::vector<int>& taskIds, TaskStatus status, int userId);
+    std::vector<Task> updateTasksPriority(const std::vector<int>& taskIds, TaskPriority priority, int userId);
+    std::vector<Task> assignTasks(const std::vector<int>& taskIds, int assigneeId, int userId);
+    // Runs mixed operations in order under one lock, saving once. Atomic:
+    // after the first failure nothing is applied and the others report
+    // "Not applied"; otherwise failures are skipped.
+    std::vector<TaskOperationResult> applyOperations(const std::vector<TaskOperation>& operations,
+                                                     int userId, bool atomic);
+    
     // SMART ASSIGNMENT: Workload-based assignment
     int recommendBestAssignee(const std::map<std::string, User>& users) const;
     int getActiveTaskCount(int userId) const;
@@ -34,7 +104,18 @@ public:
     std::vector<Task> getTasksByProject(const std::string& projectKey) const;
     std::vector<Task> getTasksByAssignee(int userId) const;
     std::vector<Task> getTasksByStatus(TaskStatus status) const;
-    Task* getTaskById(int taskId);
+    bool getTask(int taskId, Task& out) const;
+    
+    // Incremental sync: tasks created or modified after change sequence `since`
+    std::vector<Task> getTasksChangedSince(uint64_t since, uint64_t& version) const;
+    uint64_t getVersion() const;
+    // Blocks until the version moves past `since` or the deadline passes
+    bool waitForChange(uint64_t since, std::chrono::steady_clock::time_point deadline) const;
+    // Called with each task after it is created or modified; must not call back into TaskManager
+    void setChangeListener(std::function<void(const Task&, TaskChange)> listener);
+    // Called once per bulk operation with every task it changed, same rules;
+    // without it the change listener hears about each task instead
+    void setBatchChangeListener(std::function<void(const std::vector<Task>&, TaskChange)> listener);
     
     // Statistics & Dashboard
     std::map<TaskStatus, int> getTaskStatusCount() const;
@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Hierarchical timing wheel: one-shot timers with O(1) schedule and cancel,
+ * for the many timeouts a server keeps (heartbeats, idle connections,
+ * sessions) without a thread or a scan per timer.
+ *
+ * Time advances in ticks. Level 0 has a slot per tick for the next
+ * SLOTS ticks; each higher level has a slot per whole turn of the level
+ * below, so four levels of 256 slots cover 2^32 ticks. A timer goes into
+ * the coarsest level its deadline needs and moves down ("cascades") when
+ * the wheel below reaches its slot, so each timer is touched at most once
+ * per level. Deadlines are rounded up to whole ticks, so a timer never
+ * fires early and at most one tick late.
+ *
+ * Not thread-safe: the owner serializes calls, typically by using it only
+ * from one event loop or under its own lock. Callbacks run inside
+ * advance() and may schedule or cancel timers, but not advance again.
+ */
+class TimingWheel {
+public:
+  using Clock = std::chrono::steady_clock;
+  using TimerId = uint64_t; // 0 is never a live timer
+
+  static constexpr size_t SLOT_BITS = 8;
+  static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+  static constexpr size_t LEVELS = 4;
+
+  /**
+   * @param tick Resolution; deadlines are rounded up to it
+   * @param start Time of tick 0
+   */
+  explicit TimingWheel(Clock::duration tick = std::chrono::milliseconds(100),
+                       Clock::time_point start = Clock::now());
+
+  TimingWheel(const TimingWheel &) = delete;
+  TimingWheel &operator=(const TimingWheel &) = delete;
+
+  /**
+   * Run callback once, at the first advance() at or after deadline
+   * @param deadline When to fire; a past deadline fires on the next tick
+   * @param callback Work to run
+   * @return Handle for cancel()
+   */
+  TimerId schedule(Clock::time_point deadline, std::function<void()> callback);
+
+  /**
+   * Drop a pending timer
+   * @param id Handle from schedule()
+   * @return false if it already fired or was cancelled
+   */
+  bool cancel(TimerId id);
+
+  /**
+   * Fire every timer due by now, in deadline order (by tick)
+   * @param now Current time
+   * @return Number of callbacks run
+   */
+  size_t advance(Clock::time_point now);
+
+  /**
+   * How long an event loop may sleep before advance() has work: until the
+   * next occupied tick, or the next cascade when only far timers are left
+   * @return Clock::duration::max() if no timer is pending, zero if overdue
+   */
+  Clock::duration timeUntilNext(Clock::time_point now) const;
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+private:
+  static constexpr uint32_t NIL = UINT32_MAX;
+  static constexpr uint16_t UNUSED = UINT16_MAX;
+  static constexpr uint64_t MASK = SLOTS - 1;
+
+  struct Node {
+    std::function<void()> callback;
+    uint64_t expiry = 0; // tick
+    uint32_t prev = NIL;
+    uint32_t next = NIL; // also links free nodes
+    uint32_t generation = 1; // bumped on reuse, so stale ids miss
+    uint16_t slot = UNUSED;  // level * SLOTS + index while pending
+  };
+
+  Clock::time_point start;
+  Clock::duration tick;
+  uint64_t elapsed = 0; // last tick run
+  size_t count = 0;
+
+  std::vector<Node> nodes; // indexed by the low half of a TimerId
+  uint32_t freeNodes = NIL;
+  std::array<uint32_t, LEVELS * SLOTS> heads;        // per-slot lists
+  std::array<uint64_t, LEVELS * SLOTS / 64> occupied; // non-empty slots
+
+  void place(uint32_t index);
+  void unlink(uint32_t index);
+  void release(uint32_t index);
+  void cascade(size_t level);
+  bool levelEmpty(size_t level) const;
+};
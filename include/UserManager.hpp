@@ -0,0 +1,44 @@
+#pragma once
+#include "User.hpp"
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Thread-safe user directory shared by the TCP and HTTP servers.
+ * Reads take a shared lock so lookups from concurrent HTTP requests
+ * never serialize behind each other or behind TCP command handling.
+ */
+class UserManager {
+private:
+  std::map<std::string, User> users; // username -> user
+  mutable std::shared_mutex userMutex;
+  // Invoked under userMutex when a user's online status flips
+  std::function<void(const std::string &, const User &)> presenceListener;
+
+public:
+  UserManager() = default;
+
+  /**
+   * Register a user
+   * @return false if the username is already taken
+   */
+  bool addUser(const std::string &username, const User &user);
+
+  // Query operations
+  bool hasUser(const std::string &username) const;
+  bool getUser(const std::string &username, User &out) const;
+  int getUserId(const std::string &username) const;
+  std::string getUsernameById(int userId) const;
+  std::map<std::string, User> getAllUsers() const;
+  std::vector<std::string> getOnlineUsernames() const;
+
+  // Presence
+  bool setOnlineStatus(const std::string &username, bool online);
+  bool setSocketId(const std::string &username, int socketId);
+  // Listener must not call back into UserManager
+  void setPresenceListener(
+      std::function<void(const std::string &, const User &)> listener);
+};
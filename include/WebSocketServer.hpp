@@ -0,0 +1,120 @@
+#pragma once
+
+#include "ChatManager.hpp"
+#include "EventBus.hpp"
+#include "EventLoop.hpp"
+#include "OutboundQueue.hpp"
+#include "PubSub.hpp"
+#include "SocketAbstraction.hpp"
+#include "TimingWheel.hpp"
+#include "UserManager.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+/**
+ * WebSocket (RFC 6455) server for browser clients, on its own port next to
+ * the HTTP API. Carries chat send/receive, typing indicators and the same
+ * task/chat/presence notifications as the SSE stream, as JSON text frames.
+ *
+ * Every connection lives on one EventLoop thread: the handshake and the
+ * frames are parsed as bytes arrive, and output is written without
+ * blocking, so a connection costs a socket, its buffers and a subscription
+ * rather than a reader and a writer thread. Each connection subscribes to
+ * the PubSub topics it may see; the notifier wakes the loop, which moves
+ * the events, already framed by the EventBus, into the connection's
+ * output. Whatever accumulated while the previous write was in flight goes
+ * out in one vectored send, so bursts are batched without delaying the
+ * first message. A client whose output grows past SEND_QUEUE_LIMIT frames
+ * is disconnected instead of blocking publishers.
+ *
+ * Chat sends run on the loop thread too, so a slow ChatManager delays every
+ * connection's traffic, not just the sender's.
+ */
+class WebSocketServer {
+public:
+  static constexpr int DEFAULT_PORT = 8082;
+  // Open connections; past it the handshake is refused with 503
+  static constexpr size_t MAX_CONNECTIONS = 10000;
+  static constexpr size_t SEND_QUEUE_LIMIT = 1024; // frames per connection
+  static constexpr size_t MAX_MESSAGE_SIZE = 64 * 1024; // incoming payload cap
+  // Time allowed for the handshake, and for a close frame to drain
+  static constexpr std::chrono::seconds HANDSHAKE_TIMEOUT{10};
+  static constexpr std::chrono::seconds CLOSE_TIMEOUT{5};
+
+  // Resolves a session token to a username
+  using Authenticator =
+      std::function<bool(const std::string &token, std::string &username)>;
+
+private:
+  // Everything but wakePosted belongs to the loop thread
+  struct Connection {
+    SocketHandle socket;
+    bool open = false; // handshake done
+    int userId = -1;
+    std::string username;
+    std::string input;   // received, not yet parsed
+    std::string message; // reassembles fragmented messages
+    SubscriptionPtr subscription; // published events
+    std::atomic<bool> wakePosted{false};
+    WriteBatch output; // frames not yet taken by the kernel
+    bool closing = false; // nothing more is queued; closes once flushed
+    TimingWheel::TimerId timer = 0; // handshake or close deadline
+  };
+  using ConnectionPtr = std::shared_ptr<Connection>;
+
+  ChatManager &chatManager;
+  UserManager &userManager;
+  PubSub &pubSub;
+  EventBus &eventBus;
+  Authenticator authenticate;
+
+  EventLoop loop;
+  SocketHandle listenSocket;
+  std::atomic<bool> running;
+
+  std::unordered_set<ConnectionPtr> connections; // loop thread only
+  std::atomic<size_t> openConnections;           // past the handshake
+
+  void acceptConnections();
+  void readFrom(const ConnectionPtr &conn);
+  bool performHandshake(const ConnectionPtr &conn);
+  void parseFrames(const ConnectionPtr &conn);
+  void handleMessage(const ConnectionPtr &conn, const std::string &payload);
+  void wake(const ConnectionPtr &conn);
+  void flush(const ConnectionPtr &conn);
+
+  void enqueue(const ConnectionPtr &conn,
+               const std::shared_ptr<const std::string> &frame);
+  void closeConnection(const ConnectionPtr &conn, uint16_t code,
+                       const std::string &reason);
+  void refuse(const ConnectionPtr &conn, const std::string &status);
+  void drop(const ConnectionPtr &conn);
+  void closeAll();
+
+  static std::string encodeFrame(uint8_t opcode, const std::string &payload);
+  static std::shared_ptr<const std::string>
+  textFrame(const std::string &type, const std::string &data);
+
+public:
+  WebSocketServer(ChatManager &cm, UserManager &um, PubSub &ps, EventBus &bus,
+                  Authenticator auth);
+  ~WebSocketServer();
+
+  /**
+   * Bind and start serving connections on the loop thread
+   * @param port Port to listen on (default: 8082)
+   * @return true on success, false if the port could not be bound
+   */
+  bool start(int port = DEFAULT_PORT);
+
+  /**
+   * Stop accepting, send every connection a close frame and close it
+   */
+  void stop();
+
+  size_t connectionCount() const { return openConnections.load(); }
+};
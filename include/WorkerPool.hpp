@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of threads running submitted tasks, with one queue per thread.
+ * Used by the TCP server to execute commands off its event-loop threads.
+ *
+ * A task submitted from one of the pool's own threads goes to that
+ * thread's queue, so work a task hands on stays where its data is warm;
+ * tasks from other threads are spread over the queues in turn. Each thread
+ * runs its queue in FIFO order, and a thread whose queue is empty steals
+ * the oldest task from another, so one long task never strands the work
+ * queued behind it while other threads sit idle.
+ */
+class WorkerPool {
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks; // guarded by mutex
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<size_t> queued;     // tasks in all queues
+  std::atomic<size_t> sleeping;   // threads waiting for work
+  std::atomic<size_t> nextWorker; // round-robin target for outside submits
+  std::atomic<uint64_t> stolen;
+  std::mutex sleepMutex;
+  std::condition_variable taskReady;
+  bool stopping; // guarded by sleepMutex
+
+  void workerLoop(size_t index);
+  bool takeTask(size_t index, std::function<void()> &task);
+
+public:
+  explicit WorkerPool(size_t threadCount);
+
+  // Runs every task already submitted, then joins the threads
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  void submit(std::function<void()> task);
+  size_t size() const { return workers.size(); }
+  uint64_t stolenCount() const { return stolen.load(); }
+};
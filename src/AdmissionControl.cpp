@@ -0,0 +1,54 @@
+#include "../include/AdmissionControl.hpp"
+
+AdmissionControl::AdmissionControl(Limits l)
+    : limits(l), inFlight(0), admitted(0), shed(0), expiredCount(0) {}
+
+size_t AdmissionControl::budget(Priority priority) const {
+  size_t share = limits.maxInFlight;
+  switch (priority) {
+  case Priority::HIGH:
+    break;
+  case Priority::NORMAL:
+    share = limits.maxInFlight - limits.maxInFlight / 4;
+    break;
+  case Priority::LOW:
+    share = limits.maxInFlight / 2;
+    break;
+  }
+  // Small limits must not round a priority down to never admitted
+  return share > 0 ? share : 1;
+}
+
+bool AdmissionControl::tryAdmit(Priority priority) {
+  if (limits.maxInFlight == 0) {
+    inFlight.fetch_add(1);
+    ++admitted;
+    return true;
+  }
+  size_t allowed = budget(priority);
+  size_t current = inFlight.load();
+  do {
+    if (current >= allowed) {
+      ++shed;
+      return false;
+    }
+  } while (!inFlight.compare_exchange_weak(current, current + 1));
+  ++admitted;
+  return true;
+}
+
+void AdmissionControl::release() { inFlight.fetch_sub(1); }
+
+bool AdmissionControl::expired(std::chrono::steady_clock::time_point queuedAt,
+                               Priority priority) {
+  if (priority == Priority::HIGH || limits.maxQueueWait.count() == 0 ||
+      std::chrono::steady_clock::now() - queuedAt <= limits.maxQueueWait) {
+    return false;
+  }
+  ++expiredCount;
+  return true;
+}
+
+AdmissionControl::Stats AdmissionControl::stats() const {
+  return {inFlight.load(), admitted.load(), shed.load(), expiredCount.load()};
+}
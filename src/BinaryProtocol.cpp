@@ -0,0 +1,279 @@
+#include "../include/BinaryProtocol.hpp"
+#include "../include/Framing.hpp"
+#include <chrono>
+#include <climits>
+
+namespace {
+const std::string UPGRADE_PREFIX = "PROTOCOL BINARY ";
+
+// Enums travel as one byte; decoding rejects values past the last one
+template <typename Enum>
+bool readEnum(BinaryReader &reader, Enum last, Enum &value) {
+  uint8_t byte = 0;
+  if (!reader.readByte(byte) || byte > static_cast<uint8_t>(last)) {
+    return false;
+  }
+  value = static_cast<Enum>(byte);
+  return true;
+}
+
+std::string begin(BinaryProtocol::Type type) {
+  return std::string(1, static_cast<char>(type));
+}
+} // namespace
+
+void BinaryWriter::writeVarint(uint64_t value) {
+  Framing::putVarint(out, value);
+}
+
+void BinaryWriter::writeSigned(int64_t value) {
+  // Zigzag: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+  writeVarint((static_cast<uint64_t>(value) << 1) ^
+              static_cast<uint64_t>(value >> 63));
+}
+
+void BinaryWriter::writeString(const std::string &value) {
+  writeVarint(value.size());
+  out += value;
+}
+
+bool BinaryReader::readByte(uint8_t &value) {
+  if (failed || offset >= size) {
+    failed = true;
+    return false;
+  }
+  value = static_cast<uint8_t>(data[offset++]);
+  return true;
+}
+
+bool BinaryReader::readVarint(uint64_t &value) {
+  size_t used =
+      failed ? 0 : Framing::getVarint(data + offset, size - offset, value);
+  if (used == 0) {
+    failed = true;
+    return false;
+  }
+  offset += used;
+  return true;
+}
+
+bool BinaryReader::readSigned(int64_t &value) {
+  uint64_t raw = 0;
+  if (!readVarint(raw)) {
+    return false;
+  }
+  value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+  return true;
+}
+
+bool BinaryReader::readInt(int &value) {
+  int64_t wide = 0;
+  if (!readSigned(wide) || wide < INT_MIN || wide > INT_MAX) {
+    failed = true;
+    return false;
+  }
+  value = static_cast<int>(wide);
+  return true;
+}
+
+bool BinaryReader::readString(std::string &value) {
+  uint64_t length = 0;
+  if (!readVarint(length) || length > size - offset) {
+    failed = true;
+    return false;
+  }
+  value.assign(data + offset, length);
+  offset += length;
+  return true;
+}
+
+bool BinaryProtocol::parseUpgrade(const std::string &frame,
+                                  unsigned &version) {
+  if (frame.compare(0, UPGRADE_PREFIX.size(), UPGRADE_PREFIX) != 0) {
+    return false;
+  }
+  try {
+    unsigned long requested = std::stoul(frame.substr(UPGRADE_PREFIX.size()));
+    if (requested == 0) {
+      return false;
+    }
+    version = requested < VERSION ? static_cast<unsigned>(requested) : VERSION;
+    return true;
+  } catch (const std::exception &) {
+    return false;
+  }
+}
+
+std::string BinaryProtocol::upgradeLine(unsigned version) {
+  return UPGRADE_PREFIX + std::to_string(version);
+}
+
+std::string BinaryProtocol::command(const std::string &command,
+                                    const std::string &requestId) {
+  std::string out = begin(Type::COMMAND);
+  BinaryWriter writer(out);
+  writer.writeString(command);
+  if (!requestId.empty()) {
+    writer.writeString(requestId);
+  }
+  return out;
+}
+
+std::string BinaryProtocol::text(const std::string &text) {
+  std::string out = begin(Type::TEXT);
+  BinaryWriter(out).writeString(text);
+  return out;
+}
+
+std::string BinaryProtocol::ping() { return begin(Type::PING); }
+
+std::string BinaryProtocol::pong() { return begin(Type::PONG); }
+
+std::string BinaryProtocol::reply(const std::string &requestId,
+                                  const std::vector<std::string> &messages) {
+  std::string out = begin(Type::REPLY);
+  BinaryWriter writer(out);
+  writer.writeString(requestId);
+  writer.writeVarint(messages.size());
+  for (const auto &message : messages) {
+    writer.writeString(message);
+  }
+  return out;
+}
+
+std::string BinaryProtocol::taskList(const std::vector<Task> &tasks) {
+  std::string out = begin(Type::TASK_LIST);
+  // Typical tasks encode to a few bytes plus their title
+  out.reserve(16 + tasks.size() * 48);
+  BinaryWriter writer(out);
+  writer.writeVarint(tasks.size());
+  for (const auto &task : tasks) {
+    writeTask(writer, task);
+  }
+  return out;
+}
+
+std::string BinaryProtocol::taskChange(const Task &task, TaskChange change) {
+  std::string out = begin(Type::TASK);
+  BinaryWriter writer(out);
+  writer.writeByte(static_cast<uint8_t>(change));
+  writeTask(writer, task);
+  return out;
+}
+
+std::string BinaryProtocol::taskChanges(const std::vector<Task> &tasks,
+                                        TaskChange change) {
+  std::string out = begin(Type::TASKS);
+  out.reserve(16 + tasks.size() * 48);
+  BinaryWriter writer(out);
+  writer.writeByte(static_cast<uint8_t>(change));
+  writer.writeVarint(tasks.size());
+  for (const auto &task : tasks) {
+    writeTask(writer, task);
+  }
+  return out;
+}
+
+std::string BinaryProtocol::chat(const Chat &chat) {
+  std::string out = begin(Type::CHAT);
+  BinaryWriter writer(out);
+  writer.writeSigned(chat.getMessageId());
+  writer.writeByte(static_cast<uint8_t>(chat.getType()));
+  writer.writeSigned(chat.getSenderId());
+  writer.writeString(chat.getSenderName());
+  writer.writeString(chat.getContent());
+  writer.writeSigned(chat.getTargetUserId());
+  writer.writeSigned(chat.getRelatedTaskId());
+  return out;
+}
+
+std::string BinaryProtocol::presence(const std::string &username,
+                                     const User &user) {
+  std::string out = begin(Type::PRESENCE);
+  BinaryWriter writer(out);
+  writer.writeSigned(user.getUserId());
+  writer.writeString(username);
+  writer.writeByte(static_cast<uint8_t>(user.getRole()));
+  writer.writeByte(user.getOnlineStatus() ? 1 : 0);
+  return out;
+}
+
+std::string BinaryProtocol::event(const std::string &type,
+                                  const std::string &data) {
+  std::string out = begin(Type::EVENT);
+  BinaryWriter writer(out);
+  writer.writeString(type);
+  writer.writeString(data);
+  return out;
+}
+
+void BinaryProtocol::writeTask(BinaryWriter &writer, const Task &task) {
+  // What /list shows; descriptions and comments stay with the HTTP API
+  writer.writeSigned(task.getTaskId());
+  writer.writeString(task.getProjectKey());
+  writer.writeString(task.getTitle());
+  writer.writeByte(static_cast<uint8_t>(task.getStatus()));
+  writer.writeByte(static_cast<uint8_t>(task.getPriority()));
+  writer.writeSigned(task.getAssigneeId());
+  writer.writeSigned(task.getReporterId());
+  writer.writeSigned(std::chrono::duration_cast<std::chrono::seconds>(
+                         task.getDeadline().time_since_epoch())
+                         .count());
+}
+
+bool BinaryProtocol::readType(BinaryReader &reader, Type &type) {
+  return readEnum(reader, Type::TASKS, type) && type != Type(0);
+}
+
+bool BinaryProtocol::readTask(BinaryReader &reader, Task &task) {
+  int id = -1, assignee = -1, reporter = -1;
+  std::string project, title;
+  TaskStatus status;
+  TaskPriority priority;
+  int64_t deadline = 0;
+  if (!reader.readInt(id) || !reader.readString(project) ||
+      !reader.readString(title) ||
+      !readEnum(reader, TaskStatus::BLOCKED, status) ||
+      !readEnum(reader, TaskPriority::CRITICAL, priority) ||
+      !reader.readInt(assignee) || !reader.readInt(reporter) ||
+      !reader.readSigned(deadline)) {
+    return false;
+  }
+  task = Task(id, title, "", reporter, project);
+  task.setStatus(status);
+  task.setPriority(priority);
+  task.setAssignee(assignee);
+  task.setDeadline(std::chrono::system_clock::time_point(
+      std::chrono::seconds(deadline)));
+  return true;
+}
+
+bool BinaryProtocol::readChat(BinaryReader &reader, Chat &chat) {
+  int id = -1, sender = -1, target = -1, relatedTask = -1;
+  MessageType type;
+  std::string senderName, content;
+  if (!reader.readInt(id) || !readEnum(reader, MessageType::PRIVATE, type) ||
+      !reader.readInt(sender) || !reader.readString(senderName) ||
+      !reader.readString(content) || !reader.readInt(target) ||
+      !reader.readInt(relatedTask)) {
+    return false;
+  }
+  chat = Chat(id, sender, senderName, content, type);
+  chat.setTargetUser(target);
+  chat.setRelatedTask(relatedTask);
+  return true;
+}
+
+bool BinaryProtocol::readPresence(BinaryReader &reader, User &user) {
+  int id = -1;
+  std::string username;
+  UserRole role;
+  uint8_t online = 0;
+  if (!reader.readInt(id) || !reader.readString(username) ||
+      !readEnum(reader, UserRole::TESTER, role) || !reader.readByte(online)) {
+    return false;
+  }
+  user = User(id, username, "", role);
+  user.setOnlineStatus(online != 0);
+  return true;
+}
@@ -3,73 +3,130 @@
 #include <fstream>
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 
-ChatManager::ChatManager() : nextMessageId(1) {
+ChatManager::ChatManager()
+    : teamChannel(CHANNEL_HISTORY_SIZE), systemChannel(CHANNEL_HISTORY_SIZE),
+      taskChannel(CHANNEL_HISTORY_SIZE), firstMessageId(1), nextMessageId(1) {
     loadFromFile();
+    firstMessageId = nextMessageId;
 }
 
-int ChatManager::sendMessage(int senderId, const std::string& senderName, const std::string& content, MessageType type) {
-    std::lock_guard<std::mutex> lock(chatMutex);
-    
-    Chat newMessage(nextMessageId, senderId, senderName, content, type);
-    messages.push_back(newMessage);
+std::pair<int, int> ChatManager::conversationKey(int userId1, int userId2) {
+    return std::make_pair(std::min(userId1, userId2), std::max(userId1, userId2));
+}
+
+const Chat& ChatManager::messageById(int messageId) const {
+    return messages[messageId - firstMessageId];
+}
+
+const RingBuffer<int>& ChatManager::channelBuffer(ChatChannel channel) const {
+    switch (channel) {
+        case ChatChannel::SYSTEM: return systemChannel;
+        case ChatChannel::TASK_UPDATES: return taskChannel;
+        case ChatChannel::TEAM:
+        default: return teamChannel;
+    }
+}
+
+MessageType ChatManager::channelType(ChatChannel channel) {
+    switch (channel) {
+        case ChatChannel::SYSTEM: return MessageType::SYSTEM;
+        case ChatChannel::TASK_UPDATES: return MessageType::TASK_UPDATE;
+        case ChatChannel::TEAM:
+        default: return MessageType::GENERAL;
+    }
+}
+
+void ChatManager::selectPage(const int*& first, const int*& last, size_t limit, int afterId) {
+    if (afterId > 0) {
+        // IDs are ascending, so the resume point is a binary search
+        first = std::upper_bound(first, last, afterId);
+        if (limit > 0 && static_cast<size_t>(last - first) > limit) {
+            last = first + limit;
+        }
+    } else if (limit > 0 && static_cast<size_t>(last - first) > limit) {
+        first = last - limit;
+    }
+}
+
+std::vector<Chat> ChatManager::collect(const std::vector<int>& ids, size_t limit, int afterId) const {
+    std::vector<Chat> result;
+    const int* first = ids.data();
+    const int* last = ids.data() + ids.size();
+    selectPage(first, last, limit, afterId);
     
+    result.reserve(last - first);
+    for (const int* id = first; id != last; ++id) {
+        result.push_back(messageById(*id));
+    }
+    return result;
+}
+
+// Appends a message built with nextMessageId and updates the lookup indexes
+int ChatManager::storeMessage(Chat& message) {
     int messageId = nextMessageId;
+    messages.push_back(message);
     nextMessageId++;
     
+    switch (message.getType()) {
+        case MessageType::PRIVATE:
+            conversationIndex[conversationKey(message.getSenderId(), message.getTargetUserId())].push_back(messageId);
+            break;
+        case MessageType::GENERAL: teamChannel.push(messageId); break;
+        case MessageType::SYSTEM: systemChannel.push(messageId); break;
+        case MessageType::TASK_UPDATE: taskChannel.push(messageId); break;
+    }
+    messageArrived.notify_all();
+    if (message.getRelatedTaskId() != -1) {
+        taskMessageIndex[message.getRelatedTaskId()].push_back(messageId);
+    }
+    if (messageListener) {
+        messageListener(message);
+    }
+    
     saveToFile();
     return messageId;
 }
 
+int ChatManager::sendMessage(int senderId, const std::string& senderName, const std::string& content, MessageType type) {
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
+    
+    Chat newMessage(nextMessageId, senderId, senderName, content, type);
+    return storeMessage(newMessage);
+}
+
 int ChatManager::sendPrivateMessage(int senderId, const std::string& senderName, int targetUserId, const std::string& content) {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
     
     Chat newMessage(nextMessageId, senderId, senderName, content, MessageType::PRIVATE);
     newMessage.setTargetUser(targetUserId);
-    messages.push_back(newMessage);
-    
-    int messageId = nextMessageId;
-    nextMessageId++;
-    
-    saveToFile();
-    return messageId;
+    return storeMessage(newMessage);
 }
 
 int ChatManager::sendTaskUpdate(int senderId, const std::string& senderName, int taskId, const std::string& update) {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
     
     Chat newMessage(nextMessageId, senderId, senderName, update, MessageType::TASK_UPDATE);
     newMessage.setRelatedTask(taskId);
-    messages.push_back(newMessage);
-    
-    int messageId = nextMessageId;
-    nextMessageId++;
-    
-    saveToFile();
-    return messageId;
+    return storeMessage(newMessage);
 }
 
 int ChatManager::sendSystemMessage(const std::string& content) {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
     
     Chat newMessage(nextMessageId, 0, "System", content, MessageType::SYSTEM);
-    messages.push_back(newMessage);
-    
-    int messageId = nextMessageId;
-    nextMessageId++;
-    
-    saveToFile();
-    return messageId;
+    return storeMessage(newMessage);
 }
 
 std::vector<Chat> ChatManager::getAllMessages() const {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
     return messages;
 }
 
 std::vector<Chat> ChatManager::getRecentMessages(int limit) const {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
     std::vector<Chat> result;
     
     int start = std::max(0, static_cast<int>(messages.size()) - limit);
@@ -79,57 +136,105 @@ std::vector<Chat> ChatManager::getRecentMessages(int limit) const {
     return result;
 }
 
-std::vector<Chat> ChatManager::getMessagesByUser(int userId) const {
-    std::lock_guard<std::mutex> lock(chatMutex);
+std::vector<Chat> ChatManager::getRecentMessages(ChatChannel channel, size_t limit) const {
     std::vector<Chat> result;
+    visitRecentMessages(channel, limit, [&result](const Chat& message) {
+        result.push_back(message);
+    });
+    return result;
+}
+
+void ChatManager::visitRecentMessages(ChatChannel channel, size_t limit, const std::function<void(const Chat&)>& visitor, int afterId) const {
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
     
-    for (const auto& message : messages) {
-        if (message.getSenderId() == userId) {
-            result.push_back(message);
+    const RingBuffer<int>& buffer = channelBuffer(channel);
+    size_t count = 0;
+    const int* first = buffer.tail(buffer.capacity(), count);
+    const int* last = first + count;
+    if (afterId > 0 && count == buffer.capacity() && afterId < *first) {
+        // The buffer may have evicted messages the reader has not seen;
+        // IDs index the log directly, so scan forward from afterId
+        MessageType type = channelType(channel);
+        size_t visited = 0;
+        size_t start = afterId >= firstMessageId ? static_cast<size_t>(afterId + 1 - firstMessageId) : 0;
+        for (size_t i = start; i < messages.size() && (limit == 0 || visited < limit); ++i) {
+            if (messages[i].getType() == type) {
+                visitor(messages[i]);
+                visited++;
+            }
         }
+        return;
     }
-    return result;
+    selectPage(first, last, limit, afterId);
+    
+    for (const int* id = first; id != last; ++id) {
+        visitor(messageById(*id));
+    }
+}
+
+int ChatManager::getLatestMessageId() const {
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
+    return nextMessageId - 1;
+}
+
+bool ChatManager::waitForMessage(int afterId, std::chrono::steady_clock::time_point deadline) const {
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
+    return messageArrived.wait_until(lock, deadline, [this, afterId]() {
+        return nextMessageId - 1 > afterId;
+    });
+}
+
+void ChatManager::setMessageListener(std::function<void(const Chat&)> listener) {
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
+    messageListener = std::move(listener);
 }
 
-std::vector<Chat> ChatManager::getTaskMessages(int taskId) const {
-    std::lock_guard<std::mutex> lock(chatMutex);
+std::vector<Chat> ChatManager::getMessagesByUser(int userId) const {
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
     std::vector<Chat> result;
     
     for (const auto& message : messages) {
-        if (message.getRelatedTaskId() == taskId) {
+        if (message.getSenderId() == userId) {
             result.push_back(message);
         }
     }
     return result;
 }
 
-std::vector<Chat> ChatManager::getPrivateMessages(int userId1, int userId2) const {
-    std::lock_guard<std::mutex> lock(chatMutex);
-    std::vector<Chat> result;
+std::vector<Chat> ChatManager::getTaskMessages(int taskId, size_t limit, int afterId) const {
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
     
-    for (const auto& message : messages) {
-        if (message.getType() == MessageType::PRIVATE &&
-            ((message.getSenderId() == userId1 && message.getTargetUserId() == userId2) ||
-             (message.getSenderId() == userId2 && message.getTargetUserId() == userId1))) {
-            result.push_back(message);
-        }
+    auto it = taskMessageIndex.find(taskId);
+    if (it == taskMessageIndex.end()) {
+        return std::vector<Chat>();
     }
-    return result;
+    return collect(it->second, limit, afterId);
+}
+
+std::vector<Chat> ChatManager::getPrivateMessages(int userId1, int userId2, size_t limit, int afterId) const {
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
+    
+    // Thread is kept in send order, so the latest N are a tail read
+    auto it = conversationIndex.find(conversationKey(userId1, userId2));
+    if (it == conversationIndex.end()) {
+        return std::vector<Chat>();
+    }
+    return collect(it->second, limit, afterId);
 }
 
 void ChatManager::addUserConnection(int userId, int socketId) {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
     userConnections[userId].push_back(socketId);
 }
 
 void ChatManager::removeUserConnection(int userId, int socketId) {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::lock_guard<std::shared_mutex> lock(chatMutex);
     auto& connections = userConnections[userId];
     connections.erase(std::remove(connections.begin(), connections.end(), socketId), connections.end());
 }
 
 std::vector<int> ChatManager::getUserSockets(int userId) const {
-    std::lock_guard<std::mutex> lock(chatMutex);
+    std::shared_lock<std::shared_mutex> lock(chatMutex);
     auto it = userConnections.find(userId);
     return (it != userConnections.end()) ? it->second : std::vector<int>();
 }
@@ -0,0 +1,88 @@
+#include "../include/DetachableServer.hpp"
+
+namespace {
+// Set by detach() while this thread runs the handler of that request
+thread_local DetachableServer::Receiver pendingReceiver;
+
+// The connection's stream, going quiet once the request is detached so
+// that httplib's own response never reaches the socket
+class DetachableStream : public httplib::Stream {
+public:
+  explicit DetachableStream(httplib::Stream &stream) : inner(stream) {}
+
+  bool is_readable() const override { return inner.is_readable(); }
+  bool wait_readable() const override { return inner.wait_readable(); }
+  bool wait_writable() const override { return inner.wait_writable(); }
+  ssize_t read(char *ptr, size_t size) override {
+    return inner.read(ptr, size);
+  }
+  ssize_t write(const char *ptr, size_t size) override {
+    if (pendingReceiver) {
+      return static_cast<ssize_t>(size);
+    }
+    return inner.write(ptr, size);
+  }
+  void get_remote_ip_and_port(std::string &ip, int &port) const override {
+    inner.get_remote_ip_and_port(ip, port);
+  }
+  void get_local_ip_and_port(std::string &ip, int &port) const override {
+    inner.get_local_ip_and_port(ip, port);
+  }
+  socket_t socket() const override { return inner.socket(); }
+  time_t duration() const override { return inner.duration(); }
+
+private:
+  httplib::Stream &inner;
+};
+} // namespace
+
+void DetachableServer::detach(Receiver receiver) {
+  pendingReceiver = std::move(receiver);
+}
+
+bool DetachableServer::listen(const std::string &host, int port) {
+  if (!bind_to_port(host, port)) {
+    return false;
+  }
+  // Listening again only resizes the queue; on failure httplib's stays
+  SocketAbstraction::listenSocket(svr_sock_, LISTEN_BACKLOG);
+  return listen_after_bind();
+}
+
+bool DetachableServer::process_and_close_socket(socket_t sock) {
+  // As httplib::Server's, except that a detached request ends the loop
+  // and leaves the socket open for its receiver
+  std::string remoteAddr;
+  int remotePort = 0;
+  httplib::detail::get_remote_ip_and_port(sock, remoteAddr, remotePort);
+  std::string localAddr;
+  int localPort = 0;
+  httplib::detail::get_local_ip_and_port(sock, localAddr, localPort);
+
+  Receiver receiver;
+  bool ok = httplib::detail::process_server_socket(
+      svr_sock_, sock, keep_alive_max_count_, keep_alive_timeout_sec_,
+      read_timeout_sec_, read_timeout_usec_, write_timeout_sec_,
+      write_timeout_usec_,
+      [&](httplib::Stream &stream, bool closeConnection,
+          bool &connectionClosed) {
+        DetachableStream detachable(stream);
+        bool handled = process_request(detachable, remoteAddr, remotePort,
+                                       localAddr, localPort, closeConnection,
+                                       connectionClosed, nullptr);
+        if (pendingReceiver) {
+          receiver = std::move(pendingReceiver);
+          pendingReceiver = nullptr;
+          connectionClosed = true;
+        }
+        return handled;
+      });
+
+  if (receiver) {
+    receiver(sock);
+    return ok;
+  }
+  httplib::detail::shutdown_socket(sock);
+  httplib::detail::close_socket(sock);
+  return ok;
+}
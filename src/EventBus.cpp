@@ -0,0 +1,264 @@
+#include "../include/EventBus.hpp"
+#include "../include/Framing.hpp"
+#include "../include/NetworkUtils.hpp"
+
+EventBus::EventBus(TaskManager &tm, ChatManager &cm, UserManager &um,
+                   PubSub &ps)
+    : taskManager(tm), chatManager(cm), userManager(um), pubSub(ps),
+      running(false), lastSeq(0) {}
+
+EventBus::~EventBus() { stop(); }
+
+void EventBus::start() {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (running) {
+      return;
+    }
+    running = true;
+  }
+  dispatcher = std::thread(&EventBus::dispatchLoop, this);
+
+  // Listeners run under the managers' locks: copy and queue, nothing else
+  taskManager.setChangeListener([this](const Task &task, TaskChange change) {
+    post({{PubSub::TOPIC_TASKS, PubSub::taskTopic(task.getTaskId())},
+          [task, change](PubSubMessage &message) {
+            message.type = "task";
+            message.data = NetworkUtils::taskToJSON(task);
+            message.key = "task:" + std::to_string(task.getTaskId()) + ":" +
+                          std::to_string(static_cast<int>(change));
+            message.encoded[static_cast<size_t>(Wire::TEXT)] =
+                describeTaskChange(task, change);
+            if (change != TaskChange::LOADED) {
+              message.encoded[static_cast<size_t>(Wire::BINARY)] =
+                  BinaryProtocol::taskChange(task, change);
+            }
+          }});
+  });
+  taskManager.setBatchChangeListener(
+      [this](const std::vector<Task> &tasks, TaskChange change) {
+        std::vector<std::string> topics{PubSub::TOPIC_TASKS};
+        topics.reserve(tasks.size() + 1);
+        for (const auto &task : tasks) {
+          topics.push_back(PubSub::taskTopic(task.getTaskId()));
+        }
+        post({std::move(topics), [tasks, change](PubSubMessage &message) {
+                message.type = "tasks";
+                message.data = "[";
+                for (size_t i = 0; i < tasks.size(); ++i) {
+                  if (i > 0) {
+                    message.data += ",";
+                  }
+                  message.data += NetworkUtils::taskToJSON(tasks[i]);
+                }
+                message.data += "]";
+                message.encoded[static_cast<size_t>(Wire::TEXT)] =
+                    describeTaskChanges(tasks, change);
+                message.encoded[static_cast<size_t>(Wire::BINARY)] =
+                    BinaryProtocol::taskChanges(tasks, change);
+              }});
+      });
+  chatManager.setMessageListener([this](const Chat &chat) {
+    std::vector<std::string> topics;
+    if (chat.getType() == MessageType::PRIVATE) {
+      // Only the two participants see a private message
+      topics = {PubSub::userTopic(chat.getSenderId()),
+                PubSub::userTopic(chat.getTargetUserId())};
+    } else {
+      topics = {PubSub::TOPIC_CHAT};
+    }
+    post({std::move(topics), [chat](PubSubMessage &message) {
+            bool isPrivate = chat.getType() == MessageType::PRIVATE;
+            message.type = isPrivate ? "private" : "chat";
+            message.data = NetworkUtils::chatToJSON(chat);
+            message.actorId = chat.getSenderId();
+            message.encoded[static_cast<size_t>(Wire::TEXT)] =
+                describeMessage(chat);
+            message.encoded[static_cast<size_t>(Wire::BINARY)] =
+                BinaryProtocol::chat(chat);
+          }});
+  });
+  userManager.setPresenceListener(
+      [this](const std::string &username, const User &user) {
+        post({{PubSub::TOPIC_PRESENCE},
+              [username, user](PubSubMessage &message) {
+                message.type = "presence";
+                message.data = NetworkUtils::userToJSON(user, username);
+                message.key = "presence:" + username;
+                message.actorId = user.getUserId();
+                message.encoded[static_cast<size_t>(Wire::TEXT)] =
+                    describePresence(username, user);
+                message.encoded[static_cast<size_t>(Wire::BINARY)] =
+                    BinaryProtocol::presence(username, user);
+              }});
+      });
+}
+
+void EventBus::stop() {
+  taskManager.setChangeListener(nullptr);
+  taskManager.setBatchChangeListener(nullptr);
+  chatManager.setMessageListener(nullptr);
+  userManager.setPresenceListener(nullptr);
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    running = false;
+  }
+  queueReady.notify_one();
+  if (dispatcher.joinable()) {
+    dispatcher.join();
+  }
+}
+
+void EventBus::setEncoder(Wire format, Encoder encoder) {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  encoders[static_cast<size_t>(format)] = std::move(encoder);
+}
+
+void EventBus::publish(std::vector<std::string> topics, const std::string &type,
+                       const std::string &data, int actorId) {
+  post({std::move(topics), [type, data, actorId](PubSubMessage &message) {
+          message.type = type;
+          message.data = data;
+          message.actorId = actorId;
+          message.encoded[static_cast<size_t>(Wire::BINARY)] =
+              BinaryProtocol::event(type, data);
+        }});
+}
+
+void EventBus::post(PendingEvent event) {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    pending.push_back(std::move(event));
+  }
+  queueReady.notify_one();
+}
+
+void EventBus::dispatchLoop() {
+  std::vector<PendingEvent> batch;
+  std::array<Encoder, WIRE_FORMATS> formats;
+  std::vector<PubSub::Delivery> deliveries;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      queueReady.wait(lock, [this] { return !running || !pending.empty(); });
+      if (pending.empty()) {
+        break; // stopped and drained
+      }
+      batch.swap(pending);
+      formats = encoders;
+    }
+
+    // Encode each event once per wire format, then fan out the whole batch
+    deliveries.clear();
+    deliveries.reserve(batch.size());
+    for (auto &event : batch) {
+      auto message = std::make_shared<PubSubMessage>();
+      message->seq = ++lastSeq;
+      event.render(*message);
+      // TCP subscribers queue the frames themselves, not a copy per socket
+      std::string &text = message->encoded[static_cast<size_t>(Wire::TEXT)];
+      if (!text.empty()) {
+        text = Framing::encode(text);
+      }
+      std::string &binary =
+          message->encoded[static_cast<size_t>(Wire::BINARY)];
+      if (!binary.empty()) {
+        std::string frame;
+        Framing::encodeBinary(frame, binary);
+        binary.swap(frame);
+      }
+      for (size_t i = 0; i < WIRE_FORMATS; ++i) {
+        // TEXT and BINARY were filled in by render
+        if (formats[i] && message->encoded[i].empty()) {
+          message->encoded[i] = formats[i](*message);
+        }
+      }
+      deliveries.push_back({std::move(event.topics), std::move(message)});
+    }
+    batch.clear();
+    pubSub.publishBatch(deliveries);
+  }
+}
+
+std::string EventBus::describeTaskChange(const Task &task, TaskChange change) {
+  std::string id = std::to_string(task.getTaskId());
+  switch (change) {
+  case TaskChange::CREATED:
+    return "[TASK] Created task " + task.getProjectKey() + "-" + id + ": " +
+           task.getTitle() + " (Deadline: " + task.getDeadlineString() + ")";
+  case TaskChange::STATUS:
+    return "[TASK] Task " + id + " status updated to " +
+           task.getStatusString();
+  case TaskChange::PRIORITY:
+    return "[TASK] Task " + id + " priority updated to " +
+           task.getPriorityString();
+  case TaskChange::ASSIGNED:
+    return "[TASK] Task " + id + " assigned to user " +
+           std::to_string(task.getAssigneeId());
+  case TaskChange::COMMENTED:
+    return "[TASK] Comment added to task " + id;
+  case TaskChange::LOADED:
+    break;
+  }
+  return "";
+}
+
+std::string EventBus::describeTaskChanges(const std::vector<Task> &tasks,
+                                          TaskChange change) {
+  if (tasks.empty()) {
+    return "";
+  }
+  // IDs as ranges ("1-500, 502"); tasks arrive sorted by ID
+  std::string ids;
+  for (size_t i = 0; i < tasks.size();) {
+    size_t last = i;
+    while (last + 1 < tasks.size() &&
+           tasks[last + 1].getTaskId() == tasks[last].getTaskId() + 1) {
+      ++last;
+    }
+    ids += (i > 0 ? ", " : "") + std::to_string(tasks[i].getTaskId());
+    if (last > i) {
+      ids += "-" + std::to_string(tasks[last].getTaskId());
+    }
+    i = last + 1;
+  }
+  std::string subject = (tasks.size() == 1 ? "Task " : "Tasks ") + ids;
+  switch (change) {
+  case TaskChange::CREATED:
+    return "[TASK] Created " + std::to_string(tasks.size()) + " task(s): " +
+           ids;
+  case TaskChange::STATUS:
+    return "[TASK] " + subject + " status updated to " +
+           tasks.front().getStatusString();
+  case TaskChange::PRIORITY:
+    return "[TASK] " + subject + " priority updated to " +
+           tasks.front().getPriorityString();
+  case TaskChange::ASSIGNED:
+    return "[TASK] " + subject + " assigned to user " +
+           std::to_string(tasks.front().getAssigneeId());
+  case TaskChange::COMMENTED:
+    return "[TASK] Comments added to " + subject;
+  case TaskChange::LOADED:
+    break;
+  }
+  return "";
+}
+
+std::string EventBus::describeMessage(const Chat &chat) {
+  switch (chat.getType()) {
+  case MessageType::GENERAL:
+    return "[" + chat.getSenderName() + "] " + chat.getContent();
+  case MessageType::PRIVATE:
+    return "[PM from " + chat.getSenderName() + "] " + chat.getContent();
+  default:
+    // Task updates and system messages duplicate the task and presence
+    // notices CLI clients already get
+    return "";
+  }
+}
+
+std::string EventBus::describePresence(const std::string &username,
+                                       const User &user) {
+  return "[SYSTEM] " + username +
+         (user.getOnlineStatus() ? " is now online" : " disconnected");
+}
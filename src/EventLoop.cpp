@@ -0,0 +1,123 @@
+#include "../include/EventLoop.hpp"
+#include <algorithm>
+#include <iostream>
+
+EventLoop::~EventLoop() { stop(); }
+
+bool EventLoop::start(const std::string &name) {
+  if (!poller.isValid()) {
+    std::cerr << "ERROR: " << name << " could not create its event poller"
+              << std::endl;
+    return false;
+  }
+  loopName = name;
+  running = true;
+  thread = std::thread(&EventLoop::run, this);
+  return true;
+}
+
+void EventLoop::stop() {
+  if (!running.exchange(false)) {
+    return;
+  }
+  poller.wakeup();
+  if (thread.joinable()) {
+    thread.join();
+  }
+  std::lock_guard<std::mutex> lock(postedMutex);
+  posted.clear();
+}
+
+void EventLoop::post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(postedMutex);
+    posted.push_back(std::move(task));
+  }
+  poller.wakeup();
+}
+
+bool EventLoop::watch(SocketHandle socket, SocketCallback callback) {
+  if (!poller.add(socket)) {
+    return false;
+  }
+  sockets[socket] = std::make_shared<SocketCallback>(std::move(callback));
+  return true;
+}
+
+void EventLoop::unwatch(SocketHandle socket) {
+  if (sockets.erase(socket) > 0) {
+    poller.remove(socket);
+  }
+}
+
+void EventLoop::setWriteInterest(SocketHandle socket, bool enabled) {
+  poller.setWriteInterest(socket, enabled);
+}
+
+bool EventLoop::send(SocketHandle socket, WriteBatch &batch) {
+  while (!batch.empty()) {
+    size_t count = 0;
+    const IoSlice *slices = batch.slices(count);
+    int sent = SocketAbstraction::sendVector(
+        socket, slices, std::min(count, WriteBatch::MAX_FRAMES));
+    if (sent < 0 && SocketAbstraction::wouldBlock()) {
+      return true; // the rest waits for the next writable event
+    }
+    if (sent <= 0) {
+      batch.clear();
+      return false;
+    }
+    batch.consume(sent);
+  }
+  return true;
+}
+
+int EventLoop::waitTimeout() const {
+  // At least once a second, which also bounds a missed wakeup on Windows
+  auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+      wheel.timeUntilNext(std::chrono::steady_clock::now()));
+  return static_cast<int>(
+      std::min<std::chrono::milliseconds::rep>(wait.count(), 1000));
+}
+
+void EventLoop::run() {
+  std::vector<EventPoller::Event> events;
+  std::vector<std::function<void()>> work;
+  while (running) {
+    if (poller.wait(events, waitTimeout()) < 0) {
+      std::cerr << loopName << " event loop wait failed: "
+                << SocketAbstraction::getLastError() << std::endl;
+      break;
+    }
+    loopTime = std::chrono::steady_clock::now();
+
+    for (const auto &event : events) {
+      auto it = sockets.find(event.socket);
+      if (it == sockets.end()) {
+        continue; // unwatched by an earlier callback in this pass
+      }
+      auto callback = it->second;
+      (*callback)(event.readable, event.writable);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(postedMutex);
+      work.swap(posted);
+    }
+    for (auto &task : work) {
+      task();
+    }
+    work.clear();
+
+    wheel.advance(loopTime);
+  }
+
+  // Work posted before stop(), such as an owner closing its sockets
+  {
+    std::lock_guard<std::mutex> lock(postedMutex);
+    work.swap(posted);
+  }
+  for (auto &task : work) {
+    task();
+  }
+}
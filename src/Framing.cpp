@@ -0,0 +1,157 @@
+#include "../include/Framing.hpp"
+#include <cstring>
+
+void Framing::encode(std::string &out, const std::string &payload) {
+  out.reserve(out.size() + payload.size() + 1);
+  for (char c : payload) {
+    switch (c) {
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    default:
+      out += c;
+    }
+  }
+  out += '\n';
+}
+
+std::string Framing::encode(const std::string &payload) {
+  std::string out;
+  encode(out, payload);
+  return out;
+}
+
+void Framing::encodeBinary(std::string &out, const std::string &payload) {
+  out.reserve(out.size() + payload.size() + MAX_VARINT_SIZE);
+  putVarint(out, payload.size());
+  out += payload;
+}
+
+void Framing::putVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+size_t Framing::getVarint(const char *data, size_t length, uint64_t &value) {
+  value = 0;
+  for (size_t i = 0; i < length && i < MAX_VARINT_SIZE; ++i) {
+    uint8_t byte = static_cast<uint8_t>(data[i]);
+    if (i == MAX_VARINT_SIZE - 1 && byte > 1) {
+      return 0; // bits past the 64th
+    }
+    value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+void FrameReader::append(const char *data, size_t length) {
+  // Drop consumed bytes before growing, so the buffer stays about one
+  // frame long however long the connection lives
+  if (start > 0 && start >= buffer.size() / 2) {
+    buffer.erase(0, start);
+    start = 0;
+  }
+  buffer.append(data, length);
+}
+
+bool FrameReader::next(std::string &frame) {
+  return mode == Mode::LINES ? nextLine(frame) : nextPrefixed(frame);
+}
+
+bool FrameReader::nextLine(std::string &frame) {
+  const char *begin = buffer.data() + start;
+  size_t available = buffer.size() - start;
+  const char *end = static_cast<const char *>(
+      std::memchr(begin + scan, '\n', available - scan));
+  if (end == nullptr) {
+    scan = available;
+    return false;
+  }
+
+  size_t length = end - begin;
+  if (length > 0 && begin[length - 1] == '\r') {
+    --length;
+  }
+  frame.clear();
+  frame.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    if (begin[i] != '\\' || i + 1 == length) {
+      frame += begin[i];
+      continue;
+    }
+    char escaped = begin[++i];
+    switch (escaped) {
+    case 'n':
+      frame += '\n';
+      break;
+    case 'r':
+      frame += '\r';
+      break;
+    case '\\':
+      frame += '\\';
+      break;
+    default:
+      // Not an escape we produce: keep it as typed
+      frame += '\\';
+      frame += escaped;
+    }
+  }
+
+  consume((end - begin) + 1);
+  return true;
+}
+
+bool FrameReader::nextPrefixed(std::string &frame) {
+  if (invalid) {
+    return false;
+  }
+  const char *begin = buffer.data() + start;
+  size_t available = buffer.size() - start;
+  uint64_t length = 0;
+  size_t header = Framing::getVarint(begin, available, length);
+  if (header == 0) {
+    invalid = available >= Framing::MAX_VARINT_SIZE;
+    return false;
+  }
+  if (length > MAX_FRAME_SIZE) {
+    invalid = true;
+    return false;
+  }
+  if (available - header < length) {
+    return false;
+  }
+  frame.assign(begin + header, length);
+  consume(header + length);
+  return true;
+}
+
+void FrameReader::consume(size_t length) {
+  start += length;
+  scan = 0;
+  if (start == buffer.size()) {
+    buffer.clear();
+    start = 0;
+  }
+}
+
+bool FrameReader::overflowed() const {
+  return invalid ||
+         (mode == Mode::LINES && buffer.size() - start > MAX_FRAME_SIZE);
+}
+
+void FrameReader::setMode(Mode m) {
+  mode = m;
+  scan = 0;
+}
@@ -1,13 +1,207 @@
 #include "../include/HTTPServer.hpp"
+#include "../include/JsonReader.hpp"
+#include "../include/JsonWriter.hpp"
 #include "../include/NetworkUtils.hpp"
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <climits>
 #include <chrono>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 
-HTTPServer::HTTPServer(TaskManager &tm, ChatManager &cm,
-                       std::map<std::string, User> &u, std::mutex &m)
-    : taskManager(tm), chatManager(cm), users(u), serverMutex(m) {}
+namespace {
+// Sent on every response, including those written by HTTPStreams
+const httplib::Headers CORS_HEADERS = {
+    {"Access-Control-Allow-Origin", "*"},
+    {"Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS"},
+    {"Access-Control-Allow-Headers", "Content-Type, Authorization"}};
+
+std::string headerLines(const httplib::Headers &headers) {
+  std::string lines;
+  for (const auto &header : headers) {
+    lines += header.first + ": " + header.second + "\r\n";
+  }
+  return lines;
+}
+
+// Whether the client keeps the connection open after this request
+bool keepsAlive(const httplib::Request &req) {
+  std::string connection = req.get_header_value("Connection");
+  std::transform(connection.begin(), connection.end(), connection.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (req.version == "HTTP/1.0") {
+    return connection == "keep-alive";
+  }
+  return connection != "close";
+}
+
+// When the connection a pool thread is about to serve was accepted; reset
+// once its first request has been checked against the queue-wait limit
+thread_local std::chrono::steady_clock::time_point connectionQueuedAt;
+// Admission slot held by the request this thread is handling
+thread_local AdmissionControl *heldSlot = nullptr;
+
+// httplib's pool, recording how long each connection waited for a thread
+class TimedThreadPool : public httplib::TaskQueue {
+public:
+  explicit TimedThreadPool(size_t threads) : pool(threads) {}
+
+  bool enqueue(std::function<void()> fn) override {
+    auto queuedAt = std::chrono::steady_clock::now();
+    return pool.enqueue([fn, queuedAt] {
+      connectionQueuedAt = queuedAt;
+      fn();
+    });
+  }
+
+  void shutdown() override { pool.shutdown(); }
+
+private:
+  httplib::ThreadPool pool;
+};
+
+// Fields of a new task; title is required, the rest keep their defaults
+bool parseNewTask(const JsonValue &object, NewTask &task, std::string &error) {
+  if (!object["title"].get(task.title) || task.title.empty()) {
+    error = "Title is required";
+    return false;
+  }
+  if (!object["description"].getOptional(task.description) ||
+      !object["deadlineDays"].getOptional(task.deadlineDays)) {
+    error = "Invalid description or deadlineDays";
+    return false;
+  }
+  return true;
+}
+
+// One /api/batch operation, named after the matching api.js call
+bool parseOperation(const JsonValue &object, TaskOperation &op,
+                    std::string &error) {
+  std::string name, value;
+  if (!object.isObject()) {
+    error = "Operation must be an object";
+    return false;
+  }
+  if (!object["op"].get(name)) {
+    error = "op is required";
+    return false;
+  }
+  if (name == "createTask") {
+    op.kind = TaskOperation::Kind::CREATE;
+    return parseNewTask(object, op.newTask, error);
+  }
+  if (name != "updateTaskStatus" && name != "updateTaskPriority" &&
+      name != "assignTask" && name != "addTaskComment") {
+    error = "Unknown op " + name;
+    return false;
+  }
+  if (!object["taskId"].get(op.taskId) && !object["taskRef"].get(op.taskRef)) {
+    error = "taskId or taskRef is required";
+    return false;
+  }
+  if (name == "updateTaskStatus") {
+    op.kind = TaskOperation::Kind::SET_STATUS;
+    if (!object["status"].get(value) || !Task::parseStatus(value, op.status)) {
+      error = "Invalid status";
+      return false;
+    }
+  } else if (name == "updateTaskPriority") {
+    op.kind = TaskOperation::Kind::SET_PRIORITY;
+    if (!object["priority"].get(value) ||
+        !Task::parsePriority(value, op.priority)) {
+      error = "Invalid priority";
+      return false;
+    }
+  } else if (name == "assignTask") {
+    op.kind = TaskOperation::Kind::ASSIGN;
+    if (!object["assigneeId"].get(op.assigneeId)) {
+      error = "Assignee ID is required";
+      return false;
+    }
+  } else {
+    op.kind = TaskOperation::Kind::COMMENT;
+    if (!object["comment"].get(op.comment)) {
+      error = "Comment is required";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Typical tasks serialize to about 250 bytes, chat messages to 200
+constexpr size_t TASK_JSON_SIZE = 256;
+constexpr size_t CHAT_JSON_SIZE = 200;
+
+void writeTasks(JsonWriter &json, const std::vector<Task> &tasks) {
+  json.beginArray();
+  for (const auto &task : tasks) {
+    NetworkUtils::writeTask(json, task);
+  }
+  json.endArray();
+}
+
+// {"success":true,"message":...,["version":...,]"data":[tasks]}
+std::string tasksResponse(const std::string &message,
+                          const std::vector<Task> &tasks,
+                          const uint64_t *version) {
+  std::string out;
+  out.reserve(64 + message.size() + tasks.size() * TASK_JSON_SIZE);
+  JsonWriter json(out);
+  json.beginObject().field("success", true).field("message", message);
+  if (version != nullptr) {
+    json.field("version", *version);
+  }
+  json.key("data");
+  writeTasks(json, tasks);
+  json.endObject();
+  return out;
+}
+
+void releaseSlot() {
+  if (heldSlot != nullptr) {
+    heldSlot->release();
+    heldSlot = nullptr;
+  }
+}
+} // namespace
+
+HTTPServer::HTTPServer(TaskManager &tm, ChatManager &cm, UserManager &um,
+                       PubSub &ps, EventBus &bus,
+                       AdmissionControl::Limits admissionLimits)
+    : taskManager(tm), chatManager(cm), userManager(um), pubSub(ps),
+      eventBus(bus),
+      streams(ps, headerLines(CORS_HEADERS),
+              [this](SocketHandle socket) { resumeConnection(socket); }),
+      webSocketServer(cm, um, ps, bus,
+                      [this](const std::string &token, std::string &username) {
+                        return validateToken(token, username);
+                      }),
+      admission(admissionLimits) {
+  server.new_task_queue = [this] {
+    auto *pool = new TimedThreadPool(HTTP_WORKER_THREADS);
+    workers = pool;
+    return pool;
+  };
+
+  // SSE frames are built once per event by the bus, not once per stream
+  eventBus.setEncoder(Wire::SSE, [](const PubSubMessage &message) {
+    return "id: " + std::to_string(message.seq) + "\nevent: " + message.type +
+           "\ndata: " + message.data + "\n\n";
+  });
+  sessionReaper = std::thread(&HTTPServer::reapSessions, this);
+}
+
+HTTPServer::~HTTPServer() {
+  {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    stoppingReaper = true;
+  }
+  sessionsChanged.notify_one();
+  sessionReaper.join();
+  eventBus.setEncoder(Wire::SSE, nullptr);
+}
 
 std::string HTTPServer::generateToken(const std::string &username) {
   auto now = std::chrono::system_clock::now();
@@ -22,7 +216,8 @@ bool HTTPServer::validateToken(const std::string &token,
   std::lock_guard<std::mutex> lock(sessionMutex);
   auto it = sessions.find(token);
   if (it != sessions.end()) {
-    username = it->second;
+    username = it->second.username;
+    it->second.lastUsed = std::chrono::steady_clock::now();
     return true;
   }
   return false;
@@ -31,151 +226,343 @@ bool HTTPServer::validateToken(const std::string &token,
 std::string HTTPServer::getUsernameFromToken(const std::string &token) {
   std::lock_guard<std::mutex> lock(sessionMutex);
   auto it = sessions.find(token);
-  return (it != sessions.end()) ? it->second : "";
+  return (it != sessions.end()) ? it->second.username : "";
 }
 
-// Helper function to escape JSON strings
-std::string HTTPServer::escapeJSON(const std::string &str) {
-  std::string escaped;
-  for (char c : str) {
-    switch (c) {
-    case '"':
-      escaped += "\\\"";
-      break;
-    case '\\':
-      escaped += "\\\\";
-      break;
-    case '\b':
-      escaped += "\\b";
-      break;
-    case '\f':
-      escaped += "\\f";
-      break;
-    case '\n':
-      escaped += "\\n";
-      break;
-    case '\r':
-      escaped += "\\r";
-      break;
-    case '\t':
-      escaped += "\\t";
-      break;
-    default:
-      if (c < 32) {
-        // Escape control characters
-        char buf[7];
-        snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
-        escaped += buf;
-      } else {
-        escaped += c;
-      }
+void HTTPServer::addSession(const std::string &token,
+                            const std::string &username) {
+  std::lock_guard<std::mutex> lock(sessionMutex);
+  Session &session = sessions[token];
+  sessionTimers.cancel(session.expiry); // same user, same second
+  session.username = username;
+  session.lastUsed = std::chrono::steady_clock::now();
+  session.expiry = 0;
+  if (sessionTimeout.count() > 0) {
+    // Later than every pending deadline, so the reaper only needs waking
+    // when it has none
+    bool reaperIdle = sessionTimers.empty();
+    session.expiry =
+        sessionTimers.schedule(session.lastUsed + sessionTimeout,
+                               [this, token] { expireSession(token); });
+    if (reaperIdle) {
+      sessionsChanged.notify_one();
+    }
+  }
+}
+
+void HTTPServer::removeSession(const std::string &token) {
+  std::lock_guard<std::mutex> lock(sessionMutex);
+  auto it = sessions.find(token);
+  if (it != sessions.end()) {
+    sessionTimers.cancel(it->second.expiry);
+    sessions.erase(it);
+  }
+}
+
+void HTTPServer::expireSession(const std::string &token) {
+  auto it = sessions.find(token);
+  if (it == sessions.end()) {
+    return;
+  }
+  Session &session = it->second;
+  session.expiry = 0;
+  if (sessionTimeout.count() == 0) {
+    return;
+  }
+  auto deadline = session.lastUsed + sessionTimeout;
+  if (deadline > std::chrono::steady_clock::now()) {
+    // Used since the timer was set
+    session.expiry = sessionTimers.schedule(
+        deadline, [this, token] { expireSession(token); });
+    return;
+  }
+  expiredUsers.push_back(session.username);
+  sessions.erase(it);
+}
+
+void HTTPServer::reapSessions() {
+  std::unique_lock<std::mutex> lock(sessionMutex);
+  while (!stoppingReaper) {
+    auto wait = sessionTimers.timeUntilNext(std::chrono::steady_clock::now());
+    if (wait == std::chrono::steady_clock::duration::max()) {
+      sessionsChanged.wait(lock);
+    } else {
+      sessionsChanged.wait_for(lock, wait);
+    }
+    sessionTimers.advance(std::chrono::steady_clock::now());
+    if (expiredUsers.empty()) {
+      continue;
+    }
+    // Like a logout, without holding up token checks meanwhile
+    std::vector<std::string> expired;
+    expired.swap(expiredUsers);
+    lock.unlock();
+    for (const auto &username : expired) {
+      userManager.setOnlineStatus(username, false);
     }
+    lock.lock();
   }
-  return escaped;
+}
+
+void HTTPServer::setSessionTimeout(std::chrono::seconds timeout) {
+  std::lock_guard<std::mutex> lock(sessionMutex);
+  sessionTimeout = timeout;
+}
+
+// Helper function to escape JSON strings
+std::string HTTPServer::escapeJSON(const std::string &str) {
+  return NetworkUtils::escapeJSON(str);
 }
 
 std::string HTTPServer::taskToJSON(const Task &task) {
-  std::ostringstream oss;
-  oss << "{"
-      << "\"id\":" << task.getTaskId() << ","
-      << "\"title\":\"" << escapeJSON(task.getTitle()) << "\","
-      << "\"description\":\"" << escapeJSON(task.getDescription()) << "\","
-      << "\"status\":\"" << task.getStatusString() << "\","
-      << "\"priority\":\"" << task.getPriorityString() << "\","
-      << "\"assigneeId\":" << task.getAssigneeId() << ","
-      << "\"reporterId\":" << task.getReporterId() << ","
-      << "\"projectKey\":\"" << escapeJSON(task.getProjectKey()) << "\","
-      << "\"deadline\":\"" << task.getDeadlineString() << "\","
-      << "\"isOverdue\":" << (task.isOverdue() ? "true" : "false") << ","
-      << "\"daysUntilDeadline\":" << task.getDaysUntilDeadline() << "}";
-  return oss.str();
+  return NetworkUtils::taskToJSON(task);
 }
 
 std::string HTTPServer::tasksToJSON(const std::vector<Task> &tasks) {
-  std::ostringstream oss;
-  oss << "[";
-  for (size_t i = 0; i < tasks.size(); ++i) {
-    oss << taskToJSON(tasks[i]);
-    if (i < tasks.size() - 1)
-      oss << ",";
-  }
-  oss << "]";
-  return oss.str();
+  std::string out;
+  out.reserve(2 + tasks.size() * TASK_JSON_SIZE);
+  JsonWriter json(out);
+  writeTasks(json, tasks);
+  return out;
 }
 
 std::string HTTPServer::chatToJSON(const Chat &chat) {
-  std::ostringstream oss;
-  oss << "{"
-      << "\"id\":" << chat.getMessageId() << ","
-      << "\"senderId\":" << chat.getSenderId() << ","
-      << "\"senderName\":\"" << escapeJSON(chat.getSenderName()) << "\","
-      << "\"content\":\"" << escapeJSON(chat.getContent()) << "\","
-      << "\"type\":\"" << chat.getTypeString() << "\","
-      << "\"timestamp\":\"" << chat.getTimestamp() << "\","
-      << "\"targetUserId\":" << chat.getTargetUserId() << ","
-      << "\"relatedTaskId\":" << chat.getRelatedTaskId() << "}";
-  return oss.str();
+  return NetworkUtils::chatToJSON(chat);
 }
 
 std::string HTTPServer::chatsToJSON(const std::vector<Chat> &chats) {
-  std::ostringstream oss;
-  oss << "[";
-  for (size_t i = 0; i < chats.size(); ++i) {
-    oss << chatToJSON(chats[i]);
-    if (i < chats.size() - 1)
-      oss << ",";
+  std::string out;
+  out.reserve(2 + chats.size() * CHAT_JSON_SIZE);
+  JsonWriter json(out);
+  json.beginArray();
+  for (const auto &chat : chats) {
+    NetworkUtils::writeChat(json, chat);
   }
-  oss << "]";
-  return oss.str();
+  json.endArray();
+  return out;
 }
 
 std::string HTTPServer::userToJSON(const User &user,
                                    const std::string &username) {
-  std::ostringstream oss;
-  oss << "{"
-      << "\"id\":" << user.getUserId() << ","
-      << "\"username\":\"" << escapeJSON(username) << "\","
-      << "\"email\":\"" << escapeJSON(user.getEmail()) << "\","
-      << "\"role\":\"" << user.getRoleString() << "\","
-      << "\"isOnline\":" << (user.getOnlineStatus() ? "true" : "false") << "}";
-  return oss.str();
+  return NetworkUtils::userToJSON(user, username);
 }
 
 std::string HTTPServer::usersToJSON(const std::map<std::string, User> &users) {
-  std::ostringstream oss;
-  oss << "[";
-  size_t i = 0;
+  std::string out;
+  JsonWriter json(out);
+  json.beginArray();
   for (const auto &pair : users) {
-    oss << userToJSON(pair.second, pair.first);
-    if (i < users.size() - 1)
-      oss << ",";
-    ++i;
+    NetworkUtils::writeUser(json, pair.second, pair.first);
   }
-  oss << "]";
-  return oss.str();
+  json.endArray();
+  return out;
 }
 
 std::string HTTPServer::errorJSON(const std::string &message) {
-  return "{\"success\":false,\"error\":\"" + escapeJSON(message) + "\"}";
+  std::string out;
+  JsonWriter json(out);
+  json.beginObject().field("success", false).field("error", message).endObject();
+  return out;
+}
+
+bool HTTPServer::parseBody(const httplib::Request &req, httplib::Response &res,
+                           JsonValue &body) {
+  std::string error;
+  if (!JsonReader::parse(req.body, body, &error)) {
+    res.set_content(errorJSON("Invalid JSON: " + error), "application/json");
+    return false;
+  }
+  if (!body.isObject()) {
+    res.set_content(errorJSON("Request body must be a JSON object"),
+                    "application/json");
+    return false;
+  }
+  return true;
 }
 
 std::string HTTPServer::successJSON(const std::string &message,
                                     const std::string &data) {
-  std::string result =
-      "{\"success\":true,\"message\":\"" + escapeJSON(message) + "\"";
+  std::string out;
+  out.reserve(48 + message.size() + data.size());
+  JsonWriter json(out);
+  json.beginObject().field("success", true).field("message", message);
   if (!data.empty()) {
-    result += ",\"data\":" + data;
+    json.key("data").raw(data);
+  }
+  json.endObject();
+  return out;
+}
+
+std::string HTTPServer::successJSON(const std::string &message,
+                                    const std::string &data,
+                                    uint64_t version) {
+  std::string out;
+  out.reserve(64 + message.size() + data.size());
+  JsonWriter json(out);
+  json.beginObject()
+      .field("success", true)
+      .field("message", message)
+      .field("version", version)
+      .key("data")
+      .raw(data)
+      .endObject();
+  return out;
+}
+
+std::string HTTPServer::successJSON(const std::string &message,
+                                    const std::vector<Task> &tasks) {
+  return tasksResponse(message, tasks, nullptr);
+}
+
+std::string HTTPServer::successJSON(const std::string &message,
+                                    const std::vector<Task> &tasks,
+                                    uint64_t version) {
+  return tasksResponse(message, tasks, &version);
+}
+
+std::string HTTPServer::channelToJSON(ChatChannel channel, size_t limit,
+                                      int afterId, size_t &count) {
+  // Serialize straight from the channel buffer, no intermediate copy
+  // A channel never holds more than its history, whatever was asked for
+  size_t expected = ChatManager::CHANNEL_HISTORY_SIZE;
+  if (limit > 0 && limit < expected) {
+    expected = limit;
+  }
+  std::string out;
+  out.reserve(2 + expected * CHAT_JSON_SIZE);
+  JsonWriter json(out);
+  json.beginArray();
+  count = 0;
+  chatManager.visitRecentMessages(
+      channel, limit,
+      [&](const Chat &msg) {
+        NetworkUtils::writeChat(json, msg);
+        count++;
+      },
+      afterId);
+  json.endArray();
+  return out;
+}
+
+ChatChannel HTTPServer::parseChannel(const std::string &name) {
+  if (name == "system")
+    return ChatChannel::SYSTEM;
+  if (name == "tasks")
+    return ChatChannel::TASK_UPDATES;
+  return ChatChannel::TEAM;
+}
+
+bool HTTPServer::longPollDeadline(
+    const httplib::Request &req, httplib::Response &res,
+    std::chrono::steady_clock::time_point &deadline) {
+  long long timeout = 0;
+  if (!queryParam(req, res, "timeout", LONG_POLL_TIMEOUT_SECONDS,
+                  LONG_POLL_TIMEOUT_SECONDS, timeout)) {
+    return false;
+  }
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+  return true;
+}
+
+void HTTPServer::parkLongPoll(const httplib::Request &req,
+                              const std::string &topic, const std::string &key,
+                              std::chrono::steady_clock::time_point deadline,
+                              HTTPStreams::Responder respond) {
+  // Events published from here on wake the poll; HTTPStreams checks once
+  // more after subscribing, for anything that landed in between
+  bool keepAlive = keepsAlive(req);
+  DetachableServer::detach([this, topic, key, deadline, keepAlive,
+                            respond = std::move(respond)](SocketHandle socket) {
+    streams.park(socket, topic, key, deadline, keepAlive, respond);
+  });
+}
+
+void HTTPServer::resumeConnection(SocketHandle socket) {
+  httplib::TaskQueue *pool = workers;
+  if (pool == nullptr ||
+      !pool->enqueue([this, socket] { server.serve(socket); })) {
+    SocketAbstraction::closeSocket(socket);
+  }
+}
+
+bool HTTPServer::queryParam(const httplib::Request &req, httplib::Response &res,
+                            const std::string &name, long long fallback,
+                            long long max, long long &value) {
+  if (!req.has_param(name)) {
+    value = std::min(fallback, max);
+    return true;
+  }
+  std::string text = req.get_param_value(name);
+  const char *last = text.data() + text.size();
+  auto result = std::from_chars(text.data(), last, value);
+  if (result.ec == std::errc::result_out_of_range && result.ptr == last &&
+      text[0] != '-') {
+    value = max; // too large to represent, so above any limit
+  } else if (result.ec != std::errc() || result.ptr != last || value < 0) {
+    res.status = 400;
+    res.set_content(errorJSON("Invalid " + name), "application/json");
+    return false;
+  }
+  value = std::min(value, max);
+  return true;
+}
+
+bool HTTPServer::requestPriority(const httplib::Request &req,
+                                 AdmissionControl::Priority &priority) {
+  const std::string &path = req.path;
+  if (path == "/api/events" || path == "/api/tasks/wait" ||
+      path == "/api/chat/wait") {
+    return false;
+  }
+  if ((req.method == "POST" &&
+       (path == "/api/login" || path == "/api/logout" || path == "/api/chat" ||
+        path == "/api/chat/private")) ||
+      path == "/api/stats") {
+    priority = AdmissionControl::Priority::HIGH; // stay usable under load
+  } else if (req.method == "GET") {
+    priority = AdmissionControl::Priority::LOW; // listings go first
+  } else {
+    priority = AdmissionControl::Priority::NORMAL;
   }
-  result += "}";
-  return result;
+  return true;
+}
+
+void HTTPServer::setupAdmission() {
+  server.set_pre_routing_handler(
+      [this](const httplib::Request &req, httplib::Response &res) {
+        // Only a connection's first request waited in the pool queue
+        auto queuedAt = connectionQueuedAt;
+        connectionQueuedAt = std::chrono::steady_clock::now();
+        releaseSlot(); // left over if the last response was never written
+
+        AdmissionControl::Priority priority;
+        if (req.method == "OPTIONS" || !requestPriority(req, priority)) {
+          return httplib::Server::HandlerResponse::Unhandled;
+        }
+        if (admission.tryAdmit(priority)) {
+          if (!admission.expired(queuedAt, priority)) {
+            heldSlot = &admission;
+            return httplib::Server::HandlerResponse::Unhandled;
+          }
+          admission.release();
+        }
+        res.status = 503;
+        res.set_header("Retry-After", std::to_string(admission.retryAfter()));
+        res.set_content(errorJSON("Server busy, retry later"),
+                        "application/json");
+        return httplib::Server::HandlerResponse::Handled;
+      });
+  // Runs once the handler has produced its response, before the body is
+  // streamed
+  server.set_post_routing_handler(
+      [](const httplib::Request &, httplib::Response &) { releaseSlot(); });
 }
 
 void HTTPServer::setupRoutes() {
+  setupAdmission();
+
   // Enable CORS for frontend access
-  server.set_default_headers(
-      {{"Access-Control-Allow-Origin", "*"},
-       {"Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS"},
-       {"Access-Control-Allow-Headers", "Content-Type, Authorization"}});
+  server.set_default_headers(CORS_HEADERS);
 
   // Handle OPTIONS requests for CORS preflight
   server.Options(".*", [](const httplib::Request &, httplib::Response &res) {
@@ -187,39 +574,31 @@ void HTTPServer::setupRoutes() {
   // POST /api/login - User login
   server.Post("/api/login", [this](const httplib::Request &req,
                                    httplib::Response &res) {
-    std::lock_guard<std::mutex> lock(serverMutex);
-
-    // Parse JSON body (simple parsing for username/password)
-    std::string body = req.body;
-    size_t userPos = body.find("\"username\":\"");
-    size_t passPos = body.find("\"password\":\"");
-
-    if (userPos == std::string::npos || passPos == std::string::npos) {
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    std::string username, password;
+    if (!body["username"].get(username) || !body["password"].get(password)) {
       res.set_content(errorJSON("Invalid request format"), "application/json");
       return;
     }
 
-    userPos += 12; // length of "\"username\":\""
-    size_t userEnd = body.find("\"", userPos);
-    std::string username = body.substr(userPos, userEnd - userPos);
-
-    passPos += 12; // length of "\"password\":\""
-    size_t passEnd = body.find("\"", passPos);
-    std::string password = body.substr(passPos, passEnd - passPos);
-
-    if (users.find(username) != users.end() &&
+    User user;
+    if (userManager.getUser(username, user) &&
         NetworkUtils::authenticateUser(username, password)) {
       std::string token = generateToken(username);
-      {
-        std::lock_guard<std::mutex> sessLock(sessionMutex);
-        sessions[token] = username;
-      }
-      users[username].setOnlineStatus(true);
-
-      std::string userData = userToJSON(users[username], username);
-      std::string response = "{\"success\":true,\"token\":\"" + token +
-                             "\",\"user\":" + userData + "}";
-      res.set_content(response, "application/json");
+      addSession(token, username);
+      userManager.setOnlineStatus(username, true);
+      user.setOnlineStatus(true);
+
+      std::string response;
+      JsonWriter json(response);
+      json.beginObject().field("success", true).field("token", token);
+      json.key("user");
+      NetworkUtils::writeUser(json, user, username);
+      json.endObject();
+      res.set_content(std::move(response), "application/json");
     } else {
       res.set_content(errorJSON("Invalid credentials"), "application/json");
     }
@@ -235,12 +614,8 @@ void HTTPServer::setupRoutes() {
 
     std::string username = getUsernameFromToken(token);
     if (!username.empty()) {
-      std::lock_guard<std::mutex> lock(serverMutex);
-      users[username].setOnlineStatus(false);
-      {
-        std::lock_guard<std::mutex> sessLock(sessionMutex);
-        sessions.erase(token);
-      }
+      userManager.setOnlineStatus(username, false);
+      removeSession(token);
       res.set_content(successJSON("Logged out successfully"),
                       "application/json");
     } else {
@@ -263,9 +638,68 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    auto tasks = taskManager.getAllTasks();
-    res.set_content(successJSON("Tasks retrieved", tasksToJSON(tasks)),
+    // ?since=<version> returns only tasks changed after that version
+    uint64_t version = 0;
+    std::vector<Task> tasks;
+    if (req.has_param("since")) {
+      long long since = 0;
+      if (!queryParam(req, res, "since", 0, LLONG_MAX, since)) {
+        return;
+      }
+      if (static_cast<uint64_t>(since) > taskManager.getVersion()) {
+        since = 0; // version from before a restart, resync everything
+      }
+      tasks = taskManager.getTasksChangedSince(since, version);
+    } else {
+      version = taskManager.getVersion();
+      tasks = taskManager.getAllTasks();
+    }
+    res.set_content(successJSON("Tasks retrieved", tasks, version),
+                    "application/json");
+  });
+
+  // GET /api/tasks/wait?since=<version> - Long poll for task changes
+  server.Get("/api/tasks/wait", [this](const httplib::Request &req,
+                                       httplib::Response &res) {
+    std::string token = req.get_header_value("Authorization");
+    if (token.substr(0, 7) == "Bearer ")
+      token = token.substr(7);
+
+    std::string username;
+    if (!validateToken(token, username)) {
+      res.set_content(errorJSON("Unauthorized"), "application/json");
+      return;
+    }
+
+    long long since = 0;
+    std::chrono::steady_clock::time_point deadline;
+    if (!queryParam(req, res, "since", 0, LLONG_MAX, since) ||
+        !longPollDeadline(req, res, deadline)) {
+      return;
+    }
+    if (static_cast<uint64_t>(since) > taskManager.getVersion()) {
+      since = 0;
+    }
+
+    uint64_t version = 0;
+    auto tasks = taskManager.getTasksChangedSince(since, version);
+    // Over the parking cap the request degrades to a plain poll
+    if (tasks.empty() && streams.parkedCount() < MAX_PARKED_REQUESTS) {
+      parkLongPoll(req, PubSub::TOPIC_TASKS, std::to_string(since), deadline,
+                   [this, since](bool final, std::string &body) {
+                     uint64_t version = 0;
+                     auto tasks = taskManager.getTasksChangedSince(since,
+                                                                   version);
+                     if (tasks.empty() && !final) {
+                       return false;
+                     }
+                     body = successJSON("Tasks retrieved", tasks, version);
+                     return true;
+                   });
+      return;
+    }
+
+    res.set_content(successJSON("Tasks retrieved", tasks, version),
                     "application/json");
   });
 
@@ -282,10 +716,9 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
+    int userId = userManager.getUserId(username);
     auto tasks = taskManager.getTasksByAssignee(userId);
-    res.set_content(successJSON("My tasks retrieved", tasksToJSON(tasks)),
+    res.set_content(successJSON("My tasks retrieved", tasks),
                     "application/json");
   });
 
@@ -302,9 +735,8 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
     auto tasks = taskManager.getOverdueTasks();
-    res.set_content(successJSON("Overdue tasks retrieved", tasksToJSON(tasks)),
+    res.set_content(successJSON("Overdue tasks retrieved", tasks),
                     "application/json");
   });
 
@@ -321,48 +753,244 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    // Simple JSON parsing for title, description, deadline
-    std::string body = req.body;
-    size_t titlePos = body.find("\"title\":\"");
-    size_t descPos = body.find("\"description\":\"");
-    size_t deadlinePos = body.find("\"deadlineDays\":");
-
-    if (titlePos == std::string::npos) {
-      res.set_content(errorJSON("Title is required"), "application/json");
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    NewTask newTask;
+    std::string error;
+    if (!parseNewTask(body, newTask, error)) {
+      res.set_content(errorJSON(error), "application/json");
       return;
     }
 
-    titlePos += 9;
-    size_t titleEnd = body.find("\"", titlePos);
-    std::string title = body.substr(titlePos, titleEnd - titlePos);
+    int userId = userManager.getUserId(username);
+    int taskId = taskManager.createTask(newTask.title, newTask.description,
+                                        userId, "PROJ", newTask.deadlineDays);
 
-    std::string description = "";
-    if (descPos != std::string::npos) {
-      descPos += 15;
-      size_t descEnd = body.find("\"", descPos);
-      description = body.substr(descPos, descEnd - descPos);
+    Task task;
+    if (taskManager.getTask(taskId, task)) {
+      res.set_content(successJSON("Task created", taskToJSON(task)),
+                      "application/json");
+    } else {
+      res.set_content(errorJSON("Failed to create task"), "application/json");
     }
+  });
+
+  // POST /api/tasks/bulk - Apply one change to many tasks, or create many:
+  // {"action":"status","taskIds":[1,2],"status":"IN_PROGRESS"}
+  // {"action":"priority","taskIds":[...],"priority":"HIGH"}
+  // {"action":"assign","taskIds":[...],"assigneeId":3}
+  // {"action":"create","tasks":[{"title":"...","description":"...",
+  //                              "deadlineDays":7}, ...]}
+  // One lock, one save and one "tasks" event for the whole batch
+  server.Post("/api/tasks/bulk", [this](const httplib::Request &req,
+                                        httplib::Response &res) {
+    std::string token = req.get_header_value("Authorization");
+    if (token.substr(0, 7) == "Bearer ")
+      token = token.substr(7);
 
-    int deadlineDays = 7;
-    if (deadlinePos != std::string::npos) {
-      deadlinePos += 15;
-      size_t deadlineEnd = body.find_first_of(",}", deadlinePos);
-      deadlineDays =
-          std::stoi(body.substr(deadlinePos, deadlineEnd - deadlinePos));
+    std::string username;
+    if (!validateToken(token, username)) {
+      res.set_content(errorJSON("Unauthorized"), "application/json");
+      return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
-    int taskId = taskManager.createTask(title, description, userId, "PROJ",
-                                        deadlineDays);
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    std::string action;
+    if (!body["action"].get(action)) {
+      res.set_content(errorJSON("Action is required"), "application/json");
+      return;
+    }
+    int userId = userManager.getUserId(username);
+
+    if (action == "create") {
+      std::vector<NewTask> newTasks;
+      for (const auto &object : body["tasks"]) {
+        if (newTasks.size() == MAX_BULK_TASKS) {
+          newTasks.clear();
+          break;
+        }
+        NewTask newTask;
+        std::string error;
+        if (!object.isObject() || !parseNewTask(object, newTask, error)) {
+          res.set_content(errorJSON("Task " + std::to_string(newTasks.size()) +
+                                    ": " +
+                                    (error.empty() ? "Not an object" : error)),
+                          "application/json");
+          return;
+        }
+        newTasks.push_back(std::move(newTask));
+      }
+      if (newTasks.empty()) {
+        res.set_content(errorJSON("Between 1 and " +
+                                  std::to_string(MAX_BULK_TASKS) +
+                                  " tasks are required"),
+                        "application/json");
+        return;
+      }
+      auto created = taskManager.createTasks(newTasks, userId);
+      res.set_content(
+          successJSON("Created " + std::to_string(created.size()) + " of " +
+                          std::to_string(newTasks.size()) + " tasks",
+                      created),
+          "application/json");
+      return;
+    }
 
-    Task *task = taskManager.getTaskById(taskId);
-    if (task) {
-      res.set_content(successJSON("Task created", taskToJSON(*task)),
+    std::vector<int> taskIds;
+    for (const auto &id : body["taskIds"]) {
+      int taskId;
+      if (!id.get(taskId) || taskIds.size() == MAX_BULK_TASKS) {
+        taskIds.clear();
+        break;
+      }
+      taskIds.push_back(taskId);
+    }
+    if (taskIds.empty()) {
+      res.set_content(errorJSON("Between 1 and " +
+                                std::to_string(MAX_BULK_TASKS) +
+                                " task IDs are required"),
                       "application/json");
+      return;
+    }
+
+    std::vector<Task> changed;
+    std::string value;
+    if (action == "status" && body["status"].get(value)) {
+      TaskStatus status;
+      if (!Task::parseStatus(value, status)) {
+        res.set_content(errorJSON("Invalid status"), "application/json");
+        return;
+      }
+      changed = taskManager.updateTasksStatus(taskIds, status, userId);
+    } else if (action == "priority" && body["priority"].get(value)) {
+      TaskPriority priority;
+      if (!Task::parsePriority(value, priority)) {
+        res.set_content(errorJSON("Invalid priority"), "application/json");
+        return;
+      }
+      changed = taskManager.updateTasksPriority(taskIds, priority, userId);
+    } else if (action == "assign") {
+      int assigneeId = -1;
+      if (!body["assigneeId"].get(assigneeId)) {
+        res.set_content(errorJSON("Assignee ID is required"),
+                        "application/json");
+        return;
+      }
+      changed = taskManager.assignTasks(taskIds, assigneeId, userId);
     } else {
-      res.set_content(errorJSON("Failed to create task"), "application/json");
+      res.set_content(errorJSON("Unknown action or missing value"),
+                      "application/json");
+      return;
+    }
+
+    res.set_content(
+        successJSON("Updated " + std::to_string(changed.size()) + " of " +
+                        std::to_string(taskIds.size()) + " tasks",
+                    changed),
+        "application/json");
+  });
+
+  // POST /api/batch - Several task operations in one round trip:
+  // {"atomic":true,"operations":[
+  //   {"op":"createTask","title":"...","description":"...","deadlineDays":7},
+  //   {"op":"updateTaskPriority","taskRef":0,"priority":"HIGH"},
+  //   {"op":"assignTask","taskRef":0,"assigneeId":3}]}
+  // Ops are named after the api.js calls and take the same fields plus
+  // taskId, or taskRef: the index of an earlier createTask. They run in
+  // order under one token check, one lock and one save; an atomic batch
+  // applies all of them or none. data holds one result per operation.
+  server.Post("/api/batch", [this](const httplib::Request &req,
+                                   httplib::Response &res) {
+    std::string token = req.get_header_value("Authorization");
+    if (token.substr(0, 7) == "Bearer ")
+      token = token.substr(7);
+
+    std::string username;
+    if (!validateToken(token, username)) {
+      res.set_content(errorJSON("Unauthorized"), "application/json");
+      return;
+    }
+
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    bool atomic = false;
+    if (!body["atomic"].getOptional(atomic)) {
+      res.set_content(errorJSON("atomic must be a boolean"),
+                      "application/json");
+      return;
+    }
+    JsonValue objects = body["operations"];
+    size_t count = objects.size(); // at most a few kilobytes to walk
+    if (count == 0 || count > MAX_BATCH_OPERATIONS) {
+      res.set_content(errorJSON("Between 1 and " +
+                                std::to_string(MAX_BATCH_OPERATIONS) +
+                                " operations are required"),
+                      "application/json");
+      return;
     }
+    // A malformed operation is a client bug: refuse the batch outright
+    std::vector<TaskOperation> operations(count);
+    size_t index = 0;
+    for (const auto &object : objects) {
+      std::string error;
+      if (!parseOperation(object, operations[index], error)) {
+        res.set_content(
+            errorJSON("Operation " + std::to_string(index) + ": " + error),
+            "application/json");
+        return;
+      }
+      index++;
+    }
+
+    int userId = userManager.getUserId(username);
+    auto results = taskManager.applyOperations(operations, userId, atomic);
+
+    std::string data;
+    data.reserve(2 + results.size() * (TASK_JSON_SIZE + 32));
+    JsonWriter json(data);
+    json.beginArray();
+    size_t applied = 0;
+    size_t failed = results.size();
+    for (size_t i = 0; i < results.size(); ++i) {
+      json.beginObject().field("success", results[i].ok);
+      if (results[i].ok) {
+        json.key("data");
+        NetworkUtils::writeTask(json, results[i].task);
+        applied++;
+      } else {
+        json.field("error", results[i].error);
+        if (failed == results.size() && results[i].error != "Not applied")
+          failed = i;
+      }
+      json.endObject();
+    }
+    json.endArray();
+
+    if (atomic && applied < results.size()) {
+      std::string response;
+      JsonWriter envelope(response);
+      envelope.beginObject()
+          .field("success", false)
+          .field("error", "Operation " + std::to_string(failed) +
+                              " failed: " + results[failed].error)
+          .key("data")
+          .raw(data)
+          .endObject();
+      res.set_content(std::move(response), "application/json");
+      return;
+    }
+    res.set_content(successJSON("Applied " + std::to_string(applied) +
+                                    " of " + std::to_string(results.size()) +
+                                    " operations",
+                                data),
+                    "application/json");
   });
 
   // PUT /api/tasks/:id/status - Update task status
@@ -380,32 +1008,26 @@ void HTTPServer::setupRoutes() {
 
     int taskId = std::stoi(req.matches[1]);
 
-    std::string body = req.body;
-    size_t statusPos = body.find("\"status\":\"");
-    if (statusPos == std::string::npos) {
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    std::string statusStr;
+    if (!body["status"].get(statusStr)) {
       res.set_content(errorJSON("Status is required"), "application/json");
       return;
     }
+    TaskStatus status;
+    if (!Task::parseStatus(statusStr, status)) {
+      res.set_content(errorJSON("Invalid status"), "application/json");
+      return;
+    }
 
-    statusPos += 10;
-    size_t statusEnd = body.find("\"", statusPos);
-    std::string statusStr = body.substr(statusPos, statusEnd - statusPos);
-
-    TaskStatus status = TaskStatus::TODO;
-    if (statusStr == "IN_PROGRESS")
-      status = TaskStatus::IN_PROGRESS;
-    else if (statusStr == "IN_REVIEW")
-      status = TaskStatus::IN_REVIEW;
-    else if (statusStr == "DONE")
-      status = TaskStatus::DONE;
-    else if (statusStr == "BLOCKED")
-      status = TaskStatus::BLOCKED;
-
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
+    int userId = userManager.getUserId(username);
     if (taskManager.updateTaskStatus(taskId, status, userId)) {
-      Task *task = taskManager.getTaskById(taskId);
-      res.set_content(successJSON("Status updated", taskToJSON(*task)),
+      Task task;
+      taskManager.getTask(taskId, task);
+      res.set_content(successJSON("Status updated", taskToJSON(task)),
                       "application/json");
     } else {
       res.set_content(errorJSON("Failed to update status"), "application/json");
@@ -427,22 +1049,121 @@ void HTTPServer::setupRoutes() {
                  return;
                }
 
-               std::lock_guard<std::mutex> lock(serverMutex);
-               auto allMessages = chatManager.getRecentMessages(50);
-
-               // Filter out private messages - only show team messages
-               std::vector<Chat> teamMessages;
-               for (const auto &msg : allMessages) {
-                 if (msg.getType() != MessageType::PRIVATE) {
-                   teamMessages.push_back(msg);
-                 }
+               // ?channel=team|system|tasks selects the history buffer
+               ChatChannel channel =
+                   parseChannel(req.get_param_value("channel"));
+               // ?after=<messageId> returns only newer messages
+               long long limit = 0, afterId = 0;
+               if (!queryParam(req, res, "limit", 50,
+                               ChatManager::CHANNEL_HISTORY_SIZE, limit) ||
+                   !queryParam(req, res, "after", 0, INT_MAX, afterId)) {
+                 return;
                }
 
+               size_t count = 0;
                res.set_content(
-                   successJSON("Messages retrieved", chatsToJSON(teamMessages)),
+                   successJSON("Messages retrieved",
+                               channelToJSON(channel, limit, afterId, count)),
                    "application/json");
              });
 
+  // GET /api/chat/wait?after=<messageId> - Long poll for new channel messages
+  server.Get("/api/chat/wait", [this](const httplib::Request &req,
+                                      httplib::Response &res) {
+    std::string token = req.get_header_value("Authorization");
+    if (token.substr(0, 7) == "Bearer ")
+      token = token.substr(7);
+
+    std::string username;
+    if (!validateToken(token, username)) {
+      res.set_content(errorJSON("Unauthorized"), "application/json");
+      return;
+    }
+
+    ChatChannel channel = parseChannel(req.get_param_value("channel"));
+    long long limit = 0, afterId = 0;
+    std::chrono::steady_clock::time_point deadline;
+    if (!queryParam(req, res, "limit", 50, ChatManager::CHANNEL_HISTORY_SIZE,
+                    limit) ||
+        !queryParam(req, res, "after", 0, INT_MAX, afterId) ||
+        !longPollDeadline(req, res, deadline)) {
+      return;
+    }
+
+    size_t count = 0;
+    std::string json = channelToJSON(channel, limit, afterId, count);
+    // Over the parking cap the request degrades to a plain poll
+    if (count == 0 && streams.parkedCount() < MAX_PARKED_REQUESTS) {
+      int after = static_cast<int>(afterId);
+      size_t most = static_cast<size_t>(limit);
+      std::string key = std::to_string(static_cast<int>(channel)) + ":" +
+                        std::to_string(most) + ":" + std::to_string(after);
+      parkLongPoll(req, PubSub::TOPIC_CHAT, key, deadline,
+                   [this, channel, most, after](bool final, std::string &body) {
+                     size_t count = 0;
+                     std::string json = channelToJSON(channel, most, after,
+                                                      count);
+                     if (count == 0 && !final) {
+                       return false;
+                     }
+                     body = successJSON("Messages retrieved", json);
+                     return true;
+                   });
+      return;
+    }
+
+    res.set_content(successJSON("Messages retrieved", json),
+                    "application/json");
+  });
+
+  // GET /api/events - Server-Sent Events stream of task, chat and presence
+  // changes plus private messages for the caller. EventSource cannot set
+  // headers, so the token may also be passed as ?token=. With ?tasks=1,2
+  // only those tasks are followed instead of every task.
+  server.Get("/api/events", [this](const httplib::Request &req,
+                                   httplib::Response &res) {
+    std::string token = req.get_header_value("Authorization");
+    if (token.substr(0, 7) == "Bearer ")
+      token = token.substr(7);
+    if (token.empty())
+      token = req.get_param_value("token");
+
+    std::string username;
+    if (!validateToken(token, username)) {
+      res.status = 401;
+      res.set_content(errorJSON("Unauthorized"), "application/json");
+      return;
+    }
+
+    if (streams.eventStreamCount() >= MAX_EVENT_STREAMS) {
+      res.status = 503;
+      res.set_header("Retry-After", "5");
+      res.set_content(errorJSON("Too many event streams"), "application/json");
+      return;
+    }
+
+    int userId = userManager.getUserId(username);
+    std::vector<std::string> topics = {PubSub::TOPIC_CHAT,
+                                       PubSub::TOPIC_PRESENCE,
+                                       PubSub::userTopic(userId)};
+    if (req.has_param("tasks")) {
+      for (const auto &id :
+           NetworkUtils::splitString(req.get_param_value("tasks"), ',')) {
+        try {
+          topics.push_back(PubSub::taskTopic(std::stoi(id)));
+        } catch (const std::exception &) {
+        }
+      }
+    } else {
+      topics.push_back(PubSub::TOPIC_TASKS);
+    }
+
+    DetachableServer::detach([this, topics](SocketHandle socket) {
+      streams.streamEvents(socket, topics,
+                           std::chrono::seconds(EVENT_HEARTBEAT_SECONDS));
+    });
+  });
+
   // POST /api/chat - Send message
   server.Post(
       "/api/chat", [this](const httplib::Request &req, httplib::Response &res) {
@@ -456,19 +1177,17 @@ void HTTPServer::setupRoutes() {
           return;
         }
 
-        std::string body = req.body;
-        size_t contentPos = body.find("\"content\":\"");
-        if (contentPos == std::string::npos) {
+        JsonValue body;
+        if (!parseBody(req, res, body)) {
+          return;
+        }
+        std::string content;
+        if (!body["content"].get(content) || content.empty()) {
           res.set_content(errorJSON("Content is required"), "application/json");
           return;
         }
 
-        contentPos += 11;
-        size_t contentEnd = body.find("\"", contentPos);
-        std::string content = body.substr(contentPos, contentEnd - contentPos);
-
-        std::lock_guard<std::mutex> lock(serverMutex);
-        int userId = users[username].getUserId();
+        int userId = userManager.getUserId(username);
         int messageId = chatManager.sendMessage(userId, username, content);
 
         res.set_content(
@@ -492,8 +1211,8 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    res.set_content(successJSON("Online users retrieved", usersToJSON(users)),
+    res.set_content(successJSON("Online users retrieved",
+                                usersToJSON(userManager.getAllUsers())),
                     "application/json");
   });
 
@@ -510,10 +1229,13 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    std::string dashboard = taskManager.generateDashboard(users);
-    res.set_content(successJSON("Dashboard data retrieved",
-                                "{\"dashboard\":\"" + dashboard + "\"}"),
+    std::string dashboard;
+    JsonWriter json(dashboard);
+    json.beginObject()
+        .field("dashboard",
+               taskManager.generateDashboard(userManager.getAllUsers()))
+        .endObject();
+    res.set_content(successJSON("Dashboard data retrieved", dashboard),
                     "application/json");
   });
 
@@ -534,31 +1256,26 @@ void HTTPServer::setupRoutes() {
 
     int taskId = std::stoi(req.matches[1]);
 
-    std::string body = req.body;
-    size_t priorityPos = body.find("\"priority\":\"");
-    if (priorityPos == std::string::npos) {
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    std::string priorityStr;
+    if (!body["priority"].get(priorityStr)) {
       res.set_content(errorJSON("Priority is required"), "application/json");
       return;
     }
+    TaskPriority priority;
+    if (!Task::parsePriority(priorityStr, priority)) {
+      res.set_content(errorJSON("Invalid priority"), "application/json");
+      return;
+    }
 
-    priorityPos += 12;
-    size_t priorityEnd = body.find("\"", priorityPos);
-    std::string priorityStr =
-        body.substr(priorityPos, priorityEnd - priorityPos);
-
-    TaskPriority priority = TaskPriority::MEDIUM;
-    if (priorityStr == "LOW")
-      priority = TaskPriority::LOW;
-    else if (priorityStr == "HIGH")
-      priority = TaskPriority::HIGH;
-    else if (priorityStr == "CRITICAL")
-      priority = TaskPriority::CRITICAL;
-
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
+    int userId = userManager.getUserId(username);
     if (taskManager.updateTaskPriority(taskId, priority, userId)) {
-      Task *task = taskManager.getTaskById(taskId);
-      res.set_content(successJSON("Priority updated", taskToJSON(*task)),
+      Task task;
+      taskManager.getTask(taskId, task);
+      res.set_content(successJSON("Priority updated", taskToJSON(task)),
                       "application/json");
     } else {
       res.set_content(errorJSON("Failed to update priority"),
@@ -583,23 +1300,21 @@ void HTTPServer::setupRoutes() {
 
     int taskId = std::stoi(req.matches[1]);
 
-    std::string body = req.body;
-    size_t assigneePos = body.find("\"assigneeId\":");
-    if (assigneePos == std::string::npos) {
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    int assigneeId;
+    if (!body["assigneeId"].get(assigneeId)) {
       res.set_content(errorJSON("Assignee ID is required"), "application/json");
       return;
     }
 
-    assigneePos += 13;
-    size_t assigneeEnd = body.find_first_of(",}", assigneePos);
-    int assigneeId =
-        std::stoi(body.substr(assigneePos, assigneeEnd - assigneePos));
-
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
+    int userId = userManager.getUserId(username);
     if (taskManager.assignTask(taskId, assigneeId, userId)) {
-      Task *task = taskManager.getTaskById(taskId);
-      res.set_content(successJSON("Task assigned", taskToJSON(*task)),
+      Task task;
+      taskManager.getTask(taskId, task);
+      res.set_content(successJSON("Task assigned", taskToJSON(task)),
                       "application/json");
     } else {
       res.set_content(errorJSON("Failed to assign task"), "application/json");
@@ -623,24 +1338,21 @@ void HTTPServer::setupRoutes() {
 
     int taskId = std::stoi(req.matches[1]);
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    Task *task = taskManager.getTaskById(taskId);
-    if (!task) {
+    Task task;
+    if (!taskManager.getTask(taskId, task)) {
       res.set_content(errorJSON("Task not found"), "application/json");
       return;
     }
 
-    auto comments = task->getComments();
-    std::ostringstream oss;
-    oss << "[";
-    for (size_t i = 0; i < comments.size(); ++i) {
-      oss << "\"" << comments[i] << "\"";
-      if (i < comments.size() - 1)
-        oss << ",";
+    std::string comments;
+    JsonWriter json(comments);
+    json.beginArray();
+    for (const auto &comment : task.getComments()) {
+      json.value(comment);
     }
-    oss << "]";
+    json.endArray();
 
-    res.set_content(successJSON("Comments retrieved", oss.str()),
+    res.set_content(successJSON("Comments retrieved", comments),
                     "application/json");
   });
 
@@ -660,19 +1372,17 @@ void HTTPServer::setupRoutes() {
 
     int taskId = std::stoi(req.matches[1]);
 
-    std::string body = req.body;
-    size_t commentPos = body.find("\"comment\":\"");
-    if (commentPos == std::string::npos) {
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    std::string comment;
+    if (!body["comment"].get(comment) || comment.empty()) {
       res.set_content(errorJSON("Comment is required"), "application/json");
       return;
     }
 
-    commentPos += 11;
-    size_t commentEnd = body.find("\"", commentPos);
-    std::string comment = body.substr(commentPos, commentEnd - commentPos);
-
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
+    int userId = userManager.getUserId(username);
     if (taskManager.addTaskComment(taskId, comment, userId)) {
       res.set_content(successJSON("Comment added"), "application/json");
     } else {
@@ -695,14 +1405,13 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    int days = 3; // default
-    if (req.has_param("days")) {
-      days = std::stoi(req.get_param_value("days"));
+    long long days = 0;
+    if (!queryParam(req, res, "days", 3, INT_MAX, days)) {
+      return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
     auto tasks = taskManager.getDueSoonTasks(days);
-    res.set_content(successJSON("Due soon tasks retrieved", tasksToJSON(tasks)),
+    res.set_content(successJSON("Due soon tasks retrieved", tasks),
                     "application/json");
   });
 
@@ -730,10 +1439,9 @@ void HTTPServer::setupRoutes() {
                else if (statusStr == "BLOCKED")
                  status = TaskStatus::BLOCKED;
 
-               std::lock_guard<std::mutex> lock(serverMutex);
                auto tasks = taskManager.getTasksByStatus(status);
                res.set_content(
-                   successJSON("Tasks by status retrieved", tasksToJSON(tasks)),
+                   successJSON("Tasks by status retrieved", tasks),
                    "application/json");
              });
 
@@ -752,10 +1460,9 @@ void HTTPServer::setupRoutes() {
 
                std::string project = req.matches[1];
 
-               std::lock_guard<std::mutex> lock(serverMutex);
                auto tasks = taskManager.getTasksByProject(project);
                res.set_content(successJSON("Tasks by project retrieved",
-                                           tasksToJSON(tasks)),
+                                           tasks),
                                "application/json");
              });
 
@@ -774,8 +1481,8 @@ void HTTPServer::setupRoutes() {
                  return;
                }
 
-               std::lock_guard<std::mutex> lock(serverMutex);
-               int recommendedId = taskManager.recommendBestAssignee(users);
+               int recommendedId =
+                   taskManager.recommendBestAssignee(userManager.getAllUsers());
 
                if (recommendedId == -1) {
                  res.set_content(errorJSON("No suitable assignee found"),
@@ -784,21 +1491,19 @@ void HTTPServer::setupRoutes() {
                }
 
                // Find username for recommended user
-               std::string recommendedUsername;
-               for (const auto &pair : users) {
-                 if (pair.second.getUserId() == recommendedId) {
-                   recommendedUsername = pair.first;
-                   break;
-                 }
-               }
+               std::string recommendedUsername =
+                   userManager.getUsernameById(recommendedId);
 
                int workload = taskManager.getActiveTaskCount(recommendedId);
-               std::ostringstream oss;
-               oss << "{\"userId\":" << recommendedId << ",\"username\":\""
-                   << recommendedUsername << "\""
-                   << ",\"workload\":" << workload << "}";
-
-               res.set_content(successJSON("Recommended assignee", oss.str()),
+               std::string recommended;
+               JsonWriter json(recommended);
+               json.beginObject()
+                   .field("userId", recommendedId)
+                   .field("username", recommendedUsername)
+                   .field("workload", workload)
+                   .endObject();
+
+               res.set_content(successJSON("Recommended assignee", recommended),
                                "application/json");
              });
 
@@ -817,26 +1522,20 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::string body = req.body;
-    size_t targetPos = body.find("\"targetUserId\":");
-    size_t contentPos = body.find("\"content\":\"");
-
-    if (targetPos == std::string::npos || contentPos == std::string::npos) {
+    JsonValue body;
+    if (!parseBody(req, res, body)) {
+      return;
+    }
+    int targetUserId;
+    std::string content;
+    if (!body["targetUserId"].get(targetUserId) ||
+        !body["content"].get(content) || content.empty()) {
       res.set_content(errorJSON("Target user ID and content are required"),
                       "application/json");
       return;
     }
 
-    targetPos += 15;
-    size_t targetEnd = body.find_first_of(",}", targetPos);
-    int targetUserId = std::stoi(body.substr(targetPos, targetEnd - targetPos));
-
-    contentPos += 11;
-    size_t contentEnd = body.find("\"", contentPos);
-    std::string content = body.substr(contentPos, contentEnd - contentPos);
-
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
+    int userId = userManager.getUserId(username);
     int messageId =
         chatManager.sendPrivateMessage(userId, username, targetUserId, content);
 
@@ -861,9 +1560,15 @@ void HTTPServer::setupRoutes() {
 
     int otherUserId = std::stoi(req.matches[1]);
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    int userId = users[username].getUserId();
-    auto messages = chatManager.getPrivateMessages(userId, otherUserId);
+    long long limit = 0, afterId = 0; // default: whole conversation
+    if (!queryParam(req, res, "limit", 0, INT_MAX, limit) ||
+        !queryParam(req, res, "after", 0, INT_MAX, afterId)) {
+      return;
+    }
+
+    int userId = userManager.getUserId(username);
+    auto messages =
+        chatManager.getPrivateMessages(userId, otherUserId, limit, afterId);
     res.set_content(
         successJSON("Private messages retrieved", chatsToJSON(messages)),
         "application/json");
@@ -886,8 +1591,14 @@ void HTTPServer::setupRoutes() {
 
                int taskId = std::stoi(req.matches[1]);
 
-               std::lock_guard<std::mutex> lock(serverMutex);
-               auto messages = chatManager.getTaskMessages(taskId);
+               long long limit = 0, afterId = 0; // default: whole feed
+               if (!queryParam(req, res, "limit", 0, INT_MAX, limit) ||
+                   !queryParam(req, res, "after", 0, INT_MAX, afterId)) {
+                 return;
+               }
+
+               auto messages =
+                   chatManager.getTaskMessages(taskId, limit, afterId);
                res.set_content(successJSON("Task messages retrieved",
                                            chatsToJSON(messages)),
                                "application/json");
@@ -908,8 +1619,6 @@ void HTTPServer::setupRoutes() {
                  return;
                }
 
-               std::lock_guard<std::mutex> lock(serverMutex);
-
                // Get status counts
                auto statusCounts = taskManager.getTaskStatusCount();
                int todoCount = statusCounts[TaskStatus::TODO];
@@ -924,18 +1633,25 @@ void HTTPServer::setupRoutes() {
                int overdueCount = taskManager.getOverdueTasks().size();
                int dueSoonCount = taskManager.getDueSoonTasks(3).size();
 
-               std::ostringstream oss;
-               oss << "{"
-                   << "\"total\":" << totalCount << ","
-                   << "\"todo\":" << todoCount << ","
-                   << "\"inProgress\":" << inProgressCount << ","
-                   << "\"inReview\":" << inReviewCount << ","
-                   << "\"done\":" << doneCount << ","
-                   << "\"blocked\":" << blockedCount << ","
-                   << "\"overdue\":" << overdueCount << ","
-                   << "\"dueSoon\":" << dueSoonCount << "}";
-
-               res.set_content(successJSON("Statistics retrieved", oss.str()),
+               std::string stats;
+               JsonWriter json(stats);
+               json.beginObject()
+                   .field("total", totalCount)
+                   .field("todo", todoCount)
+                   .field("inProgress", inProgressCount)
+                   .field("inReview", inReviewCount)
+                   .field("done", doneCount)
+                   .field("blocked", blockedCount)
+                   .field("overdue", overdueCount)
+                   .field("dueSoon", dueSoonCount)
+                   .key("admission");
+               NetworkUtils::writeAdmission(json, admission.stats());
+               if (connectionStats) {
+                 json.key("connections").raw(connectionStats());
+               }
+               json.endObject();
+
+               res.set_content(successJSON("Statistics retrieved", stats),
                                "application/json");
              });
 
@@ -954,19 +1670,34 @@ void HTTPServer::setupRoutes() {
       return;
     }
 
-    std::lock_guard<std::mutex> lock(serverMutex);
-    res.set_content(successJSON("Users retrieved", usersToJSON(users)),
-                    "application/json");
+    res.set_content(
+        successJSON("Users retrieved", usersToJSON(userManager.getAllUsers())),
+        "application/json");
   });
 }
 
+void HTTPServer::setConnectionStats(std::function<std::string()> stats) {
+  connectionStats = std::move(stats);
+}
+
 void HTTPServer::start(int port) {
   std::cout << "Starting HTTP API server on port " << port << "..."
             << std::endl;
+  streams.start();
   if (!server.listen("0.0.0.0", port)) {
     std::cerr << "ERROR: Failed to bind/listen on port " << port
               << " (Port might be in use or permission denied)" << std::endl;
   }
 }
 
-void HTTPServer::stop() { server.stop(); }
+bool HTTPServer::startWebSocket(int port) {
+  return webSocketServer.start(port);
+}
+
+void HTTPServer::stop() {
+  webSocketServer.stop();
+  // Parked connections close before the pool they would return to
+  streams.stop();
+  workers = nullptr;
+  server.stop();
+}
@@ -0,0 +1,365 @@
+#include "../include/HTTPStreams.hpp"
+#include "../include/httplib.h"
+#include <vector>
+
+namespace {
+// How long an answered keep-alive connection may sit idle, as in httplib
+constexpr std::chrono::seconds KEEP_ALIVE_TIMEOUT{
+    CPPHTTPLIB_KEEPALIVE_TIMEOUT_SECOND};
+
+const auto HEARTBEAT_FRAME =
+    std::make_shared<const std::string>(": keepalive\n\n");
+const auto RESYNC_FRAME =
+    std::make_shared<const std::string>("event: resync\ndata: {}\n\n");
+} // namespace
+
+HTTPStreams::HTTPStreams(PubSub &ps, std::string headers, Resume r)
+    : pubSub(ps), extraHeaders(std::move(headers)), resume(std::move(r)) {}
+
+HTTPStreams::~HTTPStreams() { stop(); }
+
+bool HTTPStreams::start() { return loop.start("HTTP streams"); }
+
+void HTTPStreams::stop() {
+  loop.post([this] { closeAll(); });
+  loop.stop();
+}
+
+void HTTPStreams::park(SocketHandle socket, const std::string &topicName,
+                       const std::string &key,
+                       std::chrono::steady_clock::time_point deadline,
+                       bool keepAlive, Responder respond) {
+  auto poll = std::make_shared<LongPoll>();
+  poll->socket = socket;
+  poll->topic = topicName;
+  poll->key = key;
+  poll->keepAlive = keepAlive;
+  poll->respond = std::move(respond);
+  SocketAbstraction::setNonBlocking(socket);
+  ++parked;
+  loop.post([this, poll, deadline] {
+    poll->timer = loop.timers().schedule(deadline, [this, poll] {
+      poll->timer = 0;
+      check(poll, true);
+    });
+    startPoll(poll);
+  });
+}
+
+void HTTPStreams::startPoll(const LongPollPtr &poll) {
+  polls.insert(poll);
+  if (!loop.watch(poll->socket, [this, poll](bool readable, bool writable) {
+        if (readable) {
+          readFrom(poll);
+        }
+        if (writable) {
+          writeTo(poll);
+        }
+      })) {
+    finish(poll, false);
+    return;
+  }
+  topic(poll->topic)->polls.insert(poll);
+  // Whatever changed between the handler's look and the subscription
+  check(poll, false);
+}
+
+std::shared_ptr<HTTPStreams::Topic>
+HTTPStreams::topic(const std::string &name) {
+  auto &entry = topics[name];
+  if (!entry) {
+    entry = std::make_shared<Topic>();
+    // Events are only a signal to re-check; one wakeup covers a burst
+    std::weak_ptr<Topic> weak = entry;
+    entry->subscription = pubSub.subscribe(
+        {name}, PubSub::DEFAULT_QUEUE_CAPACITY, [this, weak] {
+          auto target = weak.lock();
+          if (target && !target->wakePosted.exchange(true)) {
+            loop.post([this, target] { wake(target); });
+          }
+        });
+  }
+  return entry;
+}
+
+void HTTPStreams::wake(const std::shared_ptr<Topic> &target) {
+  target->wakePosted = false;
+  PubSubMessagePtr message;
+  while (target->subscription->tryPop(message)) {
+  }
+  // Answered polls leave the set, so walk a copy. Each key's answer is
+  // built once and shared, so a wakeup costs one query per distinct cursor
+  // rather than one per parked poll.
+  std::vector<LongPollPtr> waiting(target->polls.begin(),
+                                   target->polls.end());
+  std::unordered_map<std::string, std::shared_ptr<const std::string>> answers;
+  for (const auto &poll : waiting) {
+    if (poll->answered) {
+      continue;
+    }
+    auto found = answers.find(poll->key);
+    if (found == answers.end()) {
+      std::string body;
+      std::shared_ptr<const std::string> shared;
+      if (poll->respond(false, body)) {
+        shared = std::make_shared<const std::string>(std::move(body));
+      }
+      found = answers.emplace(poll->key, std::move(shared)).first;
+    }
+    if (found->second) {
+      answer(poll, found->second);
+    }
+  }
+}
+
+void HTTPStreams::check(const LongPollPtr &poll, bool final) {
+  if (poll->answered) {
+    return;
+  }
+  std::string body;
+  if (poll->respond(final, body)) {
+    answer(poll, std::make_shared<const std::string>(std::move(body)));
+  }
+}
+
+void HTTPStreams::stopWaiting(const LongPollPtr &poll) {
+  poll->answered = true;
+  loop.timers().cancel(poll->timer);
+  poll->timer = 0;
+  auto it = topics.find(poll->topic);
+  if (it != topics.end()) {
+    it->second->polls.erase(poll);
+  }
+}
+
+void HTTPStreams::answer(const LongPollPtr &poll,
+                         const std::shared_ptr<const std::string> &body) {
+  stopWaiting(poll);
+  // The body may be shared with other polls; only the head is this one's
+  poll->output.add(std::make_shared<const std::string>(
+      "HTTP/1.1 200 OK\r\n" + extraHeaders +
+      "Content-Type: application/json\r\n"
+      "Content-Length: " +
+      std::to_string(body->size()) + "\r\nConnection: " +
+      (poll->keepAlive ? "keep-alive" : "close") + "\r\n\r\n"));
+  poll->output.add(body);
+  writeTo(poll);
+}
+
+void HTTPStreams::readFrom(const LongPollPtr &poll) {
+  if (poll->idle) {
+    // The next request: httplib reads it, or sees the client hang up
+    finish(poll, true);
+    return;
+  }
+  char buffer[256];
+  int bytes = SocketAbstraction::receiveData(poll->socket, buffer,
+                                            sizeof(buffer));
+  if (bytes < 0 && SocketAbstraction::wouldBlock()) {
+    return;
+  }
+  // The client hung up, or sent more before its answer: nothing to keep
+  finish(poll, false);
+}
+
+void HTTPStreams::writeTo(const LongPollPtr &poll) {
+  if (!poll->answered || poll->idle ||
+      poll->socket == INVALID_SOCKET_HANDLE) {
+    return;
+  }
+  if (!EventLoop::send(poll->socket, poll->output)) {
+    finish(poll, false);
+  } else if (!poll->output.empty()) {
+    loop.setWriteInterest(poll->socket, true);
+  } else if (poll->keepAlive) {
+    waitForNextRequest(poll);
+  } else {
+    finish(poll, false);
+  }
+}
+
+void HTTPStreams::waitForNextRequest(const LongPollPtr &poll) {
+  // Idle until the client speaks again, so that keep-alive costs no pool
+  // thread either
+  poll->idle = true;
+  loop.setWriteInterest(poll->socket, false);
+  poll->timer = loop.timers().schedule(
+      loop.now() + KEEP_ALIVE_TIMEOUT, [this, poll] {
+        poll->timer = 0;
+        finish(poll, false);
+      });
+}
+
+void HTTPStreams::finish(const LongPollPtr &poll, bool reuse) {
+  if (poll->socket == INVALID_SOCKET_HANDLE) {
+    return;
+  }
+  if (!poll->answered) {
+    stopWaiting(poll);
+  }
+  loop.timers().cancel(poll->timer);
+  polls.erase(poll);
+  --parked;
+
+  SocketHandle socket = poll->socket;
+  poll->socket = INVALID_SOCKET_HANDLE;
+  loop.unwatch(socket);
+  if (reuse && SocketAbstraction::setNonBlocking(socket, false)) {
+    resume(socket);
+  } else {
+    SocketAbstraction::closeSocket(socket);
+  }
+}
+
+void HTTPStreams::streamEvents(SocketHandle socket,
+                               const std::vector<std::string> &topics,
+                               std::chrono::seconds heartbeat) {
+  auto stream = std::make_shared<EventStream>();
+  stream->socket = socket;
+  stream->heartbeat = heartbeat;
+  // No length and no chunking: the body runs until the connection closes
+  stream->output.add(std::make_shared<const std::string>(
+      "HTTP/1.1 200 OK\r\n" + extraHeaders +
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-cache\r\n"
+      "X-Accel-Buffering: no\r\n"
+      "Connection: close\r\n\r\n"
+      "retry: 3000\n\n"));
+  SocketAbstraction::setNonBlocking(socket);
+  ++streaming;
+
+  std::weak_ptr<EventStream> weak = stream;
+  stream->subscription = pubSub.subscribe(
+      topics, PubSub::DEFAULT_QUEUE_CAPACITY, [this, weak] {
+        auto target = weak.lock();
+        if (target && !target->wakePosted.exchange(true)) {
+          loop.post([this, target] {
+            target->wakePosted = false;
+            pump(target);
+          });
+        }
+      });
+  loop.post([this, stream] { startStream(stream); });
+}
+
+void HTTPStreams::startStream(const EventStreamPtr &stream) {
+  stream->started = true;
+  eventStreams.insert(stream);
+  if (!loop.watch(stream->socket, [this, stream](bool readable, bool writable) {
+        if (readable) {
+          drain(stream);
+        }
+        if (writable) {
+          pump(stream);
+        }
+      })) {
+    closeStream(stream);
+    return;
+  }
+  stream->lastSent = loop.now();
+  scheduleHeartbeat(stream);
+  pump(stream);
+}
+
+bool HTTPStreams::takeEvents(const EventStreamPtr &stream) {
+  PubSubMessagePtr message;
+  while (stream->output.frameCount() < WriteBatch::MAX_FRAMES &&
+         stream->subscription->tryPop(message)) {
+    stream->output.add(wireBuffer(message, Wire::SSE));
+  }
+  uint64_t dropped = stream->subscription->droppedCount();
+  if (dropped != stream->dropped) {
+    // The queue overflowed; the client refetches with its cursors
+    stream->dropped = dropped;
+    stream->output.add(RESYNC_FRAME);
+  }
+  if (stream->output.empty()) {
+    return false;
+  }
+  stream->lastSent = loop.now();
+  return true;
+}
+
+void HTTPStreams::pump(const EventStreamPtr &stream) {
+  if (!stream->started || stream->socket == INVALID_SOCKET_HANDLE) {
+    return;
+  }
+  // Events are taken only once the last write has drained
+  while (!stream->output.empty() || takeEvents(stream)) {
+    if (!EventLoop::send(stream->socket, stream->output)) {
+      closeStream(stream);
+      return;
+    }
+    if (!stream->output.empty()) {
+      loop.setWriteInterest(stream->socket, true);
+      return;
+    }
+  }
+  loop.setWriteInterest(stream->socket, false);
+}
+
+void HTTPStreams::scheduleHeartbeat(const EventStreamPtr &stream) {
+  stream->timer = loop.timers().schedule(
+      stream->lastSent + stream->heartbeat, [this, stream] {
+        stream->timer = 0;
+        if (loop.now() >= stream->lastSent + stream->heartbeat) {
+          stream->lastSent = loop.now();
+          // A stalled write is not silence; the pending bytes say enough
+          if (stream->output.empty()) {
+            stream->output.add(HEARTBEAT_FRAME);
+            pump(stream);
+            if (stream->socket == INVALID_SOCKET_HANDLE) {
+              return;
+            }
+          }
+        }
+        scheduleHeartbeat(stream);
+      });
+}
+
+void HTTPStreams::drain(const EventStreamPtr &stream) {
+  // EventSource sends nothing after its request; only the close matters
+  char buffer[256];
+  while (stream->socket != INVALID_SOCKET_HANDLE) {
+    int bytes = SocketAbstraction::receiveData(stream->socket, buffer,
+                                              sizeof(buffer));
+    if (bytes > 0) {
+      continue;
+    }
+    if (bytes < 0 && SocketAbstraction::wouldBlock()) {
+      return;
+    }
+    closeStream(stream);
+  }
+}
+
+void HTTPStreams::closeStream(const EventStreamPtr &stream) {
+  if (stream->socket == INVALID_SOCKET_HANDLE) {
+    return;
+  }
+  loop.timers().cancel(stream->timer);
+  pubSub.unsubscribe(stream->subscription);
+  eventStreams.erase(stream);
+  --streaming;
+
+  SocketHandle socket = stream->socket;
+  stream->socket = INVALID_SOCKET_HANDLE;
+  loop.unwatch(socket);
+  SocketAbstraction::closeSocket(socket);
+}
+
+void HTTPStreams::closeAll() {
+  std::vector<LongPollPtr> open(polls.begin(), polls.end());
+  for (const auto &poll : open) {
+    finish(poll, false);
+  }
+  std::vector<EventStreamPtr> streams(eventStreams.begin(),
+                                      eventStreams.end());
+  for (const auto &stream : streams) {
+    closeStream(stream);
+  }
+  for (const auto &entry : topics) {
+    pubSub.unsubscribe(entry.second->subscription);
+  }
+  topics.clear();
+}
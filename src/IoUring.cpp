@@ -0,0 +1,327 @@
+#include "../include/IoUring.hpp"
+#include <iostream>
+
+#ifdef TASKMANAGER_HAVE_IO_URING
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+namespace {
+// Never used for the caller's operations: completions of the wakeup read
+constexpr uint64_t WAKE_USER_DATA = ~0ULL;
+constexpr uint16_t BUFFER_GROUP = 0;
+
+// Multishot receive arrived in 6.0; older kernels reject it per operation,
+// which is too late to fall back
+bool kernelSupportsMultishot() {
+  utsname name{};
+  int major = 0;
+  if (uname(&name) != 0 || std::sscanf(name.release, "%d", &major) != 1) {
+    return false;
+  }
+  return major >= 6;
+}
+} // namespace
+
+struct IoUring::Rings {
+  int fd = -1;
+  void *sqRing = MAP_FAILED;
+  size_t sqRingSize = 0;
+  void *cqRing = MAP_FAILED;
+  size_t cqRingSize = 0;
+  io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+  size_t sqesSize = 0;
+  io_uring_buf_ring *bufRing = static_cast<io_uring_buf_ring *>(MAP_FAILED);
+  size_t bufRingSize = 0;
+
+  unsigned *sqHead = nullptr;
+  unsigned *sqTail = nullptr;
+  unsigned sqMask = 0;
+  unsigned sqEntries = 0;
+  unsigned sqLocalTail = 0; // published to sqTail on submit
+  unsigned *cqHead = nullptr;
+  unsigned *cqTail = nullptr;
+  unsigned cqMask = 0;
+  io_uring_cqe *cqes = nullptr;
+
+  ~Rings() {
+    if (bufRing != MAP_FAILED)
+      munmap(bufRing, bufRingSize);
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+      munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+      munmap(sqRing, sqRingSize);
+    if (fd >= 0)
+      close(fd); // cancels whatever is still in flight
+  }
+};
+
+IoUring::IoUring(unsigned entries, size_t size)
+    : wakePending(false), syscallCount(0), wakeFd(-1), wakeValue(0),
+      bufferSize(size), queued(0) {
+  if (!kernelSupportsMultishot()) {
+    return;
+  }
+  auto r = std::make_unique<Rings>();
+
+  io_uring_params params{};
+  r->fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (r->fd < 0) {
+    std::cerr << "io_uring_setup failed: " << SocketAbstraction::getLastError()
+              << std::endl;
+    return;
+  }
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+      !(params.features & IORING_FEAT_EXT_ARG) ||
+      !(params.features & IORING_FEAT_NODROP)) {
+    std::cerr << "io_uring: kernel lacks required features" << std::endl;
+    return;
+  }
+
+  // Submission and completion rings share one mapping (SINGLE_MMAP)
+  r->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  r->cqRingSize =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  r->sqRingSize = r->cqRingSize = std::max(r->sqRingSize, r->cqRingSize);
+  r->sqRing = mmap(nullptr, r->sqRingSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+  r->cqRing = r->sqRing;
+  r->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  r->sqes = static_cast<io_uring_sqe *>(
+      mmap(nullptr, r->sqesSize, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES));
+  if (r->sqRing == MAP_FAILED || r->sqes == MAP_FAILED) {
+    std::cerr << "io_uring mmap failed: " << SocketAbstraction::getLastError()
+              << std::endl;
+    return;
+  }
+  char *sq = static_cast<char *>(r->sqRing);
+  r->sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  r->sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  r->sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  r->sqEntries = params.sq_entries;
+  r->sqLocalTail = *r->sqTail;
+  unsigned *sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  for (unsigned i = 0; i < params.sq_entries; ++i) {
+    sqArray[i] = i; // entries are always used in ring order
+  }
+  char *cq = static_cast<char *>(r->cqRing);
+  r->cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  r->cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  r->cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  r->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  // Receive buffers: registered once, picked by the kernel per completion
+  buffers.resize(BUFFER_COUNT * bufferSize);
+  r->bufRingSize = BUFFER_COUNT * sizeof(io_uring_buf);
+  r->bufRing = static_cast<io_uring_buf_ring *>(
+      mmap(nullptr, r->bufRingSize, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (r->bufRing == MAP_FAILED) {
+    return;
+  }
+  io_uring_buf_reg reg{};
+  reg.ring_addr = reinterpret_cast<uint64_t>(r->bufRing);
+  reg.ring_entries = BUFFER_COUNT;
+  reg.bgid = BUFFER_GROUP;
+  if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PBUF_RING, &reg,
+              1) < 0) {
+    std::cerr << "io_uring buffer registration failed: "
+              << SocketAbstraction::getLastError() << std::endl;
+    return;
+  }
+
+  wakeFd = eventfd(0, EFD_CLOEXEC);
+  if (wakeFd < 0) {
+    return;
+  }
+  rings = std::move(r);
+  for (unsigned i = 0; i < BUFFER_COUNT; ++i) {
+    recycleBuffer(static_cast<int>(i));
+  }
+  prepareWakeRead();
+}
+
+IoUring::~IoUring() {
+  rings.reset();
+  if (wakeFd >= 0)
+    close(wakeFd);
+}
+
+bool IoUring::isValid() const { return rings != nullptr; }
+
+void *IoUring::nextEntry() {
+  Rings &r = *rings;
+  unsigned head = __atomic_load_n(r.sqHead, __ATOMIC_ACQUIRE);
+  if (r.sqLocalTail - head >= r.sqEntries) {
+    // Queue full: hand what we have to the kernel without waiting
+    __atomic_store_n(r.sqTail, r.sqLocalTail, __ATOMIC_RELEASE);
+    ++syscallCount;
+    int submitted = static_cast<int>(
+        syscall(__NR_io_uring_enter, r.fd, queued, 0, 0, nullptr, 0));
+    if (submitted > 0) {
+      queued -= std::min<unsigned>(queued, submitted);
+    }
+  }
+  io_uring_sqe *sqe = &r.sqes[r.sqLocalTail & r.sqMask];
+  std::memset(sqe, 0, sizeof(*sqe));
+  ++r.sqLocalTail;
+  ++queued;
+  return sqe;
+}
+
+void IoUring::prepareAccept(SocketHandle listenSocket, uint64_t userData) {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry());
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = listenSocket;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+  sqe->user_data = userData;
+}
+
+void IoUring::prepareReceive(SocketHandle socket, uint64_t userData) {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry());
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = socket;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUFFER_GROUP;
+  sqe->user_data = userData;
+}
+
+void IoUring::prepareSendMessage(SocketHandle socket, const msghdr *message,
+                                 uint64_t userData) {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry());
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = socket;
+  sqe->addr = reinterpret_cast<uint64_t>(message);
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = userData;
+}
+
+void IoUring::prepareWakeRead() {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry());
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = wakeFd;
+  sqe->addr = reinterpret_cast<uint64_t>(&wakeValue);
+  sqe->len = sizeof(wakeValue);
+  sqe->user_data = WAKE_USER_DATA;
+}
+
+int IoUring::submitAndWait(std::vector<Completion> &completions,
+                           int timeoutMs) {
+  Rings &r = *rings;
+  completions.clear();
+  __atomic_store_n(r.sqTail, r.sqLocalTail, __ATOMIC_RELEASE);
+
+  bool ready = *r.cqHead != __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+  if (queued > 0 || !ready) {
+    // Submit and wait in the same call; skip the wait if work is ready
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeoutMs >= 0) {
+      ts.tv_sec = timeoutMs / 1000;
+      ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    unsigned flags = ready ? 0 : IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    ++syscallCount;
+    int submitted = static_cast<int>(
+        syscall(__NR_io_uring_enter, r.fd, queued, ready ? 0 : 1, flags,
+                ready ? nullptr : &arg, ready ? 0 : sizeof(arg)));
+    if (submitted >= 0) {
+      queued -= std::min<unsigned>(queued, submitted);
+    } else if (errno != ETIME && errno != EINTR && errno != EBUSY) {
+      return -1;
+    }
+  }
+
+  unsigned head = *r.cqHead;
+  unsigned tail = __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    const io_uring_cqe &cqe = r.cqes[head & r.cqMask];
+    if (cqe.user_data == WAKE_USER_DATA) {
+      wakePending = false;
+      if (cqe.res > 0) {
+        prepareWakeRead();
+      }
+      continue;
+    }
+    completions.push_back(
+        {cqe.user_data, cqe.res, (cqe.flags & IORING_CQE_F_MORE) != 0,
+         (cqe.flags & IORING_CQE_F_BUFFER)
+             ? static_cast<int>(cqe.flags >> IORING_CQE_BUFFER_SHIFT)
+             : -1});
+  }
+  __atomic_store_n(r.cqHead, head, __ATOMIC_RELEASE);
+  return static_cast<int>(completions.size());
+}
+
+const char *IoUring::buffer(int bufferId) const {
+  return buffers.data() + static_cast<size_t>(bufferId) * bufferSize;
+}
+
+void IoUring::recycleBuffer(int bufferId) {
+  io_uring_buf_ring *ring = rings->bufRing;
+  // Index the entries by hand: in C++ the header's flexible bufs[] member
+  // sits behind a non-empty "empty" struct. The tail overlays the first
+  // entry's reserved field, so set fields one by one.
+  auto *entries = reinterpret_cast<io_uring_buf *>(ring);
+  uint16_t tail = ring->tail;
+  io_uring_buf &entry = entries[tail & (BUFFER_COUNT - 1)];
+  entry.addr = reinterpret_cast<uint64_t>(buffer(bufferId));
+  entry.len = static_cast<uint32_t>(bufferSize);
+  entry.bid = static_cast<uint16_t>(bufferId);
+  __atomic_store_n(&ring->tail, static_cast<uint16_t>(tail + 1),
+                   __ATOMIC_RELEASE);
+}
+
+void IoUring::wakeup() {
+  if (!wakePending.exchange(true)) {
+    uint64_t one = 1;
+    ++syscallCount;
+    if (write(wakeFd, &one, sizeof(one)) < 0) {
+      wakePending = false;
+    }
+  }
+}
+
+#else
+
+struct IoUring::Rings {};
+
+IoUring::IoUring(unsigned, size_t size)
+    : wakePending(false), syscallCount(0), wakeFd(-1), wakeValue(0),
+      bufferSize(size), queued(0) {}
+
+IoUring::~IoUring() {}
+
+bool IoUring::isValid() const { return false; }
+
+void *IoUring::nextEntry() { return nullptr; }
+void IoUring::prepareAccept(SocketHandle, uint64_t) {}
+void IoUring::prepareReceive(SocketHandle, uint64_t) {}
+void IoUring::prepareSendMessage(SocketHandle, const msghdr *, uint64_t) {}
+void IoUring::prepareWakeRead() {}
+
+int IoUring::submitAndWait(std::vector<Completion> &completions, int) {
+  completions.clear();
+  return -1;
+}
+
+const char *IoUring::buffer(int) const { return nullptr; }
+void IoUring::recycleBuffer(int) {}
+void IoUring::wakeup() {}
+
+#endif
@@ -0,0 +1,571 @@
+#include "../include/JsonReader.hpp"
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+// Bytes that end a run of plain characters: inside a string (quote,
+// backslash, control characters) and between values (brackets, quotes)
+struct ByteClasses {
+  bool stringSpecial[256] = {};
+  bool structural[256] = {};
+  ByteClasses() {
+    for (int c = 0; c < 0x20; ++c) {
+      stringSpecial[c] = true;
+    }
+    stringSpecial[static_cast<unsigned char>('"')] = true;
+    stringSpecial[static_cast<unsigned char>('\\')] = true;
+    for (char c : {'"', '{', '}', '[', ']'}) {
+      structural[static_cast<unsigned char>(c)] = true;
+    }
+  }
+};
+const ByteClasses byteClasses;
+
+// Eight bytes at a time, then one at a time: the first quote, backslash
+// or control character at or after p
+const char *plainRun(const char *p, const char *end) {
+  constexpr uint64_t ones = 0x0101010101010101ULL;
+  constexpr uint64_t highs = 0x8080808080808080ULL;
+  while (end - p >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    uint64_t quote = word ^ (ones * '"');
+    uint64_t slash = word ^ (ones * '\\');
+    // A byte's high bit is set where it is zero or below 0x20
+    uint64_t special = ((quote - ones) & ~quote) | ((slash - ones) & ~slash) |
+                       ((word - ones * 0x20) & ~word);
+    if ((special & highs) != 0) {
+      break;
+    }
+    p += 8;
+  }
+  while (p < end && !byteClasses.stringSpecial[static_cast<unsigned char>(*p)]) {
+    ++p;
+  }
+  return p;
+}
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+const char *skipSpace(const char *p, const char *end) {
+  while (p < end && isSpace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Four hex digits after a \u; the caller has checked there are four bytes
+unsigned hex4(const char *p) {
+  unsigned value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value = value << 4 | static_cast<unsigned>(hexValue(p[i]));
+  }
+  return value;
+}
+
+// One character past the end of the string, array, object or scalar at p.
+// Only used on validated text, so it never needs to check the grammar.
+const char *skipString(const char *p, const char *end) {
+  const char *start = p + 1;
+  for (const char *q = start;; ++q) {
+    q = static_cast<const char *>(std::memchr(q, '"', end - q));
+    if (q == nullptr) {
+      return end;
+    }
+    // Escaped only if preceded by an odd number of backslashes
+    const char *b = q;
+    while (b > start && b[-1] == '\\') {
+      --b;
+    }
+    if ((q - b) % 2 == 0) {
+      return q + 1;
+    }
+  }
+}
+
+const char *skipValue(const char *p, const char *end) {
+  if (*p == '"') {
+    return skipString(p, end);
+  }
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    while (p < end) {
+      char c = *p;
+      if (c == '"') {
+        p = skipString(p, end);
+        continue;
+      }
+      if (c == '{' || c == '[') {
+        ++depth;
+      } else if ((c == '}' || c == ']') && --depth == 0) {
+        return p + 1;
+      }
+      ++p;
+      while (p < end && !byteClasses.structural[static_cast<unsigned char>(*p)]) {
+        ++p;
+      }
+    }
+    return end;
+  }
+  while (p < end && *p != ',' && *p != '}' && *p != ']' && !isSpace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+void appendUtf8(std::string &out, unsigned cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+// Decode the inside of a validated string literal. Runs without escapes
+// are copied whole; a lone UTF-16 surrogate becomes U+FFFD.
+void unescape(std::string_view raw, std::string &out) {
+  out.clear();
+  out.reserve(raw.size());
+  const char *p = raw.data();
+  const char *end = p + raw.size();
+  while (p < end) {
+    const char *run = p;
+    while (p < end && *p != '\\') {
+      ++p;
+    }
+    out.append(run, p);
+    if (p == end) {
+      break;
+    }
+    char c = p[1];
+    p += 2;
+    switch (c) {
+    case 'b':
+      out += '\b';
+      break;
+    case 'f':
+      out += '\f';
+      break;
+    case 'n':
+      out += '\n';
+      break;
+    case 'r':
+      out += '\r';
+      break;
+    case 't':
+      out += '\t';
+      break;
+    case 'u': {
+      unsigned cp = hex4(p);
+      p += 4;
+      if (cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' &&
+          p[1] == 'u') {
+        unsigned low = hex4(p + 2);
+        if (low >= 0xDC00 && low < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          p += 6;
+        }
+      }
+      if (cp >= 0xD800 && cp < 0xE000) {
+        cp = 0xFFFD;
+      }
+      appendUtf8(out, cp);
+      break;
+    }
+    default:
+      out += c; // \" \\ \/
+    }
+  }
+}
+
+// Compare the inside of a string literal with plain text
+bool keyEquals(std::string_view raw, std::string_view key) {
+  if (raw.find('\\') == std::string_view::npos) {
+    return raw == key;
+  }
+  std::string decoded;
+  unescape(raw, decoded);
+  return decoded == key;
+}
+
+// Recursive-descent validator: checks the grammar, builds nothing
+class Validator {
+public:
+  Validator(std::string_view text)
+      : begin(text.data()), p(text.data()), end(text.data() + text.size()) {}
+
+  bool document() {
+    p = skipSpace(p, end);
+    if (!value(0)) {
+      return false;
+    }
+    p = skipSpace(p, end);
+    return p == end || fail("Unexpected data after the value");
+  }
+
+  const char *valueStart = nullptr;
+  const char *valueEnd = nullptr;
+  const char *message = nullptr;
+  size_t offset() const { return static_cast<size_t>(p - begin); }
+
+private:
+  const char *begin;
+  const char *p;
+  const char *end;
+
+  bool fail(const char *why) {
+    message = why;
+    return false;
+  }
+
+  bool value(int depth) {
+    if (p == end) {
+      return fail("Unexpected end of input");
+    }
+    const char *start = p;
+    bool ok;
+    switch (*p) {
+    case '{':
+      ok = object(depth + 1);
+      break;
+    case '[':
+      ok = array(depth + 1);
+      break;
+    case '"':
+      ok = string();
+      break;
+    case 't':
+      ok = literal("true");
+      break;
+    case 'f':
+      ok = literal("false");
+      break;
+    case 'n':
+      ok = literal("null");
+      break;
+    default:
+      ok = number();
+    }
+    if (ok && depth == 0) {
+      valueStart = start;
+      valueEnd = p;
+    }
+    return ok;
+  }
+
+  bool object(int depth) {
+    if (depth > JsonReader::MAX_DEPTH) {
+      return fail("Nested too deeply");
+    }
+    p = skipSpace(p + 1, end);
+    if (p < end && *p == '}') {
+      ++p;
+      return true;
+    }
+    while (true) {
+      if (p == end || *p != '"') {
+        return fail("Expected a string key");
+      }
+      if (!string()) {
+        return false;
+      }
+      p = skipSpace(p, end);
+      if (p == end || *p != ':') {
+        return fail("Expected ':'");
+      }
+      p = skipSpace(p + 1, end);
+      if (!value(depth)) {
+        return false;
+      }
+      p = skipSpace(p, end);
+      if (p < end && *p == ',') {
+        p = skipSpace(p + 1, end);
+      } else if (p < end && *p == '}') {
+        ++p;
+        return true;
+      } else {
+        return fail("Expected ',' or '}'");
+      }
+    }
+  }
+
+  bool array(int depth) {
+    if (depth > JsonReader::MAX_DEPTH) {
+      return fail("Nested too deeply");
+    }
+    p = skipSpace(p + 1, end);
+    if (p < end && *p == ']') {
+      ++p;
+      return true;
+    }
+    while (true) {
+      if (!value(depth)) {
+        return false;
+      }
+      p = skipSpace(p, end);
+      if (p < end && *p == ',') {
+        p = skipSpace(p + 1, end);
+      } else if (p < end && *p == ']') {
+        ++p;
+        return true;
+      } else {
+        return fail("Expected ',' or ']'");
+      }
+    }
+  }
+
+  bool string() {
+    for (++p; p < end; ++p) {
+      p = plainRun(p, end);
+      if (p == end) {
+        break;
+      }
+      unsigned char c = static_cast<unsigned char>(*p);
+      if (c == '"') {
+        ++p;
+        return true;
+      }
+      if (c < 0x20) {
+        return fail("Control character in string");
+      }
+      if (c != '\\') {
+        continue;
+      }
+      if (++p == end) {
+        break;
+      }
+      switch (*p) {
+      case '"':
+      case '\\':
+      case '/':
+      case 'b':
+      case 'f':
+      case 'n':
+      case 'r':
+      case 't':
+        break;
+      case 'u':
+        if (end - p < 5 || hexValue(p[1]) < 0 || hexValue(p[2]) < 0 ||
+            hexValue(p[3]) < 0 || hexValue(p[4]) < 0) {
+          return fail("Invalid \\u escape");
+        }
+        p += 4;
+        break;
+      default:
+        return fail("Invalid escape");
+      }
+    }
+    return fail("Unterminated string");
+  }
+
+  bool literal(std::string_view word) {
+    if (static_cast<size_t>(end - p) < word.size() ||
+        std::string_view(p, word.size()) != word) {
+      return fail("Invalid literal");
+    }
+    p += word.size();
+    return true;
+  }
+
+  bool digits() {
+    if (p == end || !isDigit(*p)) {
+      return fail("Invalid number");
+    }
+    while (p < end && isDigit(*p)) {
+      ++p;
+    }
+    return true;
+  }
+
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  bool number() {
+    if (p < end && *p == '-') {
+      ++p;
+    }
+    if (p < end && *p == '0') {
+      ++p;
+    } else if (!digits()) {
+      return false;
+    }
+    if (p < end && *p == '.') {
+      ++p;
+      if (!digits()) {
+        return false;
+      }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      ++p;
+      if (p < end && (*p == '+' || *p == '-')) {
+        ++p;
+      }
+      if (!digits()) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+} // namespace
+
+JsonValue JsonValue::at(const char *position, const char *limit) {
+  Type type;
+  switch (*position) {
+  case '{':
+    type = Type::OBJECT;
+    break;
+  case '[':
+    type = Type::ARRAY;
+    break;
+  case '"':
+    type = Type::STRING;
+    break;
+  case 't':
+  case 'f':
+    type = Type::BOOLEAN;
+    break;
+  case 'n':
+    type = Type::NUL;
+    break;
+  default:
+    type = Type::NUMBER;
+  }
+  const char *after = skipValue(position, limit);
+  return JsonValue(type, std::string_view(position, after - position));
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const {
+  if (kind != Type::OBJECT) {
+    return JsonValue();
+  }
+  const char *limit = span.data() + span.size();
+  const char *p = skipSpace(span.data() + 1, limit);
+  while (*p == '"') {
+    const char *keyEnd = skipValue(p, limit);
+    std::string_view name(p + 1, keyEnd - p - 2);
+    p = skipSpace(keyEnd, limit);
+    p = skipSpace(p + 1, limit); // past ':'
+    JsonValue member = at(p, limit);
+    if (keyEquals(name, key)) {
+      return member;
+    }
+    p = skipSpace(member.span.data() + member.span.size(), limit);
+    if (*p != ',') {
+      break;
+    }
+    p = skipSpace(p + 1, limit);
+  }
+  return JsonValue();
+}
+
+bool JsonValue::get(std::string &out) const {
+  if (kind != Type::STRING) {
+    return false;
+  }
+  unescape(span.substr(1, span.size() - 2), out);
+  return true;
+}
+
+bool JsonValue::get(int &out) const {
+  if (kind != Type::NUMBER) {
+    return false;
+  }
+  // Fractions and exponents stop the conversion early and are refused
+  long long value = 0;
+  const char *last = span.data() + span.size();
+  auto result = std::from_chars(span.data(), last, value);
+  if (result.ec != std::errc() || result.ptr != last || value < INT_MIN ||
+      value > INT_MAX) {
+    return false;
+  }
+  out = static_cast<int>(value);
+  return true;
+}
+
+bool JsonValue::get(bool &out) const {
+  if (kind != Type::BOOLEAN) {
+    return false;
+  }
+  out = span[0] == 't';
+  return true;
+}
+
+JsonIterator::JsonIterator(const char *position, const char *l) : limit(l) {
+  if (*position == ']') {
+    current = JsonValue(JsonValue::Type::MISSING, std::string_view(position, 0));
+  } else {
+    current = JsonValue::at(position, limit);
+  }
+}
+
+JsonIterator &JsonIterator::operator++() {
+  const char *p =
+      skipSpace(current.span.data() + current.span.size(), limit);
+  if (*p == ',') {
+    p = skipSpace(p + 1, limit);
+  }
+  *this = JsonIterator(p, limit);
+  return *this;
+}
+
+JsonIterator JsonValue::begin() const {
+  if (kind != Type::ARRAY) {
+    return JsonIterator();
+  }
+  const char *limit = span.data() + span.size();
+  return JsonIterator(skipSpace(span.data() + 1, limit), limit);
+}
+
+JsonIterator JsonValue::end() const {
+  if (kind != Type::ARRAY) {
+    return JsonIterator();
+  }
+  const char *limit = span.data() + span.size();
+  return JsonIterator(limit - 1, limit);
+}
+
+size_t JsonValue::size() const {
+  size_t count = 0;
+  for (auto it = begin(); it != end(); ++it) {
+    ++count;
+  }
+  return count;
+}
+
+bool JsonReader::parse(std::string_view text, JsonValue &root,
+                       std::string *error) {
+  Validator validator(text);
+  if (!validator.document()) {
+    if (error != nullptr) {
+      *error = std::string(validator.message) + " at offset " +
+               std::to_string(validator.offset());
+    }
+    return false;
+  }
+  const char *start = validator.valueStart;
+  root = JsonValue::at(start, validator.valueEnd);
+  return true;
+}
@@ -0,0 +1,170 @@
+#include "../include/JsonWriter.hpp"
+#include <charconv>
+#include <cstring>
+
+namespace {
+// Bytes that cannot appear raw inside a JSON string
+struct EscapeTable {
+  bool needed[256] = {};
+  EscapeTable() {
+    for (int c = 0; c < 0x20; ++c) {
+      needed[c] = true;
+    }
+    needed[static_cast<unsigned char>('"')] = true;
+    needed[static_cast<unsigned char>('\\')] = true;
+  }
+};
+const EscapeTable escapeTable;
+} // namespace
+
+JsonWriter &JsonWriter::beginObject() {
+  comma();
+  out += '{';
+  separate = false;
+  return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+  out += '}';
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+  comma();
+  out += '[';
+  separate = false;
+  return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+  out += ']';
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::key(const char *name) {
+  comma();
+  out += '"';
+  out += name;
+  out += "\":";
+  separate = false;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *text) {
+  return value(text, std::strlen(text));
+}
+
+JsonWriter &JsonWriter::value(const char *text, size_t length) {
+  comma();
+  out += '"';
+  escape(out, text, length);
+  out += '"';
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(bool flag) {
+  comma();
+  out += flag ? "true" : "false";
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+  comma();
+  out += "null";
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::raw(const std::string &json) {
+  comma();
+  out += json;
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::writeSigned(int64_t number) {
+  comma();
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+  out.append(buffer, result.ptr);
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::writeUnsigned(uint64_t number) {
+  comma();
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+  out.append(buffer, result.ptr);
+  separate = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::date(std::chrono::system_clock::time_point time) {
+  std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+  // Time zones shift by whole minutes, so a minute has one local date
+  std::time_t minute = seconds / 60;
+  if (minute != dateMinute) {
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char buffer[11];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &local);
+    std::memcpy(dateText, buffer, sizeof(dateText));
+    dateMinute = minute;
+  }
+  comma();
+  out += '"';
+  out.append(dateText, sizeof(dateText));
+  out += '"';
+  separate = true;
+  return *this;
+}
+
+void JsonWriter::escape(std::string &out, const char *data, size_t length) {
+  static const char hex[] = "0123456789abcdef";
+  size_t run = 0; // start of the pending clean bytes
+  for (size_t i = 0; i < length; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (!escapeTable.needed[c]) {
+      continue;
+    }
+    out.append(data + run, i - run);
+    run = i + 1;
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default: {
+      char unicode[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+      out.append(unicode, sizeof(unicode));
+    }
+    }
+  }
+  out.append(data + run, length - run);
+}
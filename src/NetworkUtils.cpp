@@ -3,7 +3,10 @@
 #include "../include/SocketAbstraction.hpp"
 #include "../include/Task.hpp"
 #include "../include/User.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -22,6 +25,20 @@ NetworkUtils::parseMessage(const std::string &message) {
   return {"", message};
 }
 
+bool NetworkUtils::parseCommand(const std::string &frame, bool binary,
+                                std::string &command) {
+  if (binary) {
+    command = frame; // typed already; a ':' is part of the command
+    return true;
+  }
+  auto parsed = parseMessage(frame);
+  if (parsed.first != "CMD" && !parsed.first.empty()) {
+    return false;
+  }
+  command = parsed.second.empty() ? frame : parsed.second;
+  return true;
+}
+
 std::string NetworkUtils::serializeTask(const Task &task) {
   std::ostringstream oss;
   oss << "TASK|" << task.getTaskId() << "|" << task.getTitle() << "|"
@@ -44,67 +61,86 @@ std::string NetworkUtils::serializeUser(const User &user) {
   return oss.str();
 }
 
-void NetworkUtils::broadcastToAll(const std::vector<ClientInfo> &clients,
-                                  const std::string &message) {
-  for (const auto &client : clients) {
-    if (client.authenticated) {
-      try {
-        int result = SocketAbstraction::sendData(
-            client.socketId, message.c_str(), message.size());
-        if (result < 0) {
-          std::cerr << "Failed to send to client " << client.socketId
-                    << std::endl;
-        }
-      } catch (const std::exception &e) {
-        std::cerr << "Error broadcasting to client " << client.socketId << ": "
-                  << e.what() << std::endl;
-      }
-    }
-  }
+std::string NetworkUtils::taskToJSON(const Task &task) {
+  std::string out;
+  out.reserve(256);
+  JsonWriter json(out);
+  writeTask(json, task);
+  return out;
 }
 
-void NetworkUtils::broadcastToUsers(const std::vector<ClientInfo> &clients,
-                                    const std::vector<int> &userIds,
-                                    const std::string &message) {
-  for (const auto &client : clients) {
-    if (client.authenticated && std::find(userIds.begin(), userIds.end(),
-                                          client.userId) != userIds.end()) {
-      try {
-        int result = SocketAbstraction::sendData(
-            client.socketId, message.c_str(), message.size());
-        if (result < 0) {
-          std::cerr << "Failed to send to user " << client.userId << std::endl;
-        }
-      } catch (const std::exception &e) {
-        std::cerr << "Error sending to user " << client.userId << ": "
-                  << e.what() << std::endl;
-      }
-    }
-  }
+std::string NetworkUtils::chatToJSON(const Chat &chat) {
+  std::string out;
+  out.reserve(256);
+  JsonWriter json(out);
+  writeChat(json, chat);
+  return out;
 }
 
-void NetworkUtils::sendToUser(const std::vector<ClientInfo> &clients,
-                              int userId, const std::string &message) {
-  bool messageSent = false;
-  for (const auto &client : clients) {
-    if (client.authenticated && client.userId == userId) {
-      try {
-        int result = SocketAbstraction::sendData(
-            client.socketId, message.c_str(), message.size());
-        if (result >= 0) {
-          messageSent = true;
-        } else {
-          std::cerr << "Failed to send to user " << userId << std::endl;
-        }
-      } catch (const std::exception &e) {
-        std::cerr << "Error sending to user " << userId << ": " << e.what()
-                  << std::endl;
-      }
-    }
-  }
-  if (!messageSent) {
-    std::cerr << "User " << userId << " not found or not online" << std::endl;
-  }
+std::string NetworkUtils::userToJSON(const User &user,
+                                     const std::string &username) {
+  std::string out;
+  JsonWriter json(out);
+  writeUser(json, user, username);
+  return out;
+}
+
+std::string NetworkUtils::admissionToJSON(const AdmissionControl::Stats &stats) {
+  std::string out;
+  JsonWriter json(out);
+  writeAdmission(json, stats);
+  return out;
+}
+
+void NetworkUtils::writeTask(JsonWriter &json, const Task &task) {
+  json.beginObject()
+      .field("id", task.getTaskId())
+      .field("title", task.getTitle())
+      .field("description", task.getDescription())
+      .field("status", task.getStatusString())
+      .field("priority", task.getPriorityString())
+      .field("assigneeId", task.getAssigneeId())
+      .field("reporterId", task.getReporterId())
+      .field("projectKey", task.getProjectKey())
+      .key("deadline")
+      .date(task.getDeadline())
+      .field("isOverdue", task.isOverdue())
+      .field("daysUntilDeadline", task.getDaysUntilDeadline())
+      .endObject();
+}
+
+void NetworkUtils::writeChat(JsonWriter &json, const Chat &chat) {
+  json.beginObject()
+      .field("id", chat.getMessageId())
+      .field("senderId", chat.getSenderId())
+      .field("senderName", chat.getSenderName())
+      .field("content", chat.getContent())
+      .field("type", chat.getTypeString())
+      .field("timestamp", chat.getTimestamp())
+      .field("targetUserId", chat.getTargetUserId())
+      .field("relatedTaskId", chat.getRelatedTaskId())
+      .endObject();
+}
+
+void NetworkUtils::writeUser(JsonWriter &json, const User &user,
+                             const std::string &username) {
+  json.beginObject()
+      .field("id", user.getUserId())
+      .field("username", username)
+      .field("email", user.getEmail())
+      .field("role", user.getRoleString())
+      .field("isOnline", user.getOnlineStatus())
+      .endObject();
+}
+
+void NetworkUtils::writeAdmission(JsonWriter &json,
+                                  const AdmissionControl::Stats &stats) {
+  json.beginObject()
+      .field("inFlight", stats.inFlight)
+      .field("admitted", stats.admitted)
+      .field("shed", stats.shed)
+      .field("expired", stats.expired)
+      .endObject();
 }
 
 bool NetworkUtils::authenticateUser(const std::string &username,
@@ -148,4 +184,105 @@ std::string NetworkUtils::trim(const std::string &str) {
 
   size_t end = str.find_last_not_of(" \t\n\r");
   return str.substr(start, end - start + 1);
-}
\ No newline at end of file
+}
+std::string NetworkUtils::escapeJSON(const std::string &str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  JsonWriter::escape(escaped, str.data(), str.size());
+  return escaped;
+}
+
+std::string NetworkUtils::sha1(const std::string &data) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                   0xC3D2E1F0};
+  auto rotl = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+
+  // Pad to a multiple of 64 bytes: 0x80, zeros, then the bit length
+  std::string msg = data;
+  uint64_t bitLength = static_cast<uint64_t>(data.size()) * 8;
+  msg += static_cast<char>(0x80);
+  while (msg.size() % 64 != 56) {
+    msg += static_cast<char>(0x00);
+  }
+  for (int i = 7; i >= 0; --i) {
+    msg += static_cast<char>((bitLength >> (i * 8)) & 0xFF);
+  }
+
+  for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const unsigned char *p =
+          reinterpret_cast<const unsigned char *>(msg.data() + chunk + i * 4);
+      w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+             (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+    for (int i = 16; i < 80; ++i) {
+      w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  std::string digest;
+  for (uint32_t word : h) {
+    for (int i = 3; i >= 0; --i) {
+      digest += static_cast<char>((word >> (i * 8)) & 0xFF);
+    }
+  }
+  return digest;
+}
+
+std::string NetworkUtils::base64Encode(const std::string &data) {
+  static const char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve((data.size() + 2) / 3 * 4);
+
+  size_t i = 0;
+  for (; i + 2 < data.size(); i += 3) {
+    uint32_t n = (uint32_t(uint8_t(data[i])) << 16) |
+                 (uint32_t(uint8_t(data[i + 1])) << 8) | uint8_t(data[i + 2]);
+    out += alphabet[(n >> 18) & 63];
+    out += alphabet[(n >> 12) & 63];
+    out += alphabet[(n >> 6) & 63];
+    out += alphabet[n & 63];
+  }
+  if (i < data.size()) {
+    uint32_t n = uint32_t(uint8_t(data[i])) << 16;
+    if (i + 1 < data.size()) {
+      n |= uint32_t(uint8_t(data[i + 1])) << 8;
+    }
+    out += alphabet[(n >> 18) & 63];
+    out += alphabet[(n >> 12) & 63];
+    out += (i + 1 < data.size()) ? alphabet[(n >> 6) & 63] : '=';
+    out += '=';
+  }
+  return out;
+}
@@ -0,0 +1,106 @@
+#include "../include/OutboundQueue.hpp"
+
+bool OutboundQueue::push(SharedFrame frame, std::string key) {
+  uint64_t seq = nextSeq++;
+  size_t size = frame->size();
+  if (limits.policy == Policy::COALESCE && !key.empty()) {
+    auto it = newest.find(key);
+    if (it != newest.end()) {
+      queuedBytes -= it->second.size;
+      --liveFrames;
+      ++coalesced;
+      it->second = {seq, size};
+    } else {
+      newest.emplace(key, Newest{seq, size});
+    }
+  }
+  queuedBytes += size;
+  ++liveFrames;
+  frames.push_back({std::move(frame), std::move(key), seq});
+  if (queuedBytes <= limits.highWater) {
+    return true;
+  }
+  if (limits.policy == Policy::DISCONNECT) {
+    return false;
+  }
+
+  // Oldest first; the newest frame stays even if it alone passes the mark
+  Frame oldest;
+  while (queuedBytes > limits.highWater && liveFrames > 1) {
+    if (popFront(oldest)) {
+      ++dropped;
+    }
+  }
+  return true;
+}
+
+void OutboundQueue::take(WriteBatch &out, size_t maxBytes, size_t maxFrames) {
+  Frame front;
+  while (liveFrames > 0 && out.bytes() < maxBytes &&
+         out.frameCount() < maxFrames) {
+    if (popFront(front)) {
+      out.add(std::move(front.bytes));
+    }
+  }
+}
+
+void OutboundQueue::clear() {
+  frames.clear();
+  newest.clear();
+  queuedBytes = 0;
+  liveFrames = 0;
+}
+
+bool OutboundQueue::popFront(Frame &frame) {
+  frame = std::move(frames.front());
+  frames.pop_front();
+  if (limits.policy == Policy::COALESCE && !frame.key.empty()) {
+    auto it = newest.find(frame.key);
+    if (it == newest.end() || it->second.seq != frame.seq) {
+      return false; // replaced by a later frame
+    }
+    newest.erase(it);
+  }
+  queuedBytes -= frame.bytes->size();
+  --liveFrames;
+  return true;
+}
+
+void WriteBatch::add(SharedFrame frame) {
+  if (frame->empty()) {
+    return; // nothing to send, and it would never be consumed
+  }
+  remaining += frame->size();
+  frames.push_back(std::move(frame));
+}
+
+void WriteBatch::consume(size_t sent) {
+  remaining -= sent;
+  while (sent > 0) {
+    size_t left = frames.front()->size() - offset;
+    if (sent < left) {
+      offset += sent;
+      return;
+    }
+    sent -= left;
+    frames.pop_front();
+    offset = 0;
+  }
+}
+
+void WriteBatch::clear() {
+  frames.clear();
+  offset = 0;
+  remaining = 0;
+}
+
+const IoSlice *WriteBatch::slices(size_t &count) {
+  io.clear();
+  size_t skip = offset;
+  for (const auto &frame : frames) {
+    io.push_back({frame->data() + skip, frame->size() - skip});
+    skip = 0;
+  }
+  count = io.size();
+  return io.data();
+}
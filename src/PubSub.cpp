@@ -0,0 +1,180 @@
+#include "../include/PubSub.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+const std::string PubSub::TOPIC_CHAT = "chat";
+const std::string PubSub::TOPIC_TASKS = "tasks";
+const std::string PubSub::TOPIC_PRESENCE = "presence";
+
+std::string PubSub::taskTopic(int taskId) {
+  return "task:" + std::to_string(taskId);
+}
+
+std::string PubSub::userTopic(int userId) {
+  return "user:" + std::to_string(userId);
+}
+
+Subscription::Subscription(size_t capacity, std::function<void()> notifier)
+    : queue(capacity), notifier(std::move(notifier)), dropped(0),
+      closed(false), waiters(0) {}
+
+bool Subscription::tryPop(PubSubMessagePtr &out) { return queue.tryPop(out); }
+
+bool Subscription::waitPop(PubSubMessagePtr &out,
+                           std::chrono::steady_clock::time_point deadline) {
+  while (true) {
+    if (queue.tryPop(out)) {
+      return true;
+    }
+    if (closed) {
+      return false;
+    }
+
+    std::unique_lock<std::mutex> lock(waitMutex);
+    waiters++;
+    bool ready = wakeup.wait_until(
+        lock, deadline, [this] { return closed || queue.size() > 0; });
+    waiters--;
+    if (!ready) {
+      return queue.tryPop(out);
+    }
+  }
+}
+
+void Subscription::close() {
+  closed = true;
+  {
+    std::lock_guard<std::mutex> lock(waitMutex);
+  }
+  wakeup.notify_all();
+  if (notifier) {
+    notifier();
+  }
+}
+
+bool Subscription::deliver(const PubSubMessagePtr &message) {
+  if (closed) {
+    return false;
+  }
+  if (!queue.tryPush(message)) {
+    dropped++;
+    return false;
+  }
+  return true;
+}
+
+void Subscription::signal() {
+  if (notifier) {
+    notifier();
+  }
+  // Only touch the mutex when a consumer is actually asleep
+  if (waiters > 0) {
+    {
+      std::lock_guard<std::mutex> lock(waitMutex);
+    }
+    wakeup.notify_one();
+  }
+}
+
+PubSub::PubSub() : topics(std::make_shared<const TopicMap>()) {}
+
+void PubSub::addLocked(const SubscriptionPtr &subscription,
+                       const std::string &topic, TopicMap &map) {
+  if (std::find(subscription->topics.begin(), subscription->topics.end(),
+                topic) != subscription->topics.end()) {
+    return;
+  }
+  auto list = std::make_shared<SubscriberList>();
+  auto it = map.find(topic);
+  if (it != map.end()) {
+    *list = *it->second;
+  }
+  list->push_back(subscription);
+  map[topic] = list;
+  subscription->topics.push_back(topic);
+}
+
+SubscriptionPtr PubSub::subscribe(const std::vector<std::string> &topicNames,
+                                  size_t capacity,
+                                  std::function<void()> notifier) {
+  auto subscription =
+      std::make_shared<Subscription>(capacity, std::move(notifier));
+  if (topicNames.empty()) {
+    return subscription;
+  }
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto map = std::make_shared<TopicMap>(*std::atomic_load(&topics));
+  for (const auto &topic : topicNames) {
+    addLocked(subscription, topic, *map);
+  }
+  std::atomic_store(&topics, std::shared_ptr<const TopicMap>(map));
+  return subscription;
+}
+
+void PubSub::addTopic(const SubscriptionPtr &subscription,
+                      const std::string &topic) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto map = std::make_shared<TopicMap>(*std::atomic_load(&topics));
+  addLocked(subscription, topic, *map);
+  std::atomic_store(&topics, std::shared_ptr<const TopicMap>(map));
+}
+
+void PubSub::unsubscribe(const SubscriptionPtr &subscription) {
+  subscription->close();
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto map = std::make_shared<TopicMap>(*std::atomic_load(&topics));
+  for (const auto &topic : subscription->topics) {
+    auto it = map->find(topic);
+    if (it == map->end()) {
+      continue;
+    }
+    auto list = std::make_shared<SubscriberList>(*it->second);
+    list->erase(std::remove(list->begin(), list->end(), subscription),
+                list->end());
+    if (list->empty()) {
+      map->erase(it);
+    } else {
+      it->second = list;
+    }
+  }
+  subscription->topics.clear();
+  std::atomic_store(&topics, std::shared_ptr<const TopicMap>(map));
+}
+
+void PubSub::publish(const std::vector<std::string> &topicNames,
+                     const PubSubMessagePtr &message) {
+  publishBatch({Delivery{topicNames, message}});
+}
+
+void PubSub::publishBatch(const std::vector<Delivery> &batch) {
+  auto snapshot = std::atomic_load(&topics);
+  std::unordered_set<Subscription *> woken;   // to signal once at the end
+  std::unordered_set<Subscription *> reached; // per multi-topic message
+  for (const auto &delivery : batch) {
+    bool multiTopic = delivery.topics.size() > 1;
+    reached.clear();
+    for (const auto &topic : delivery.topics) {
+      auto it = snapshot->find(topic);
+      if (it == snapshot->end()) {
+        continue;
+      }
+      for (const auto &subscription : *it->second) {
+        // A subscriber on several of the topics still gets one copy
+        Subscription *target = subscription.get();
+        if (multiTopic && !reached.insert(target).second) {
+          continue;
+        }
+        if (target->deliver(delivery.message)) {
+          woken.insert(target);
+        }
+      }
+    }
+  }
+
+  // The snapshot keeps every subscriber alive until it is signalled
+  for (Subscription *target : woken) {
+    target->signal();
+  }
+}
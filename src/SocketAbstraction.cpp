@@ -1,4 +1,5 @@
 #include "../include/SocketAbstraction.hpp"
+#include <cstddef>
 #include <iostream>
 #include <sstream>
 
@@ -67,7 +68,7 @@ bool SocketAbstraction::listenSocket(SocketHandle socket, int backlog) {
 
 SocketHandle SocketAbstraction::acceptSocket(SocketHandle socket) {
   SocketHandle clientSocket = accept(socket, nullptr, nullptr);
-  if (!isValidSocket(clientSocket)) {
+  if (!isValidSocket(clientSocket) && !wouldBlock()) {
     std::cerr << "Accept failed: " << getLastError() << std::endl;
     return INVALID_SOCKET_HANDLE;
   }
@@ -104,7 +105,38 @@ int SocketAbstraction::sendData(SocketHandle socket, const char *data,
   int result = send(socket, data, length, MSG_NOSIGNAL);
 #endif
 
-  if (result < 0) {
+  if (result < 0 && !wouldBlock()) {
+    std::cerr << "Send failed: " << getLastError() << std::endl;
+  }
+
+  return result;
+}
+
+int SocketAbstraction::sendVector(SocketHandle socket, const IoSlice *slices,
+                                  size_t count) {
+#ifdef _WIN32
+  std::vector<WSABUF> buffers(count);
+  for (size_t i = 0; i < count; ++i) {
+    buffers[i].buf = const_cast<CHAR *>(slices[i].data);
+    buffers[i].len = static_cast<ULONG>(slices[i].length);
+  }
+  DWORD sent = 0;
+  int result = WSASend(socket, buffers.data(), static_cast<DWORD>(count),
+                       &sent, 0, nullptr, nullptr) == 0
+                   ? static_cast<int>(sent)
+                   : -1;
+#else
+  static_assert(sizeof(IoSlice) == sizeof(iovec) &&
+                    offsetof(IoSlice, data) == offsetof(iovec, iov_base) &&
+                    offsetof(IoSlice, length) == offsetof(iovec, iov_len),
+                "IoSlice must match struct iovec");
+  msghdr message{};
+  message.msg_iov = reinterpret_cast<iovec *>(const_cast<IoSlice *>(slices));
+  message.msg_iovlen = count;
+  int result = static_cast<int>(sendmsg(socket, &message, MSG_NOSIGNAL));
+#endif
+
+  if (result < 0 && !wouldBlock()) {
     std::cerr << "Send failed: " << getLastError() << std::endl;
   }
 
@@ -119,7 +151,7 @@ int SocketAbstraction::receiveData(SocketHandle socket, char *buffer,
   int result = recv(socket, buffer, length, 0);
 #endif
 
-  if (result < 0) {
+  if (result < 0 && !wouldBlock()) {
     std::cerr << "Receive failed: " << getLastError() << std::endl;
   }
 
@@ -152,6 +184,71 @@ bool SocketAbstraction::setReuseAddress(SocketHandle socket) {
   return true;
 }
 
+bool SocketAbstraction::setReusePort(SocketHandle socket) {
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  // Only Linux balances connections across the listeners; elsewhere the
+  // option exists but one socket would take them all
+  int opt = 1;
+  if (setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+    std::cerr << "Failed to set SO_REUSEPORT: " << getLastError() << std::endl;
+    return false;
+  }
+  return true;
+#else
+  (void)socket;
+  return false;
+#endif
+}
+
+bool SocketAbstraction::setNoDelay(SocketHandle socket) {
+  int opt = 1;
+#ifdef _WIN32
+  if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&opt,
+                 sizeof(opt)) < 0) {
+#else
+  if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
+#endif
+    std::cerr << "Failed to set TCP_NODELAY: " << getLastError() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void SocketAbstraction::shutdownSocket(SocketHandle socket) {
+  if (!isValidSocket(socket)) {
+    return;
+  }
+#ifdef _WIN32
+  shutdown(socket, SD_BOTH);
+#else
+  shutdown(socket, SHUT_RDWR);
+#endif
+}
+
+bool SocketAbstraction::setNonBlocking(SocketHandle socket, bool enabled) {
+#ifdef _WIN32
+  u_long mode = enabled ? 1 : 0;
+  if (ioctlsocket(socket, FIONBIO, &mode) != 0) {
+#else
+  int flags = fcntl(socket, F_GETFL, 0);
+  flags = enabled ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+  if (flags < 0 || fcntl(socket, F_SETFL, flags) < 0) {
+#endif
+    std::cerr << "Failed to set non-blocking mode: " << getLastError()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool SocketAbstraction::wouldBlock() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
 std::string SocketAbstraction::getLastError() {
 #ifdef _WIN32
   int errorCode = WSAGetLastError();
@@ -193,3 +290,201 @@ bool SocketAbstraction::isValidSocket(SocketHandle socket) {
   return socket >= 0;
 #endif
 }
+
+#ifdef __linux__
+
+EventPoller::EventPoller()
+    : wakePending(false), syscallCount(0),
+      epollFd(epoll_create1(EPOLL_CLOEXEC)),
+      wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  if (epollFd < 0 || wakeFd < 0) {
+    std::cerr << "Failed to create event poller: "
+              << SocketAbstraction::getLastError() << std::endl;
+    return;
+  }
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = wakeFd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+EventPoller::~EventPoller() {
+  if (wakeFd >= 0)
+    close(wakeFd);
+  if (epollFd >= 0)
+    close(epollFd);
+}
+
+bool EventPoller::isValid() const { return epollFd >= 0 && wakeFd >= 0; }
+
+bool EventPoller::add(SocketHandle socket) {
+  // Write readiness is always watched: edge-triggered, it only fires when
+  // a full send buffer drains
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  event.data.fd = socket;
+  ++syscallCount;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) < 0) {
+    std::cerr << "epoll_ctl add failed: " << SocketAbstraction::getLastError()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void EventPoller::setWriteInterest(SocketHandle, bool) {}
+
+void EventPoller::remove(SocketHandle socket) {
+  ++syscallCount;
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, nullptr);
+}
+
+int EventPoller::wait(std::vector<Event> &events, int timeoutMs) {
+  epoll_event ready[256];
+  ++syscallCount;
+  int count = epoll_wait(epollFd, ready, 256, timeoutMs);
+  events.clear();
+  if (count < 0) {
+    return errno == EINTR ? 0 : -1;
+  }
+  for (int i = 0; i < count; ++i) {
+    if (ready[i].data.fd == wakeFd) {
+      uint64_t value;
+      do {
+        ++syscallCount;
+      } while (read(wakeFd, &value, sizeof(value)) > 0);
+      wakePending = false;
+      continue;
+    }
+    uint32_t flags = ready[i].events;
+    events.push_back(
+        {ready[i].data.fd,
+         (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0,
+         (flags & (EPOLLOUT | EPOLLERR)) != 0});
+  }
+  return static_cast<int>(events.size());
+}
+
+void EventPoller::wakeup() {
+  // One pending wakeup is enough: the loop handles all posted work after
+  // every wait
+  if (!wakePending.exchange(true)) {
+    uint64_t one = 1;
+    ++syscallCount;
+    if (write(wakeFd, &one, sizeof(one)) < 0) {
+      wakePending = false;
+    }
+  }
+}
+
+#else
+
+EventPoller::EventPoller() : wakePending(false), syscallCount(0) {
+#ifndef _WIN32
+  if (pipe(wakePipe) == 0) {
+    SocketAbstraction::setNonBlocking(wakePipe[0]);
+    SocketAbstraction::setNonBlocking(wakePipe[1]);
+    watched.push_back({wakePipe[0], POLLIN, 0});
+  } else {
+    wakePipe[0] = wakePipe[1] = -1;
+  }
+#endif
+}
+
+EventPoller::~EventPoller() {
+#ifndef _WIN32
+  if (wakePipe[0] >= 0) {
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+  }
+#endif
+}
+
+bool EventPoller::isValid() const {
+#ifdef _WIN32
+  return true;
+#else
+  return wakePipe[0] >= 0;
+#endif
+}
+
+bool EventPoller::add(SocketHandle socket) {
+  pollfd entry{};
+  entry.fd = socket;
+  entry.events = POLLIN;
+  watched.push_back(entry);
+  return true;
+}
+
+void EventPoller::setWriteInterest(SocketHandle socket, bool enabled) {
+  for (auto &entry : watched) {
+    if (entry.fd == socket) {
+      entry.events = enabled ? (POLLIN | POLLOUT) : POLLIN;
+      return;
+    }
+  }
+}
+
+void EventPoller::remove(SocketHandle socket) {
+  for (size_t i = 0; i < watched.size(); ++i) {
+    if (watched[i].fd == socket) {
+      watched[i] = watched.back();
+      watched.pop_back();
+      return;
+    }
+  }
+}
+
+int EventPoller::wait(std::vector<Event> &events, int timeoutMs) {
+  events.clear();
+#ifdef _WIN32
+  // No self-pipe for WSAPoll: cap the wait so posted work is seen promptly
+  if (timeoutMs < 0 || timeoutMs > 10)
+    timeoutMs = 10;
+  if (watched.empty()) {
+    Sleep(timeoutMs);
+    return 0;
+  }
+  ++syscallCount;
+  int count = WSAPoll(watched.data(), static_cast<ULONG>(watched.size()),
+                      timeoutMs);
+#else
+  ++syscallCount;
+  int count = poll(watched.data(), watched.size(), timeoutMs);
+#endif
+  if (count <= 0) {
+    return count < 0 && SOCKET_ERROR_CODE != EINTR ? -1 : 0;
+  }
+  for (const auto &entry : watched) {
+    if (entry.revents == 0)
+      continue;
+#ifndef _WIN32
+    if (entry.fd == wakePipe[0]) {
+      char drain[64];
+      do {
+        ++syscallCount;
+      } while (read(wakePipe[0], drain, sizeof(drain)) > 0);
+      wakePending = false;
+      continue;
+    }
+#endif
+    events.push_back(
+        {entry.fd, (entry.revents & (POLLIN | POLLHUP | POLLERR)) != 0,
+         (entry.revents & (POLLOUT | POLLERR)) != 0});
+  }
+  return static_cast<int>(events.size());
+}
+
+void EventPoller::wakeup() {
+#ifndef _WIN32
+  if (!wakePending.exchange(true)) {
+    char one = 1;
+    ++syscallCount;
+    if (write(wakePipe[1], &one, 1) < 0) {
+      wakePending = false;
+    }
+  }
+#endif
+}
+
+#endif
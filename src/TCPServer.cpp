@@ -0,0 +1,1139 @@
+#include "../include/TCPServer.hpp"
+#include "../include/BinaryProtocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+// Keeps a reactor's sockets and cache lines on one core
+void pinCurrentThread(size_t cpu) {
+#ifdef __linux__
+  unsigned cpus = std::thread::hardware_concurrency();
+  if (cpus == 0) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % cpus, &set);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    std::cerr << "Failed to pin TCP reactor to CPU " << cpu % cpus << ": "
+              << std::strerror(err) << std::endl;
+  }
+#else
+  (void)cpu;
+#endif
+}
+
+// io_uring user data: the socket, and which operation completed
+enum Operation : uint64_t { OP_ACCEPT = 1, OP_RECEIVE = 2, OP_SEND = 3 };
+
+uint64_t tag(SocketHandle socket, Operation op) {
+  return (static_cast<uint64_t>(socket) << 8) | op;
+}
+
+// The tagged command a worker is running. What it sends to its own
+// connection is collected here and goes out as one reply with the id.
+struct ReplyCapture {
+  SocketHandle socket;
+  std::vector<std::string> messages; // as the connection's protocol sends
+};
+thread_local ReplyCapture *replyCapture = nullptr;
+
+// Splits "@<id> <command>" into its parts; frames without a well-formed
+// id are left alone and run as they are
+void splitRequestId(std::string &frame, std::string &requestId,
+                    size_t maxLength) {
+  if (frame.empty() || frame[0] != '@') {
+    return;
+  }
+  size_t space = frame.find(' ');
+  if (space == std::string::npos || space == 1 || space - 1 > maxLength) {
+    return;
+  }
+  requestId = frame.substr(1, space - 1);
+  frame.erase(0, space + 1);
+}
+} // namespace
+
+TCPServer::TCPServer(PubSub &ps, Options opts)
+    : pubSub(ps), options(opts), admission(opts.admission), running(false),
+      nextReactor(0), workers(opts.workerThreads) {
+  for (size_t i = 0; i < std::max<size_t>(1, options.reactors); ++i) {
+    reactors.push_back(std::make_unique<Reactor>());
+    reactors.back()->index = i;
+  }
+}
+
+TCPServer::~TCPServer() { stop(); }
+
+void TCPServer::setHandlers(Handlers h) { handlers = std::move(h); }
+
+bool TCPServer::listen(Reactor &reactor, int port, bool reusePort) {
+  SocketHandle socket = SocketAbstraction::createSocket();
+  if (!SocketAbstraction::isValidSocket(socket)) {
+    return false;
+  }
+  if (!SocketAbstraction::setReuseAddress(socket) ||
+      (reusePort && !SocketAbstraction::setReusePort(socket)) ||
+      !SocketAbstraction::bindSocket(socket, port) ||
+      !SocketAbstraction::listenSocket(socket, 512) ||
+      !SocketAbstraction::setNonBlocking(socket) ||
+      (!reactor.ring && !reactor.poller.add(socket))) {
+    SocketAbstraction::closeSocket(socket);
+    return false;
+  }
+  reactor.listenSocket = socket;
+  return true;
+}
+
+bool TCPServer::start(int port) {
+  for (const auto &reactor : reactors) {
+    if (!reactor->poller.isValid()) {
+      return false;
+    }
+  }
+  if (options.backend == IoBackend::IO_URING) {
+    for (const auto &reactor : reactors) {
+      reactor->ring =
+          std::make_unique<IoUring>(IoUring::DEFAULT_ENTRIES, READ_CHUNK_SIZE);
+      if (!reactor->ring->isValid()) {
+        std::cerr << "io_uring unavailable, TCP server falls back to epoll"
+                  << std::endl;
+        for (const auto &each : reactors) {
+          each->ring.reset();
+        }
+        options.backend = IoBackend::EPOLL;
+        break;
+      }
+    }
+  }
+
+  // One listener per reactor when the kernel can balance between them,
+  // otherwise the first reactor accepts for everyone
+  bool sharded = reactors.size() > 1 &&
+                 listen(*reactors[0], port, /*reusePort=*/true);
+  for (size_t i = 1; sharded && i < reactors.size(); ++i) {
+    if (!listen(*reactors[i], port, /*reusePort=*/true)) {
+      sharded = false;
+    }
+  }
+  if (!sharded) {
+    for (const auto &reactor : reactors) {
+      if (!reactor->ring) {
+        reactor->poller.remove(reactor->listenSocket);
+      }
+      SocketAbstraction::closeSocket(reactor->listenSocket);
+      reactor->listenSocket = INVALID_SOCKET_HANDLE;
+    }
+    if (!listen(*reactors[0], port, /*reusePort=*/false)) {
+      std::cerr << "ERROR: TCP server failed to listen on port " << port
+                << std::endl;
+      return false;
+    }
+  }
+
+  bool uring = options.backend == IoBackend::IO_URING;
+  std::cout << "TCP Socket Server running on port " << port << " ("
+            << reactors.size() << (sharded ? " sharded" : "") << " "
+            << (uring ? "io_uring" : "epoll") << " reactors, "
+            << workers.size() << " worker threads)..." << std::endl;
+  running = true;
+  for (size_t i = 1; i < reactors.size(); ++i) {
+    Reactor &reactor = *reactors[i];
+    reactor.thread = std::thread([this, &reactor, uring] {
+      uring ? uringLoop(reactor) : eventLoop(reactor);
+    });
+  }
+  uring ? uringLoop(*reactors[0]) : eventLoop(*reactors[0]);
+
+  for (const auto &reactor : reactors) {
+    if (reactor->thread.joinable()) {
+      reactor->thread.join();
+    }
+  }
+  for (const auto &reactor : reactors) {
+    closeAll(*reactor);
+  }
+  return true;
+}
+
+void TCPServer::stop() {
+  if (running.exchange(false)) {
+    for (const auto &reactor : reactors) {
+      reactor->wakeup();
+    }
+  }
+}
+
+void TCPServer::eventLoop(Reactor &reactor) {
+  if (options.pinToCpus) {
+    pinCurrentThread(reactor.index);
+  }
+
+  std::vector<EventPoller::Event> events;
+  PostedWork work;
+  reactor.now = std::chrono::steady_clock::now();
+  while (running) {
+    if (reactor.poller.wait(events, waitTimeout(reactor)) < 0) {
+      std::cerr << "Event loop wait failed: "
+                << SocketAbstraction::getLastError() << std::endl;
+      stop();
+      break;
+    }
+    reactor.now = std::chrono::steady_clock::now();
+
+    for (const auto &event : events) {
+      if (event.socket == reactor.listenSocket) {
+        acceptConnections(reactor);
+        continue;
+      }
+      ConnectionPtr conn = find(reactor, event.socket);
+      if (!conn) {
+        continue;
+      }
+      if (event.readable) {
+        readFrom(conn);
+      }
+      if (event.writable) {
+        flush(conn);
+      }
+    }
+    processPosted(reactor, work);
+    reactor.timers.advance(reactor.now);
+  }
+}
+
+void TCPServer::uringLoop(Reactor &reactor) {
+  if (options.pinToCpus) {
+    pinCurrentThread(reactor.index);
+  }
+
+  IoUring &ring = *reactor.ring;
+  if (SocketAbstraction::isValidSocket(reactor.listenSocket)) {
+    ring.prepareAccept(reactor.listenSocket,
+                       tag(reactor.listenSocket, OP_ACCEPT));
+  }
+  std::vector<IoUring::Completion> completions;
+  PostedWork work;
+  reactor.now = std::chrono::steady_clock::now();
+  while (running) {
+    // Submits the sends, receives and re-arms queued by the last pass
+    if (ring.submitAndWait(completions, waitTimeout(reactor)) < 0) {
+      std::cerr << "io_uring wait failed: "
+                << SocketAbstraction::getLastError() << std::endl;
+      stop();
+      break;
+    }
+    reactor.now = std::chrono::steady_clock::now();
+
+    for (const auto &done : completions) {
+      auto socket = static_cast<SocketHandle>(done.userData >> 8);
+      switch (static_cast<Operation>(done.userData & 0xff)) {
+      case OP_ACCEPT:
+        if (done.result >= 0) {
+          accepted(reactor, done.result);
+        } else if (done.result != -ECONNABORTED && done.result != -EINTR) {
+          std::cerr << "Accept failed: " << std::strerror(-done.result)
+                    << std::endl;
+        }
+        if (!done.more && running) {
+          ring.prepareAccept(socket, done.userData);
+        }
+        break;
+      case OP_RECEIVE: {
+        ConnectionPtr conn = find(reactor, socket);
+        if (done.bufferId >= 0) {
+          if (conn && done.result > 0) {
+            received(conn, ring.buffer(done.bufferId), done.result);
+          }
+          ring.recycleBuffer(done.bufferId);
+        }
+        if (!conn || done.more) {
+          break;
+        }
+        if (done.result > 0 || done.result == -ENOBUFS) {
+          ring.prepareReceive(socket, done.userData); // ran out of buffers
+        } else {
+          beginDisconnect(conn);
+        }
+        break;
+      }
+      case OP_SEND:
+        if (ConnectionPtr conn = find(reactor, socket)) {
+          sendCompleted(conn, done.result);
+        }
+        break;
+      }
+    }
+    processPosted(reactor, work);
+    reactor.timers.advance(reactor.now);
+  }
+}
+
+void TCPServer::processPosted(Reactor &reactor, PostedWork &work) {
+  // Handed-off sockets, replies, events and finished disconnects
+  {
+    std::lock_guard<std::mutex> lock(reactor.postedMutex);
+    work.adopt.swap(reactor.posted.adopt);
+    work.flush.swap(reactor.posted.flush);
+    work.close.swap(reactor.posted.close);
+  }
+  for (const auto &conn : work.adopt) {
+    adopt(reactor, conn);
+  }
+  for (const auto &conn : work.flush) {
+    flush(conn);
+  }
+  for (const auto &conn : work.close) {
+    finishDisconnect(conn);
+  }
+  work.adopt.clear();
+  work.flush.clear();
+  work.close.clear();
+}
+
+int TCPServer::waitTimeout(const Reactor &reactor) const {
+  // At least once a second regardless, as before there were timers
+  auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+      reactor.timers.timeUntilNext(std::chrono::steady_clock::now()));
+  return static_cast<int>(
+      std::min<std::chrono::milliseconds::rep>(wait.count(), 1000));
+}
+
+void TCPServer::acceptConnections(Reactor &reactor) {
+  // Edge-triggered: take every pending connection now
+  while (true) {
+    ++reactor.syscalls;
+    SocketHandle socket = SocketAbstraction::acceptSocket(reactor.listenSocket);
+    if (!SocketAbstraction::isValidSocket(socket)) {
+      return;
+    }
+    SocketAbstraction::setNonBlocking(socket);
+    accepted(reactor, socket);
+  }
+}
+
+void TCPServer::accepted(Reactor &reactor, SocketHandle socket) {
+  if (options.maxConnections > 0 &&
+      connectionCount() >= options.maxConnections) {
+    // Best effort on the fresh socket's empty buffer, then close
+    ++reactor.rejectedConnections;
+    std::string busy = Framing::encode(busyMessage());
+    SocketAbstraction::sendData(socket, busy.data(), busy.size());
+    SocketAbstraction::closeSocket(socket);
+    return;
+  }
+  SocketAbstraction::setNoDelay(socket);
+  auto conn = std::make_shared<Connection>(options.output);
+  conn->socket = socket;
+
+  bool handOff = reactors.size() > 1 &&
+                 reactors[1]->listenSocket == INVALID_SOCKET_HANDLE;
+  Reactor &owner =
+      handOff ? *reactors[nextReactor++ % reactors.size()] : reactor;
+  if (&owner == &reactor) {
+    adopt(reactor, conn);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(owner.postedMutex);
+    owner.posted.adopt.push_back(conn);
+  }
+  owner.wakeup();
+}
+
+void TCPServer::adopt(Reactor &reactor, const ConnectionPtr &conn) {
+  SocketHandle socket = conn->socket;
+  conn->reactor = &reactor;
+  {
+    std::lock_guard<std::shared_mutex> lock(reactor.connectionsMutex);
+    reactor.connections[socket] = conn;
+  }
+  if (reactor.ring) {
+    reactor.ring->prepareReceive(socket, tag(socket, OP_RECEIVE));
+  } else if (!reactor.poller.add(socket)) {
+    std::lock_guard<std::shared_mutex> lock(reactor.connectionsMutex);
+    reactor.connections.erase(socket);
+    SocketAbstraction::closeSocket(socket);
+    return;
+  }
+  std::cout << "New client connected" << std::endl;
+  conn->lastInput = reactor.now;
+  conn->lastCommand = reactor.now;
+  checkLiveness(conn); // arms the first deadline
+  runInOrder(conn, [this, socket] {
+    if (handlers.onConnect)
+      handlers.onConnect(socket);
+  });
+}
+
+void TCPServer::readFrom(const ConnectionPtr &conn) {
+  char buffer[READ_CHUNK_SIZE];
+  while (!conn->closing) {
+    ++conn->reactor->syscalls;
+    int bytes =
+        SocketAbstraction::receiveData(conn->socket, buffer, sizeof(buffer));
+    if (bytes < 0 && SocketAbstraction::wouldBlock()) {
+      return; // drained until the next edge
+    }
+    if (bytes <= 0) {
+      beginDisconnect(conn);
+      return;
+    }
+    received(conn, buffer, bytes);
+  }
+}
+
+void TCPServer::received(const ConnectionPtr &conn, const char *data,
+                         size_t length) {
+  if (conn->input.overflowed()) {
+    return; // already shutting down
+  }
+  conn->lastInput = conn->reactor->now;
+  conn->input.append(data, length);
+  std::vector<QueuedCommand> commands;
+  std::string frame;
+  while (conn->input.next(frame)) {
+    unsigned version = 0;
+    if (conn->firstFrame && BinaryProtocol::parseUpgrade(frame, version)) {
+      // The rest of the input is binary from here; replies switch when a
+      // worker reaches this point, ahead of the commands that follow
+      conn->input.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+      SocketHandle socket = conn->socket;
+      runInOrder(conn, [this, socket, version] { upgrade(socket, version); });
+    } else if (conn->input.getMode() == FrameReader::Mode::LENGTH_PREFIXED) {
+      BinaryReader reader(frame);
+      BinaryProtocol::Type type;
+      QueuedCommand command;
+      if (!BinaryProtocol::readType(reader, type)) {
+        std::cerr << "Ignoring malformed binary message" << std::endl;
+      } else if (type == BinaryProtocol::Type::PONG) {
+        // Only proves the client is alive, which lastInput has recorded
+      } else if (type == BinaryProtocol::Type::COMMAND &&
+                 reader.readString(command.text) &&
+                 (reader.atEnd() || reader.readString(command.requestId))) {
+        if (!command.text.empty())
+          commands.push_back(std::move(command));
+      } else {
+        std::cerr << "Ignoring malformed binary message" << std::endl;
+      }
+    } else if (!frame.empty() && frame != Framing::PONG) {
+      QueuedCommand command;
+      splitRequestId(frame, command.requestId, MAX_REQUEST_ID);
+      command.text = std::move(frame);
+      commands.push_back(std::move(command));
+    }
+    conn->firstFrame = false;
+  }
+  if (conn->input.overflowed()) {
+    std::cerr << "Frame longer than " << FrameReader::MAX_FRAME_SIZE
+              << " bytes, closing connection" << std::endl;
+    SocketAbstraction::shutdownSocket(conn->socket); // reading sees the end
+  }
+  if (commands.empty()) {
+    return;
+  }
+  conn->lastCommand = conn->reactor->now;
+
+  std::vector<QueuedCommand> refused;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    size_t room = conn->queuedCommands < options.sessionQueueLimit
+                      ? options.sessionQueueLimit - conn->queuedCommands
+                      : 0;
+    if (commands.size() > room) {
+      refused.assign(std::make_move_iterator(commands.begin() + room),
+                     std::make_move_iterator(commands.end()));
+      commands.resize(room);
+    }
+    conn->queuedCommands += commands.size();
+  }
+
+  // Pipelined frames reach the worker as one task, in order. Admission is
+  // decided now, so a refused command costs the worker only its reply.
+  SocketHandle socket = conn->socket;
+  if (!commands.empty()) {
+    conn->reactor->commands += commands.size();
+    for (auto &command : commands) {
+      if (handlers.priority) {
+        command.priority = handlers.priority(command.text);
+      }
+      command.admitted = admission.tryAdmit(command.priority);
+    }
+    auto queuedAt = std::chrono::steady_clock::now();
+    runInOrder(conn, [this, conn, batch = std::move(commands), queuedAt] {
+      {
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        conn->queuedCommands -= batch.size();
+      }
+      runCommands(conn, batch, queuedAt);
+    });
+  }
+  if (!refused.empty()) {
+    // Answered after the commands ahead of them, like a reply would be.
+    // Tagged commands still get their one tagged reply each.
+    conn->reactor->refusedCommands += refused.size();
+    runInOrder(conn, [this, conn, socket, refused = std::move(refused)] {
+      size_t untagged = 0;
+      for (const auto &command : refused) {
+        if (command.requestId.empty()) {
+          ++untagged;
+        } else {
+          sendReply(conn, command.requestId,
+                    {"[ERROR] Too many commands queued; not run"});
+        }
+      }
+      if (untagged > 0) {
+        send(socket, "[ERROR] Too many commands queued; " +
+                         std::to_string(untagged) + " not run");
+      }
+    });
+  }
+}
+
+void TCPServer::runCommands(const ConnectionPtr &conn,
+                            const std::vector<QueuedCommand> &batch,
+                            std::chrono::steady_clock::time_point queuedAt) {
+  SocketHandle socket = conn->socket;
+  {
+    // Replies collect in the output queue and go out in one write at the
+    // end, instead of the reactor chasing each one
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->corked = true;
+  }
+  for (const auto &command : batch) {
+    ReplyCapture capture{socket, {}};
+    if (!command.requestId.empty()) {
+      replyCapture = &capture;
+    }
+    if (!command.admitted) {
+      send(socket, busyMessage());
+    } else {
+      if (admission.expired(queuedAt, command.priority)) {
+        send(socket, busyMessage());
+      } else if (handlers.onCommand) {
+        // Caught here so every admitted command gives its slot back
+        try {
+          handlers.onCommand(socket, command.text);
+        } catch (const std::exception &e) {
+          std::cerr << "Error handling client: " << e.what() << std::endl;
+        }
+      }
+      admission.release();
+    }
+    if (replyCapture != nullptr) {
+      replyCapture = nullptr;
+      sendReply(conn, command.requestId, capture.messages);
+    }
+  }
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->corked = false;
+    post = !conn->closing && conn->output.bytes() > 0 && markFlush(*conn);
+  }
+  if (post) {
+    requestFlush(conn);
+  }
+}
+
+void TCPServer::sendReply(const ConnectionPtr &conn,
+                          const std::string &requestId,
+                          const std::vector<std::string> &messages) {
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    if (conn->closing) {
+      return;
+    }
+    if (conn->protocol == Protocol::BINARY) {
+      appendBinary(*conn, BinaryProtocol::reply(requestId, messages));
+    } else {
+      // One line: the id, then the replies, or [OK] for a silent command
+      std::string reply = "@" + requestId + " ";
+      if (messages.empty()) {
+        reply += "[OK]";
+      }
+      for (size_t i = 0; i < messages.size(); ++i) {
+        reply += (i > 0 ? "\n" : "") + messages[i];
+      }
+      append(*conn, reply);
+    }
+    if (!markFlush(*conn)) {
+      return;
+    }
+  }
+  requestFlush(conn);
+}
+
+std::string TCPServer::busyMessage() const {
+  return "[BUSY] Server busy, retry after " +
+         std::to_string(admission.retryAfter()) + "s";
+}
+
+void TCPServer::checkLiveness(const ConnectionPtr &conn) {
+  conn->deadline = 0;
+  if (conn->closing) {
+    return;
+  }
+  Reactor &reactor = *conn->reactor;
+  auto next = std::chrono::steady_clock::time_point::max();
+  if (options.idleTimeout.count() > 0) {
+    next = conn->lastCommand + options.idleTimeout;
+    if (reactor.now >= next) {
+      closeIdle(conn);
+      return;
+    }
+  }
+  if (options.heartbeatInterval.count() > 0) {
+    if (conn->pingedAt > conn->lastInput) {
+      auto answerBy = conn->pingedAt + options.heartbeatTimeout;
+      if (reactor.now >= answerBy) {
+        std::cerr << "Closing client that did not answer a heartbeat"
+                  << std::endl;
+        ++reactor.deadConnections;
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        failWrites(*conn);
+        return;
+      }
+      next = std::min(next, answerBy);
+    } else if (reactor.now >= conn->lastInput + options.heartbeatInterval) {
+      {
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        if (conn->protocol == Protocol::BINARY) {
+          appendBinary(*conn, BinaryProtocol::ping());
+        } else {
+          append(*conn, Framing::PING);
+        }
+      }
+      flush(conn);
+      conn->pingedAt = reactor.now;
+      next = std::min(next, reactor.now + options.heartbeatTimeout);
+    } else {
+      next = std::min(next, conn->lastInput + options.heartbeatInterval);
+    }
+  }
+  // Input since the last check only moved the stamps; the deadline is
+  // recomputed from them here, once per interval rather than per read
+  if (next != std::chrono::steady_clock::time_point::max()) {
+    conn->deadline =
+        reactor.timers.schedule(next, [this, conn] { checkLiveness(conn); });
+  }
+}
+
+void TCPServer::closeIdle(const ConnectionPtr &conn) {
+  Reactor &reactor = *conn->reactor;
+  std::cout << "Disconnecting idle client" << std::endl;
+  ++reactor.idleConnections;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    append(*conn, "[SYSTEM] Disconnected after " +
+                      std::to_string(options.idleTimeout.count()) +
+                      "s without a command");
+    conn->closeWhenDrained = true;
+  }
+  flush(conn);
+  // Writing the notice shuts the socket down; a client that does not
+  // read it is cut off after the grace period
+  auto cutOff = [this, conn] {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    failWrites(*conn);
+  };
+  conn->deadline = reactor.timers.schedule(reactor.now + CLOSE_GRACE, cutOff);
+}
+
+void TCPServer::flush(const ConnectionPtr &conn) {
+  std::lock_guard<std::mutex> lock(conn->mutex);
+  conn->flushQueued = false;
+  if (conn->closing) {
+    return;
+  }
+  collectEvents(*conn);
+  if (conn->reactor->ring) {
+    startSend(*conn);
+    return;
+  }
+
+  while (!conn->writesFailed) {
+    if (conn->sending.empty()) {
+      refill(*conn);
+      if (conn->sending.empty()) {
+        break;
+      }
+    }
+    ++conn->reactor->syscalls;
+    size_t count = 0;
+    const IoSlice *slices = conn->sending.slices(count);
+    int bytes = SocketAbstraction::sendVector(conn->socket, slices, count);
+    if (bytes < 0 && SocketAbstraction::wouldBlock()) {
+      break; // the next writable edge resumes here
+    }
+    if (bytes <= 0) {
+      failWrites(*conn);
+      break;
+    }
+    conn->sending.consume(bytes);
+  }
+  conn->reactor->poller.setWriteInterest(
+      conn->socket, !conn->writesFailed && !conn->sending.empty());
+}
+
+void TCPServer::startSend(Connection &conn) {
+  // One send in flight per connection; what queues up meanwhile goes out
+  // as the next one
+  if (conn.sendInFlight || conn.writesFailed) {
+    return;
+  }
+  refill(conn);
+  if (conn.sending.empty()) {
+    return;
+  }
+  conn.sendInFlight = true;
+  prepareSend(conn);
+}
+
+void TCPServer::prepareSend(Connection &conn) {
+#ifndef _WIN32
+  size_t count = 0;
+  const IoSlice *slices = conn.sending.slices(count);
+  conn.sendMessage.msg_iov = reinterpret_cast<iovec *>(
+      const_cast<IoSlice *>(slices)); // IoSlice is laid out as iovec
+  conn.sendMessage.msg_iovlen = count;
+  conn.reactor->ring->prepareSendMessage(conn.socket, &conn.sendMessage,
+                                         tag(conn.socket, OP_SEND));
+#endif
+}
+
+void TCPServer::sendCompleted(const ConnectionPtr &conn, int result) {
+  bool finish = false;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    if (result > 0 && static_cast<size_t>(result) < conn->sending.bytes()) {
+      conn->sending.consume(result);
+      prepareSend(*conn);
+      return;
+    }
+    conn->sendInFlight = false;
+    conn->sending.clear();
+    if (result <= 0 && !conn->closing) {
+      // The multishot receive then ends and starts the disconnect
+      failWrites(*conn);
+    }
+    if (conn->closeAfterSend) {
+      finish = true;
+    } else if (!conn->closing) {
+      startSend(*conn);
+    }
+  }
+  if (finish) {
+    finishDisconnect(conn);
+  }
+}
+
+void TCPServer::collectEvents(Connection &conn) {
+  PubSubMessagePtr message;
+  bool binary = conn.protocol == Protocol::BINARY;
+  while (conn.subscription && conn.subscription->tryPop(message)) {
+    const std::string &encoded =
+        message->wire(binary ? Wire::BINARY : Wire::TEXT);
+    if (encoded.empty()) {
+      continue; // not shown to CLI clients
+    }
+    if (message->type == "private" && message->actorId == conn.userId) {
+      continue; // the sender already got "[PM sent to ...]"
+    }
+    queueFrame(conn, wireBuffer(message, binary ? Wire::BINARY : Wire::TEXT),
+               message->key);
+  }
+}
+
+void TCPServer::refill(Connection &conn) {
+  conn.output.take(conn.sending, WRITE_BATCH_SIZE, WriteBatch::MAX_FRAMES);
+  if (!conn.sending.empty()) {
+    return;
+  }
+  // Caught up: report what was lost to a full subscription or to the
+  // slow-consumer policy in one notice, rather than a stream of them that
+  // would crowd out the messages themselves
+  uint64_t dropped = conn.output.droppedCount() +
+                     (conn.subscription ? conn.subscription->droppedCount() : 0);
+  if (dropped != conn.reportedDrops) {
+    append(conn, "[SYSTEM] " + std::to_string(dropped - conn.reportedDrops) +
+                     " messages dropped");
+    conn.reportedDrops = dropped;
+    conn.output.take(conn.sending, WRITE_BATCH_SIZE, WriteBatch::MAX_FRAMES);
+  }
+  if (conn.sending.empty() && conn.closeWhenDrained) {
+    failWrites(conn);
+  }
+}
+
+void TCPServer::append(Connection &conn, const std::string &message) {
+  if (conn.protocol == Protocol::BINARY) {
+    appendBinary(conn, BinaryProtocol::text(message));
+    return;
+  }
+  auto frame = std::make_shared<std::string>();
+  Framing::encode(*frame, message);
+  queueFrame(conn, std::move(frame));
+}
+
+void TCPServer::appendBinary(Connection &conn, const std::string &message) {
+  auto frame = std::make_shared<std::string>();
+  Framing::encodeBinary(*frame, message);
+  queueFrame(conn, std::move(frame));
+}
+
+void TCPServer::queueFrame(Connection &conn, SharedFrame frame,
+                           const std::string &key) {
+  if (conn.writesFailed) {
+    return;
+  }
+  uint64_t dropped = conn.output.droppedCount();
+  uint64_t coalesced = conn.output.coalescedCount();
+  bool kept = conn.output.push(std::move(frame), key);
+  conn.reactor->droppedFrames += conn.output.droppedCount() - dropped;
+  conn.reactor->coalescedFrames += conn.output.coalescedCount() - coalesced;
+  if (!kept) {
+    std::cerr << "Disconnecting slow client: " << conn.output.bytes()
+              << " bytes queued" << std::endl;
+    ++conn.reactor->slowDisconnects;
+    failWrites(conn);
+  }
+}
+
+bool TCPServer::markFlush(Connection &conn) {
+  // A corked batch is written when it ends, unless its replies already
+  // fill a write
+  if (conn.flushQueued ||
+      (conn.corked && conn.output.bytes() < WRITE_BATCH_SIZE)) {
+    return false;
+  }
+  conn.flushQueued = true;
+  return true;
+}
+
+void TCPServer::failWrites(Connection &conn) {
+  conn.writesFailed = true;
+  conn.output.clear();
+  // Reading notices the shutdown and starts the disconnect
+  SocketAbstraction::shutdownSocket(conn.socket);
+}
+
+void TCPServer::beginDisconnect(const ConnectionPtr &conn) {
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    if (conn->closing) {
+      return;
+    }
+    conn->closing = true;
+    conn->output.clear();
+  }
+  Reactor &reactor = *conn->reactor;
+  if (!reactor.ring) {
+    reactor.poller.remove(conn->socket);
+  }
+  reactor.timers.cancel(conn->deadline);
+  conn->deadline = 0;
+
+  // The handle stays open until queued commands and onDisconnect have run,
+  // so it cannot be reused by a new connection while handlers still use it
+  SocketHandle socket = conn->socket;
+  runInOrder(conn, [this, socket, conn, &reactor] {
+    if (handlers.onDisconnect)
+      handlers.onDisconnect(socket);
+    {
+      std::lock_guard<std::mutex> lock(reactor.postedMutex);
+      reactor.posted.close.push_back(conn);
+    }
+    reactor.wakeup();
+  });
+}
+
+void TCPServer::finishDisconnect(const ConnectionPtr &conn) {
+  SubscriptionPtr subscription;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    if (conn->sendInFlight) {
+      // The kernel still reads conn->sending: fail the send, and close once
+      // it completes
+      conn->closeAfterSend = true;
+      SocketAbstraction::shutdownSocket(conn->socket);
+      return;
+    }
+    subscription = conn->subscription;
+  }
+  if (subscription) {
+    pubSub.unsubscribe(subscription);
+  }
+  {
+    Reactor &reactor = *conn->reactor;
+    std::lock_guard<std::shared_mutex> lock(reactor.connectionsMutex);
+    reactor.connections.erase(conn->socket);
+  }
+  SocketAbstraction::closeSocket(conn->socket);
+}
+
+void TCPServer::closeAll(Reactor &reactor) {
+  std::vector<ConnectionPtr> open;
+  {
+    std::lock_guard<std::shared_mutex> lock(reactor.connectionsMutex);
+    for (const auto &pair : reactor.connections) {
+      open.push_back(pair.second);
+    }
+    reactor.connections.clear();
+  }
+  for (const auto &conn : open) {
+    SubscriptionPtr subscription;
+    {
+      std::lock_guard<std::mutex> lock(conn->mutex);
+      conn->closing = true;
+      subscription = conn->subscription;
+    }
+    if (subscription) {
+      pubSub.unsubscribe(subscription);
+    }
+    reactor.timers.cancel(conn->deadline);
+    if (!reactor.ring) {
+      reactor.poller.remove(conn->socket);
+    }
+    SocketAbstraction::shutdownSocket(conn->socket);
+    SocketAbstraction::closeSocket(conn->socket);
+  }
+  if (reactor.ring) {
+    // Sends may still be in flight until the ring is closed
+    reactor.retired.insert(reactor.retired.end(), open.begin(), open.end());
+  }
+  {
+    std::lock_guard<std::mutex> lock(reactor.postedMutex);
+    for (const auto &conn : reactor.posted.adopt) {
+      SocketAbstraction::closeSocket(conn->socket); // never registered
+    }
+    reactor.posted.adopt.clear();
+  }
+  if (!reactor.ring) {
+    reactor.poller.remove(reactor.listenSocket);
+  }
+  SocketAbstraction::closeSocket(reactor.listenSocket);
+  reactor.listenSocket = INVALID_SOCKET_HANDLE;
+}
+
+void TCPServer::runInOrder(const ConnectionPtr &conn,
+                           std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->tasks.push_back(std::move(task));
+    if (conn->scheduled) {
+      return; // the worker already running this connection picks it up
+    }
+    conn->scheduled = true;
+  }
+  workers.submit([this, conn] { runTasks(conn); });
+}
+
+void TCPServer::runTasks(const ConnectionPtr &conn) {
+  for (size_t ran = 0; ran < SESSION_QUANTUM; ++ran) {
+    std::function<void()> task;
+    {
+      std::lock_guard<std::mutex> lock(conn->mutex);
+      if (conn->tasks.empty()) {
+        conn->scheduled = false;
+        return;
+      }
+      task = std::move(conn->tasks.front());
+      conn->tasks.pop_front();
+    }
+    try {
+      task();
+    } catch (const std::exception &e) {
+      std::cerr << "Error handling client: " << e.what() << std::endl;
+    }
+  }
+  // Still scheduled: requeue behind the other connections' work. Submitted
+  // from a worker, it lands on this worker's own queue.
+  workers.submit([this, conn] { runTasks(conn); });
+}
+
+void TCPServer::requestFlush(const ConnectionPtr &conn) {
+  Reactor &reactor = *conn->reactor;
+  {
+    std::lock_guard<std::mutex> lock(reactor.postedMutex);
+    reactor.posted.flush.push_back(conn);
+  }
+  reactor.wakeup();
+}
+
+TCPServer::ConnectionPtr TCPServer::find(SocketHandle socket) const {
+  // A handle is open in at most one reactor's table at a time
+  for (const auto &reactor : reactors) {
+    if (ConnectionPtr conn = find(*reactor, socket)) {
+      return conn;
+    }
+  }
+  return nullptr;
+}
+
+TCPServer::ConnectionPtr TCPServer::find(const Reactor &reactor,
+                                         SocketHandle socket) const {
+  std::shared_lock<std::shared_mutex> lock(reactor.connectionsMutex);
+  auto it = reactor.connections.find(socket);
+  return it != reactor.connections.end() ? it->second : nullptr;
+}
+
+bool TCPServer::send(SocketHandle socket, const std::string &message) {
+  return enqueue(socket, message, false);
+}
+
+bool TCPServer::sendBinary(SocketHandle socket, const std::string &message) {
+  return enqueue(socket, message, true);
+}
+
+bool TCPServer::enqueue(SocketHandle socket, const std::string &message,
+                        bool binary) {
+  ConnectionPtr conn = find(socket);
+  if (!conn) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    if (conn->closing) {
+      return false;
+    }
+    bool binaryClient = conn->protocol == Protocol::BINARY;
+    if (binary && !binaryClient) {
+      return false;
+    }
+    if (replyCapture != nullptr && replyCapture->socket == socket) {
+      // Part of a tagged command's answer; sent whole when it is done
+      replyCapture->messages.push_back(
+          binary || !binaryClient ? message : BinaryProtocol::text(message));
+      return true;
+    }
+    if (binary) {
+      appendBinary(*conn, message);
+    } else {
+      append(*conn, message);
+    }
+    if (!markFlush(*conn)) {
+      return true;
+    }
+  }
+  requestFlush(conn);
+  return true;
+}
+
+void TCPServer::upgrade(SocketHandle socket, unsigned version) {
+  ConnectionPtr conn = find(socket);
+  if (!conn) {
+    return;
+  }
+  {
+    // The reply is the last text frame; the client switches after it
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    append(*conn, BinaryProtocol::upgradeLine(version));
+    conn->protocol = Protocol::BINARY;
+    if (conn->closing || conn->flushQueued) {
+      return;
+    }
+    conn->flushQueued = true;
+  }
+  requestFlush(conn);
+}
+
+TCPServer::Protocol TCPServer::protocol(SocketHandle socket) const {
+  ConnectionPtr conn = find(socket);
+  if (!conn) {
+    return Protocol::TEXT;
+  }
+  std::lock_guard<std::mutex> lock(conn->mutex);
+  return conn->protocol;
+}
+
+void TCPServer::subscribe(SocketHandle socket, int userId,
+                          const std::vector<std::string> &topics) {
+  ConnectionPtr conn = find(socket);
+  if (!conn) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(conn->mutex);
+  conn->userId = userId;
+  if (conn->subscription) {
+    for (const auto &topic : topics) {
+      pubSub.addTopic(conn->subscription, topic);
+    }
+    return;
+  }
+
+  // Publishers only post the connection to the event loop, which formats
+  // and writes the events; the weak reference lets the connection go away
+  std::weak_ptr<Connection> weak = conn;
+  conn->subscription = pubSub.subscribe(
+      topics, PubSub::DEFAULT_QUEUE_CAPACITY, [this, weak] {
+        auto target = weak.lock();
+        if (!target) {
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> lock(target->mutex);
+          if (target->flushQueued || target->closing) {
+            return;
+          }
+          target->flushQueued = true;
+        }
+        requestFlush(target);
+      });
+}
+
+size_t TCPServer::connectionCount() const {
+  size_t count = 0;
+  for (const auto &reactor : reactors) {
+    std::shared_lock<std::shared_mutex> lock(reactor->connectionsMutex);
+    count += reactor->connections.size();
+  }
+  return count;
+}
+
+TCPServer::LoadStats TCPServer::loadStats() const {
+  LoadStats stats{admission.stats(), 0, 0, 0};
+  for (const auto &reactor : reactors) {
+    stats.rejectedConnections += reactor->rejectedConnections;
+    stats.deadConnections += reactor->deadConnections;
+    stats.idleConnections += reactor->idleConnections;
+  }
+  return stats;
+}
+
+TCPServer::QueueStats TCPServer::queueStats() const {
+  QueueStats stats{0, 0, 0, 0, 0};
+  for (const auto &reactor : reactors) {
+    stats.dropped += reactor->droppedFrames;
+    stats.coalesced += reactor->coalescedFrames;
+    stats.slowDisconnects += reactor->slowDisconnects;
+    std::shared_lock<std::shared_mutex> lock(reactor->connectionsMutex);
+    for (const auto &pair : reactor->connections) {
+      std::lock_guard<std::mutex> connLock(pair.second->mutex);
+      const Connection &conn = *pair.second;
+      uint64_t bytes = conn.output.bytes() + conn.sending.bytes();
+      stats.queuedBytes += bytes;
+      stats.deepestQueue = std::max(stats.deepestQueue, bytes);
+    }
+  }
+  return stats;
+}
+
+TCPServer::IoStats TCPServer::ioStats() const {
+  IoStats stats{0, 0, 0};
+  for (const auto &reactor : reactors) {
+    stats.commands += reactor->commands;
+    stats.refused += reactor->refusedCommands;
+    stats.syscalls += reactor->syscalls + reactor->poller.syscalls() +
+                      (reactor->ring ? reactor->ring->syscalls() : 0);
+  }
+  return stats;
+}
@@ -73,6 +73,25 @@ std::string Task::getPriorityString() const {
     }
 }
 
+bool Task::parseStatus(const std::string& name, TaskStatus& status) {
+    if (name == "TODO") status = TaskStatus::TODO;
+    else if (name == "IN_PROGRESS" || name == "PROGRESS") status = TaskStatus::IN_PROGRESS;
+    else if (name == "IN_REVIEW" || name == "REVIEW") status = TaskStatus::IN_REVIEW;
+    else if (name == "DONE") status = TaskStatus::DONE;
+    else if (name == "BLOCKED") status = TaskStatus::BLOCKED;
+    else return false;
+    return true;
+}
+
+bool Task::parsePriority(const std::string& name, TaskPriority& priority) {
+    if (name == "LOW") priority = TaskPriority::LOW;
+    else if (name == "MEDIUM") priority = TaskPriority::MEDIUM;
+    else if (name == "HIGH") priority = TaskPriority::HIGH;
+    else if (name == "CRITICAL") priority = TaskPriority::CRITICAL;
+    else return false;
+    return true;
+}
+
 std::string Task::toString() const {
     std::ostringstream oss;
     oss << "[" << projectKey << "-" << taskId << "] " << title
@@ -4,12 +4,13 @@
 #include <fstream>
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 #include <climits>
 #include <sstream>
 #include <iomanip>
 
-TaskManager::TaskManager() : nextTaskId(1) {
+TaskManager::TaskManager() : nextTaskId(1), changeSeq(0) {
     loadFromFile();
 }
 
@@ -19,7 +20,7 @@ int TaskManager::createTask(const std::string& title, const std::string& descrip
 
 int TaskManager::createTask(const std::string& title, const std::string& description, int reporterId, const std::string& projectKey, int deadlineDays) {
     try {
-        std::lock_guard<std::mutex> lock(taskMutex);
+        std::lock_guard<std::shared_mutex> lock(taskMutex);
         
         if (title.empty()) {
             throw std::invalid_argument("Task title cannot be empty");
@@ -31,6 +32,7 @@ int TaskManager::createTask(const std::string& title, const std::string& descrip
         
         int taskId = nextTaskId;
         nextTaskId++;
+        recordChange(taskId, TaskChange::CREATED);
         
         saveToFile();
         return taskId;
@@ -42,11 +44,12 @@ int TaskManager::createTask(const std::string& title, const std::string& descrip
 
 bool TaskManager::updateTaskStatus(int taskId, TaskStatus status, int userId) {
     try {
-        std::lock_guard<std::mutex> lock(taskMutex);
+        std::lock_guard<std::shared_mutex> lock(taskMutex);
         
         Task* task = getTaskById(taskId);
         if (task) {
             task->setStatus(status);
+            recordChange(taskId, TaskChange::STATUS);
             saveToFile();
             return true;
         }
@@ -58,11 +61,12 @@ bool TaskManager::updateTaskStatus(int taskId, TaskStatus status, int userId) {
 }
 
 bool TaskManager::updateTaskPriority(int taskId, TaskPriority priority, int userId) {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
     
     Task* task = getTaskById(taskId);
     if (task) {
         task->setPriority(priority);
+        recordChange(taskId, TaskChange::PRIORITY);
         saveToFile();
         return true;
     }
@@ -71,11 +75,12 @@ bool TaskManager::updateTaskPriority(int taskId, TaskPriority priority, int user
 
 bool TaskManager::assignTask(int taskId, int assigneeId, int userId) {
     try {
-        std::lock_guard<std::mutex> lock(taskMutex);
+        std::lock_guard<std::shared_mutex> lock(taskMutex);
         
         Task* task = getTaskById(taskId);
         if (task) {
             task->setAssignee(assigneeId);
+            recordChange(taskId, TaskChange::ASSIGNED);
             saveToFile();
             return true;
         }
@@ -87,25 +92,193 @@ bool TaskManager::assignTask(int taskId, int assigneeId, int userId) {
 }
 
 bool TaskManager::addTaskComment(int taskId, const std::string& comment, int userId) {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
     
     Task* task = getTaskById(taskId);
     if (task) {
         task->addComment(comment);
+        recordChange(taskId, TaskChange::COMMENTED);
         saveToFile();
         return true;
     }
     return false;
 }
 
+std::vector<Task> TaskManager::createTasks(const std::vector<NewTask>& newTasks, int reporterId) {
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
+    std::vector<Task> created;
+    created.reserve(newTasks.size());
+    tasks.reserve(tasks.size() + newTasks.size());
+    
+    for (const auto& newTask : newTasks) {
+        if (newTask.title.empty()) {
+            continue;
+        }
+        tasks.emplace_back(nextTaskId, newTask.title, newTask.description, reporterId,
+                           newTask.projectKey, newTask.deadlineDays);
+        projectTasks[newTask.projectKey].push_back(nextTaskId);
+        recordChange(nextTaskId, TaskChange::CREATED, false);
+        created.push_back(tasks.back());
+        nextTaskId++;
+    }
+    finishBatch(created, TaskChange::CREATED);
+    return created;
+}
+
+std::vector<Task> TaskManager::updateTasksStatus(const std::vector<int>& taskIds, TaskStatus status, int /*userId*/) {
+    return updateTasks(taskIds, TaskChange::STATUS, [status](Task& task) { task.setStatus(status); });
+}
+
+std::vector<Task> TaskManager::updateTasksPriority(const std::vector<int>& taskIds, TaskPriority priority, int /*userId*/) {
+    return updateTasks(taskIds, TaskChange::PRIORITY, [priority](Task& task) { task.setPriority(priority); });
+}
+
+std::vector<Task> TaskManager::assignTasks(const std::vector<int>& taskIds, int assigneeId, int /*userId*/) {
+    return updateTasks(taskIds, TaskChange::ASSIGNED, [assigneeId](Task& task) { task.setAssignee(assigneeId); });
+}
+
+std::vector<TaskOperationResult> TaskManager::applyOperations(const std::vector<TaskOperation>& operations,
+                                                          int userId, bool atomic) {
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
+    std::vector<TaskOperationResult> results(operations.size());
+    // Operations work on copies, so a failed atomic batch is simply dropped
+    std::map<int, Task> staged;
+    std::vector<std::pair<int, TaskChange>> changes;
+    int nextId = nextTaskId;
+    
+    for (size_t i = 0; i < operations.size(); ++i) {
+        const TaskOperation& op = operations[i];
+        TaskOperationResult& result = results[i];
+        if (op.kind == TaskOperation::Kind::CREATE) {
+            if (op.newTask.title.empty()) {
+                result.error = "Task title cannot be empty";
+            } else {
+                result.task = Task(nextId, op.newTask.title, op.newTask.description, userId,
+                                   op.newTask.projectKey, op.newTask.deadlineDays);
+                staged[nextId] = result.task;
+                changes.emplace_back(nextId, TaskChange::CREATED);
+                nextId++;
+                result.ok = true;
+            }
+        } else {
+            int taskId = op.taskId;
+            if (op.taskRef >= 0) {
+                size_t ref = static_cast<size_t>(op.taskRef);
+                bool created = ref < i && operations[ref].kind == TaskOperation::Kind::CREATE &&
+                               results[ref].ok;
+                taskId = created ? results[ref].task.getTaskId() : -1;
+            }
+            Task* task = nullptr;
+            auto it = staged.find(taskId);
+            if (it != staged.end()) {
+                task = &it->second;
+            } else if (const Task* current = getTaskById(taskId)) {
+                task = &(staged[taskId] = *current);
+            }
+            
+            if (!task) {
+                result.error = "Task not found";
+            } else {
+                TaskChange change = TaskChange::STATUS;
+                switch (op.kind) {
+                case TaskOperation::Kind::SET_STATUS:
+                    task->setStatus(op.status);
+                    break;
+                case TaskOperation::Kind::SET_PRIORITY:
+                    task->setPriority(op.priority);
+                    change = TaskChange::PRIORITY;
+                    break;
+                case TaskOperation::Kind::ASSIGN:
+                    task->setAssignee(op.assigneeId);
+                    change = TaskChange::ASSIGNED;
+                    break;
+                case TaskOperation::Kind::COMMENT:
+                    task->addComment(op.comment);
+                    change = TaskChange::COMMENTED;
+                    break;
+                case TaskOperation::Kind::CREATE:
+                    break;
+                }
+                changes.emplace_back(taskId, change);
+                result.task = *task;
+                result.ok = true;
+            }
+        }
+        
+        if (!result.ok && atomic) {
+            for (size_t j = 0; j < results.size(); ++j) {
+                if (j != i) {
+                    results[j] = TaskOperationResult();
+                    results[j].error = "Not applied";
+                }
+            }
+            return results;
+        }
+    }
+    
+    // Commit in ID order: changed tasks, then the new ones, which sort last
+    for (auto& entry : staged) {
+        if (entry.first >= nextTaskId) {
+            tasks.push_back(entry.second);
+            projectTasks[entry.second.getProjectKey()].push_back(entry.first);
+        } else {
+            *getTaskById(entry.first) = entry.second;
+        }
+    }
+    nextTaskId = nextId;
+    for (const auto& change : changes) {
+        recordChange(change.first, change.second);
+    }
+    if (!changes.empty()) {
+        saveToFile();
+    }
+    return results;
+}
+
+std::vector<Task> TaskManager::updateTasks(const std::vector<int>& taskIds, TaskChange change,
+                                           const std::function<void(Task&)>& update) {
+    std::vector<int> ids = taskIds;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
+    std::vector<Task> changed;
+    changed.reserve(ids.size());
+    for (int taskId : ids) {
+        Task* task = getTaskById(taskId);
+        if (task) {
+            update(*task);
+            recordChange(taskId, change, false);
+            changed.push_back(*task);
+        }
+    }
+    finishBatch(changed, change);
+    return changed;
+}
+
+void TaskManager::finishBatch(const std::vector<Task>& changed, TaskChange change) {
+    if (changed.empty()) {
+        return;
+    }
+    taskChanged.notify_all();
+    if (batchListener) {
+        batchListener(changed, change);
+    } else if (changeListener) {
+        for (const auto& task : changed) {
+            changeListener(task, change);
+        }
+    }
+    saveToFile();
+}
+
 std::vector<Task> TaskManager::getAllTasks() const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     return tasks;
 }
 
 // SMART ASSIGNMENT: Recommend best assignee based on workload
 int TaskManager::recommendBestAssignee(const std::map<std::string, User>& users) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     
     int bestUserId = -1;
     int minWorkload = INT_MAX;
@@ -114,7 +287,7 @@ int TaskManager::recommendBestAssignee(const std::map<std::string, User>& users)
         const User& user = userPair.second;
         // FIX: Only consider developers for task assignment (not PMs)
         if (user.getRole() == UserRole::DEVELOPER) {
-            int workload = getActiveTaskCount(user.getUserId());
+            int workload = countActiveTasks(user.getUserId());
             if (workload < minWorkload) {
                 minWorkload = workload;
                 bestUserId = user.getUserId();
@@ -125,6 +298,11 @@ int TaskManager::recommendBestAssignee(const std::map<std::string, User>& users)
 }
 
 int TaskManager::getActiveTaskCount(int userId) const {
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
+    return countActiveTasks(userId);
+}
+
+int TaskManager::countActiveTasks(int userId) const {
     int count = 0;
     for (const auto& task : tasks) {
         if (task.getAssigneeId() == userId && 
@@ -136,7 +314,7 @@ int TaskManager::getActiveTaskCount(int userId) const {
 }
 
 std::vector<Task> TaskManager::getOverdueTasks() const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result;
     
     for (const auto& task : tasks) {
@@ -148,7 +326,7 @@ std::vector<Task> TaskManager::getOverdueTasks() const {
 }
 
 std::vector<Task> TaskManager::getDueSoonTasks(int days) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result;
     
     for (const auto& task : tasks) {
@@ -162,7 +340,7 @@ std::vector<Task> TaskManager::getDueSoonTasks(int days) const {
 
 // DASHBOARD: Generate comprehensive dashboard
 std::string TaskManager::generateDashboard(const std::map<std::string, User>& users) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::ostringstream dashboard;
     
     dashboard << "\n=== PROJECT DASHBOARD ===\n";
@@ -224,7 +402,7 @@ std::string TaskManager::generateDashboard(const std::map<std::string, User>& us
 }
 
 std::vector<Task> TaskManager::getTasksByProject(const std::string& projectKey) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result;
     
     for (const auto& task : tasks) {
@@ -236,7 +414,7 @@ std::vector<Task> TaskManager::getTasksByProject(const std::string& projectKey)
 }
 
 std::vector<Task> TaskManager::getTasksByDeadlineStatus(const std::string& status) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result;
     
     for (const auto& task : tasks) {
@@ -252,7 +430,7 @@ std::vector<Task> TaskManager::getTasksByDeadlineStatus(const std::string& statu
 }
 
 std::vector<Task> TaskManager::getTasksByAssignee(int userId) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result;
     
     for (const auto& task : tasks) {
@@ -264,7 +442,7 @@ std::vector<Task> TaskManager::getTasksByAssignee(int userId) const {
 }
 
 std::vector<Task> TaskManager::getTasksByStatus(TaskStatus status) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result;
     
     for (const auto& task : tasks) {
@@ -275,17 +453,88 @@ std::vector<Task> TaskManager::getTasksByStatus(TaskStatus status) const {
     return result;
 }
 
+bool TaskManager::getTask(int taskId, Task& out) const {
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
+    const Task* task = getTaskById(taskId);
+    if (task) {
+        out = *task;
+        return true;
+    }
+    return false;
+}
+
+const Task* TaskManager::getTaskById(int taskId) const {
+    // Tasks are appended with increasing IDs, so the vector is sorted by ID
+    auto it = std::lower_bound(tasks.begin(), tasks.end(), taskId,
+                               [](const Task& task, int id) { return task.getTaskId() < id; });
+    if (it != tasks.end() && it->getTaskId() == taskId) {
+        return &*it;
+    }
+    return nullptr;
+}
+
 Task* TaskManager::getTaskById(int taskId) {
-    for (auto& task : tasks) {
-        if (task.getTaskId() == taskId) {
-            return &task;
+    return const_cast<Task*>(static_cast<const TaskManager*>(this)->getTaskById(taskId));
+}
+
+void TaskManager::recordChange(int taskId, TaskChange change, bool notify) {
+    changeSeq++;
+    auto it = taskVersions.find(taskId);
+    if (it != taskVersions.end()) {
+        changeIndex.erase(it->second);
+    }
+    taskVersions[taskId] = changeSeq;
+    changeIndex[changeSeq] = taskId;
+    if (!notify) {
+        return;
+    }
+    taskChanged.notify_all();
+    if (changeListener) {
+        const Task* task = getTaskById(taskId);
+        if (task) {
+            changeListener(*task, change);
         }
     }
-    return nullptr;
+}
+
+void TaskManager::setChangeListener(std::function<void(const Task&, TaskChange)> listener) {
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
+    changeListener = std::move(listener);
+}
+
+void TaskManager::setBatchChangeListener(std::function<void(const std::vector<Task>&, TaskChange)> listener) {
+    std::lock_guard<std::shared_mutex> lock(taskMutex);
+    batchListener = std::move(listener);
+}
+
+std::vector<Task> TaskManager::getTasksChangedSince(uint64_t since, uint64_t& version) const {
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
+    std::vector<Task> result;
+    
+    for (auto it = changeIndex.upper_bound(since); it != changeIndex.end(); ++it) {
+        const Task* task = getTaskById(it->second);
+        if (task) {
+            result.push_back(*task);
+        }
+    }
+    version = changeSeq;
+    return result;
+}
+
+uint64_t TaskManager::getVersion() const {
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
+    return changeSeq;
+}
+
+bool TaskManager::waitForChange(uint64_t since, std::chrono::steady_clock::time_point deadline) const {
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
+    return taskChanged.wait_until(lock, deadline, [this, since]() {
+        return changeSeq > since;
+    });
 }
 
 std::map<TaskStatus, int> TaskManager::getTaskStatusCount() const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::map<TaskStatus, int> counts;
     
     for (const auto& task : tasks) {
@@ -295,7 +544,7 @@ std::map<TaskStatus, int> TaskManager::getTaskStatusCount() const {
 }
 
 std::vector<Task> TaskManager::getRecentTasks(int limit) const {
-    std::lock_guard<std::mutex> lock(taskMutex);
+    std::shared_lock<std::shared_mutex> lock(taskMutex);
     std::vector<Task> result = tasks;
     
     if (result.size() > static_cast<size_t>(limit)) {
@@ -362,6 +611,7 @@ void TaskManager::loadFromFile() {
                         
                         tasks.push_back(task);
                         projectTasks[parts[7]].push_back(std::stoi(parts[0]));
+                        recordChange(task.getTaskId(), TaskChange::LOADED);
                     } catch (const std::exception& e) {
                         std::cerr << "Error parsing task line: " << line << std::endl;
                     }
@@ -0,0 +1,184 @@
+#include "../include/TimingWheel.hpp"
+#include <algorithm>
+
+TimingWheel::TimingWheel(Clock::duration t, Clock::time_point s)
+    : start(s), tick(std::max(t, Clock::duration(1))) {
+  heads.fill(NIL);
+  occupied.fill(0);
+}
+
+TimingWheel::TimerId TimingWheel::schedule(Clock::time_point deadline,
+                                           std::function<void()> callback) {
+  // Round up, so the timer never fires before its deadline
+  uint64_t expiry = 0;
+  if (deadline > start) {
+    auto ticks = (deadline - start + tick - Clock::duration(1)) / tick;
+    expiry = static_cast<uint64_t>(ticks);
+  }
+  expiry = std::max(expiry, elapsed + 1);
+
+  uint32_t index = freeNodes;
+  if (index != NIL) {
+    freeNodes = nodes[index].next;
+  } else {
+    index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+  }
+  Node &node = nodes[index];
+  node.callback = std::move(callback);
+  node.expiry = expiry;
+  place(index);
+  ++count;
+  return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimingWheel::cancel(TimerId id) {
+  auto index = static_cast<uint32_t>(id);
+  auto generation = static_cast<uint32_t>(id >> 32);
+  if (index >= nodes.size() || nodes[index].generation != generation ||
+      nodes[index].slot == UNUSED) {
+    return false;
+  }
+  unlink(index);
+  release(index);
+  return true;
+}
+
+size_t TimingWheel::advance(Clock::time_point now) {
+  uint64_t target =
+      now > start ? static_cast<uint64_t>((now - start) / tick) : 0;
+  size_t fired = 0;
+  while (elapsed < target) {
+    if (count == 0) {
+      elapsed = target;
+      break;
+    }
+    if (levelEmpty(0)) {
+      // Nothing can fire before the next cascade: skip to just before it
+      uint64_t boundary = elapsed | MASK;
+      if (boundary >= target) {
+        elapsed = target;
+        break;
+      }
+      elapsed = boundary;
+    }
+    ++elapsed;
+    if ((elapsed & MASK) == 0) {
+      // Level 0 wrapped: bring the next turn's timers down, and so on up
+      for (size_t level = 1; level < LEVELS; ++level) {
+        cascade(level);
+        if (((elapsed >> (SLOT_BITS * level)) & MASK) != 0) {
+          break;
+        }
+      }
+    }
+    // One at a time, since a callback may cancel the others
+    size_t slot = elapsed & MASK;
+    while (heads[slot] != NIL) {
+      uint32_t index = heads[slot];
+      unlink(index);
+      auto callback = std::move(nodes[index].callback);
+      release(index);
+      ++fired;
+      callback();
+    }
+  }
+  return fired;
+}
+
+TimingWheel::Clock::duration
+TimingWheel::timeUntilNext(Clock::time_point now) const {
+  if (count == 0) {
+    return Clock::duration::max();
+  }
+  // The first occupied level-0 slot, unless the next cascade comes first
+  // and may bring nearer timers down
+  uint64_t ticks = SLOTS - (elapsed & MASK);
+  for (uint64_t ahead = 1; ahead < ticks; ++ahead) {
+    size_t slot = (elapsed + ahead) & MASK;
+    uint64_t word = occupied[slot / 64] >> (slot % 64);
+    if (word == 0) {
+      ahead += 63 - slot % 64; // rest of this word is empty
+      continue;
+    }
+    if (word & 1) {
+      ticks = ahead;
+      break;
+    }
+  }
+  auto deadline = start + tick * static_cast<Clock::rep>(elapsed + ticks);
+  return deadline > now ? deadline - now : Clock::duration::zero();
+}
+
+void TimingWheel::place(uint32_t index) {
+  Node &node = nodes[index];
+  uint64_t delta = node.expiry - std::min(node.expiry, elapsed);
+  size_t level = 0;
+  while (level + 1 < LEVELS && delta >> (SLOT_BITS * (level + 1)) != 0) {
+    ++level;
+  }
+  // Beyond the top level's reach: park at its far end and cascade back up
+  uint64_t when = node.expiry;
+  uint64_t reach = uint64_t(1) << (SLOT_BITS * LEVELS);
+  if (delta >= reach) {
+    when = elapsed + reach - 1;
+  }
+  size_t slot = level * SLOTS + ((when >> (SLOT_BITS * level)) & MASK);
+
+  node.slot = static_cast<uint16_t>(slot);
+  node.prev = NIL;
+  node.next = heads[slot];
+  if (node.next != NIL) {
+    nodes[node.next].prev = index;
+  }
+  heads[slot] = index;
+  occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+}
+
+void TimingWheel::unlink(uint32_t index) {
+  Node &node = nodes[index];
+  if (node.prev != NIL) {
+    nodes[node.prev].next = node.next;
+  } else {
+    heads[node.slot] = node.next;
+    if (node.next == NIL) {
+      occupied[node.slot / 64] &= ~(uint64_t(1) << (node.slot % 64));
+    }
+  }
+  if (node.next != NIL) {
+    nodes[node.next].prev = node.prev;
+  }
+  node.slot = UNUSED;
+}
+
+void TimingWheel::release(uint32_t index) {
+  Node &node = nodes[index];
+  node.callback = nullptr;
+  if (++node.generation == 0) {
+    node.generation = 1; // keeps every TimerId non-zero
+  }
+  node.next = freeNodes;
+  freeNodes = index;
+  --count;
+}
+
+void TimingWheel::cascade(size_t level) {
+  size_t slot = level * SLOTS + ((elapsed >> (SLOT_BITS * level)) & MASK);
+  uint32_t index = heads[slot];
+  heads[slot] = NIL;
+  occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+  while (index != NIL) {
+    uint32_t next = nodes[index].next;
+    place(index); // now within reach of a lower level
+    index = next;
+  }
+}
+
+bool TimingWheel::levelEmpty(size_t level) const {
+  for (size_t word = 0; word < SLOTS / 64; ++word) {
+    if (occupied[level * SLOTS / 64 + word] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
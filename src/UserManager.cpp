@@ -0,0 +1,84 @@
+#include "../include/UserManager.hpp"
+#include <mutex>
+
+bool UserManager::addUser(const std::string &username, const User &user) {
+  std::lock_guard<std::shared_mutex> lock(userMutex);
+  return users.insert({username, user}).second;
+}
+
+bool UserManager::hasUser(const std::string &username) const {
+  std::shared_lock<std::shared_mutex> lock(userMutex);
+  return users.find(username) != users.end();
+}
+
+bool UserManager::getUser(const std::string &username, User &out) const {
+  std::shared_lock<std::shared_mutex> lock(userMutex);
+  auto it = users.find(username);
+  if (it == users.end()) {
+    return false;
+  }
+  out = it->second;
+  return true;
+}
+
+int UserManager::getUserId(const std::string &username) const {
+  std::shared_lock<std::shared_mutex> lock(userMutex);
+  auto it = users.find(username);
+  return (it != users.end()) ? it->second.getUserId() : -1;
+}
+
+std::string UserManager::getUsernameById(int userId) const {
+  std::shared_lock<std::shared_mutex> lock(userMutex);
+  for (const auto &pair : users) {
+    if (pair.second.getUserId() == userId) {
+      return pair.first;
+    }
+  }
+  return "";
+}
+
+std::map<std::string, User> UserManager::getAllUsers() const {
+  std::shared_lock<std::shared_mutex> lock(userMutex);
+  return users;
+}
+
+std::vector<std::string> UserManager::getOnlineUsernames() const {
+  std::shared_lock<std::shared_mutex> lock(userMutex);
+  std::vector<std::string> result;
+  for (const auto &pair : users) {
+    if (pair.second.getOnlineStatus()) {
+      result.push_back(pair.first);
+    }
+  }
+  return result;
+}
+
+bool UserManager::setOnlineStatus(const std::string &username, bool online) {
+  std::lock_guard<std::shared_mutex> lock(userMutex);
+  auto it = users.find(username);
+  if (it == users.end()) {
+    return false;
+  }
+  bool changed = it->second.getOnlineStatus() != online;
+  it->second.setOnlineStatus(online);
+  if (changed && presenceListener) {
+    presenceListener(username, it->second);
+  }
+  return true;
+}
+
+bool UserManager::setSocketId(const std::string &username, int socketId) {
+  std::lock_guard<std::shared_mutex> lock(userMutex);
+  auto it = users.find(username);
+  if (it == users.end()) {
+    return false;
+  }
+  it->second.setSocketId(socketId);
+  return true;
+}
+
+void UserManager::setPresenceListener(
+    std::function<void(const std::string &, const User &)> listener) {
+  std::lock_guard<std::shared_mutex> lock(userMutex);
+  presenceListener = std::move(listener);
+}
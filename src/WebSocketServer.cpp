@@ -0,0 +1,526 @@
+#include "../include/WebSocketServer.hpp"
+#include "../include/JsonReader.hpp"
+#include "../include/NetworkUtils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace {
+const char *HANDSHAKE_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+const size_t MAX_HANDSHAKE_SIZE = 8192;
+
+// Frame opcodes (RFC 6455 section 5.2)
+const uint8_t OP_CONTINUATION = 0x0;
+const uint8_t OP_TEXT = 0x1;
+const uint8_t OP_BINARY = 0x2;
+const uint8_t OP_CLOSE = 0x8;
+const uint8_t OP_PING = 0x9;
+const uint8_t OP_PONG = 0xA;
+
+// Close status codes
+const uint16_t CLOSE_GOING_AWAY = 1001;
+const uint16_t CLOSE_PROTOCOL_ERROR = 1002;
+const uint16_t CLOSE_UNSUPPORTED = 1003;
+const uint16_t CLOSE_POLICY = 1008;
+const uint16_t CLOSE_TOO_BIG = 1009;
+
+std::string httpError(const std::string &status) {
+  return "HTTP/1.1 " + status +
+         "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+}
+
+std::string toLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return value;
+}
+
+std::string closePayload(uint16_t code, const std::string &reason) {
+  std::string payload;
+  payload += static_cast<char>(code >> 8);
+  payload += static_cast<char>(code & 0xFF);
+  return payload + reason;
+}
+} // namespace
+
+WebSocketServer::WebSocketServer(ChatManager &cm, UserManager &um, PubSub &ps,
+                                 EventBus &bus, Authenticator auth)
+    : chatManager(cm), userManager(um), pubSub(ps), eventBus(bus),
+      authenticate(std::move(auth)), listenSocket(INVALID_SOCKET_HANDLE),
+      running(false), openConnections(0) {
+  eventBus.setEncoder(Wire::WEBSOCKET, [](const PubSubMessage &message) {
+    return *textFrame(message.type, message.data);
+  });
+}
+
+WebSocketServer::~WebSocketServer() {
+  stop();
+  eventBus.setEncoder(Wire::WEBSOCKET, nullptr);
+}
+
+bool WebSocketServer::start(int port) {
+  listenSocket = SocketAbstraction::createSocket();
+  if (!SocketAbstraction::isValidSocket(listenSocket)) {
+    return false;
+  }
+  if (!SocketAbstraction::setReuseAddress(listenSocket) ||
+      !SocketAbstraction::bindSocket(listenSocket, port) ||
+      !SocketAbstraction::listenSocket(listenSocket, 512) ||
+      !SocketAbstraction::setNonBlocking(listenSocket) ||
+      !loop.start("WebSocket")) {
+    std::cerr << "ERROR: WebSocket server failed to listen on port " << port
+              << std::endl;
+    SocketAbstraction::closeSocket(listenSocket);
+    listenSocket = INVALID_SOCKET_HANDLE;
+    return false;
+  }
+
+  running = true;
+  loop.post([this] {
+    if (!loop.watch(listenSocket, [this](bool readable, bool) {
+          if (readable) {
+            acceptConnections();
+          }
+        })) {
+      std::cerr << "ERROR: WebSocket server cannot watch its listen socket"
+                << std::endl;
+    }
+  });
+  std::cout << "WebSocket server running on port " << port << "..."
+            << std::endl;
+  return true;
+}
+
+void WebSocketServer::stop() {
+  if (!running.exchange(false)) {
+    return;
+  }
+  loop.post([this] { closeAll(); });
+  loop.stop();
+}
+
+void WebSocketServer::acceptConnections() {
+  // Edge-triggered: take every pending connection now
+  while (true) {
+    SocketHandle socket = SocketAbstraction::acceptSocket(listenSocket);
+    if (!SocketAbstraction::isValidSocket(socket)) {
+      return;
+    }
+    SocketAbstraction::setNonBlocking(socket);
+    SocketAbstraction::setNoDelay(socket);
+
+    auto conn = std::make_shared<Connection>();
+    conn->socket = socket;
+    if (!loop.watch(socket, [this, conn](bool readable, bool writable) {
+          if (readable) {
+            readFrom(conn);
+          }
+          if (writable) {
+            flush(conn);
+          }
+        })) {
+      SocketAbstraction::closeSocket(socket);
+      continue;
+    }
+    connections.insert(conn);
+    conn->timer = loop.timers().schedule(loop.now() + HANDSHAKE_TIMEOUT,
+                                         [this, conn] {
+                                           conn->timer = 0;
+                                           drop(conn);
+                                         });
+  }
+}
+
+void WebSocketServer::readFrom(const ConnectionPtr &conn) {
+  char chunk[4096];
+  // Edge-triggered: read until the socket is empty
+  while (conn->socket != INVALID_SOCKET_HANDLE) {
+    int n = SocketAbstraction::receiveData(conn->socket, chunk, sizeof(chunk));
+    if (n < 0 && SocketAbstraction::wouldBlock()) {
+      break;
+    }
+    if (n <= 0) {
+      drop(conn);
+      return;
+    }
+    if (conn->closing) {
+      continue; // nothing is read after a close frame or a refusal
+    }
+    conn->input.append(chunk, n);
+    if (conn->open || performHandshake(conn)) {
+      parseFrames(conn);
+    }
+  }
+  // Replies to everything just read go out together
+  flush(conn);
+}
+
+bool WebSocketServer::performHandshake(const ConnectionPtr &conn) {
+  size_t headerEnd = conn->input.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) {
+    if (conn->input.size() > MAX_HANDSHAKE_SIZE) {
+      refuse(conn, "431 Request Header Fields Too Large");
+    }
+    return false;
+  }
+  std::string request = conn->input.substr(0, headerEnd);
+  conn->input.erase(0, headerEnd + 4); // frames sent right behind it
+
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start <= request.size()) {
+    size_t end = request.find("\r\n", start);
+    if (end == std::string::npos)
+      end = request.size();
+    lines.push_back(request.substr(start, end - start));
+    start = end + 2;
+  }
+
+  // Request line: GET /?token=... HTTP/1.1
+  std::vector<std::string> requestLine = NetworkUtils::splitString(lines[0], ' ');
+  if (requestLine.size() < 3 || requestLine[0] != "GET") {
+    refuse(conn, "405 Method Not Allowed");
+    return false;
+  }
+
+  std::map<std::string, std::string> headers;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    size_t colon = lines[i].find(':');
+    if (colon != std::string::npos) {
+      headers[toLower(NetworkUtils::trim(lines[i].substr(0, colon)))] =
+          NetworkUtils::trim(lines[i].substr(colon + 1));
+    }
+  }
+
+  const std::string &key = headers["sec-websocket-key"];
+  if (toLower(headers["upgrade"]) != "websocket" || key.empty()) {
+    refuse(conn, "400 Bad Request");
+    return false;
+  }
+
+  // Browsers cannot set headers on a WebSocket, so the token is a query param
+  std::string token;
+  const std::string &target = requestLine[1];
+  size_t tokenPos = target.find("token=");
+  if (tokenPos != std::string::npos) {
+    token = target.substr(tokenPos + 6, target.find('&', tokenPos) -
+                                            (tokenPos + 6));
+  }
+  std::string username;
+  if (!authenticate(token, username)) {
+    refuse(conn, "401 Unauthorized");
+    return false;
+  }
+  if (openConnections >= MAX_CONNECTIONS) {
+    refuse(conn, "503 Service Unavailable");
+    return false;
+  }
+
+  conn->open = true;
+  conn->userId = userManager.getUserId(username);
+  conn->username = username;
+  ++openConnections;
+  loop.timers().cancel(conn->timer);
+  conn->timer = 0;
+
+  // The notifier only holds a weak reference: a publisher working from an
+  // older topic snapshot may still deliver after the connection is gone
+  std::weak_ptr<Connection> weak = conn;
+  conn->subscription = pubSub.subscribe(
+      {PubSub::TOPIC_CHAT, PubSub::TOPIC_TASKS, PubSub::TOPIC_PRESENCE,
+       PubSub::userTopic(conn->userId)},
+      SEND_QUEUE_LIMIT, [this, weak] {
+        auto target = weak.lock();
+        if (target && !target->wakePosted.exchange(true)) {
+          loop.post([this, target] { wake(target); });
+        }
+      });
+
+  std::string accept =
+      NetworkUtils::base64Encode(NetworkUtils::sha1(key + HANDSHAKE_GUID));
+  conn->output.add(std::make_shared<const std::string>(
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: " +
+      accept + "\r\n\r\n"));
+  return true;
+}
+
+void WebSocketServer::parseFrames(const ConnectionPtr &conn) {
+  std::string &buffer = conn->input;
+  std::string &message = conn->message;
+  size_t offset = 0;
+  bool ok = true;
+  while (ok && buffer.size() - offset >= 2) {
+    const uint8_t *p =
+        reinterpret_cast<const uint8_t *>(buffer.data() + offset);
+    size_t available = buffer.size() - offset;
+    bool fin = p[0] & 0x80;
+    uint8_t opcode = p[0] & 0x0F;
+    bool masked = p[1] & 0x80;
+    uint64_t length = p[1] & 0x7F;
+    size_t header = 2;
+    if (length == 126) {
+      if (available < 4)
+        break;
+      length = (uint64_t(p[2]) << 8) | p[3];
+      header = 4;
+    } else if (length == 127) {
+      if (available < 10)
+        break;
+      length = 0;
+      for (int i = 0; i < 8; ++i) {
+        length = (length << 8) | p[2 + i];
+      }
+      header = 10;
+    }
+
+    // Client frames must be masked (RFC 6455 section 5.1)
+    if (!masked) {
+      closeConnection(conn, CLOSE_PROTOCOL_ERROR, "unmasked frame");
+      return;
+    }
+    if (length > MAX_MESSAGE_SIZE ||
+        message.size() + length > MAX_MESSAGE_SIZE) {
+      closeConnection(conn, CLOSE_TOO_BIG, "message too large");
+      return;
+    }
+    if (available < header + 4 + length)
+      break;
+
+    const uint8_t *mask = p + header;
+    std::string payload(reinterpret_cast<const char *>(p + header + 4),
+                        length);
+    for (size_t i = 0; i < payload.size(); ++i) {
+      payload[i] ^= mask[i % 4];
+    }
+    offset += header + 4 + length;
+
+    switch (opcode) {
+    case OP_TEXT:
+    case OP_CONTINUATION:
+      if (opcode == OP_TEXT)
+        message = std::move(payload);
+      else
+        message += payload;
+      if (fin) {
+        handleMessage(conn, message);
+        message.clear();
+      }
+      break;
+    case OP_BINARY:
+      closeConnection(conn, CLOSE_UNSUPPORTED, "text frames only");
+      ok = false;
+      break;
+    case OP_CLOSE:
+      closeConnection(conn, 1000, "");
+      ok = false;
+      break;
+    case OP_PING:
+      enqueue(conn, std::make_shared<const std::string>(
+                        encodeFrame(OP_PONG, payload)));
+      break;
+    default: // pong and reserved opcodes are ignored
+      break;
+    }
+    // A reply may have overflowed the queue and started the close
+    ok = ok && !conn->closing;
+  }
+  buffer.erase(0, offset);
+}
+
+void WebSocketServer::wake(const ConnectionPtr &conn) {
+  conn->wakePosted = false;
+  if (conn->socket == INVALID_SOCKET_HANDLE || conn->closing) {
+    return;
+  }
+  // Events join the output straight away, so a reader that falls behind
+  // shows up as a long output rather than a silently full subscription
+  PubSubMessagePtr message;
+  while (!conn->closing && conn->subscription->tryPop(message)) {
+    enqueue(conn, wireBuffer(message, Wire::WEBSOCKET));
+  }
+  if (conn->subscription->droppedCount() > 0) {
+    // Slow consumer: disconnect rather than deliver a gapped stream; the
+    // client resyncs when it reconnects
+    closeConnection(conn, CLOSE_POLICY, "send queue full");
+  }
+  flush(conn);
+}
+
+void WebSocketServer::flush(const ConnectionPtr &conn) {
+  if (conn->socket == INVALID_SOCKET_HANDLE) {
+    return;
+  }
+  // Everything queued since the last write goes out in as few vectored
+  // sends as the kernel takes
+  while (!conn->output.empty()) {
+    if (!EventLoop::send(conn->socket, conn->output)) {
+      drop(conn);
+      return;
+    }
+    if (!conn->output.empty()) {
+      loop.setWriteInterest(conn->socket, true);
+      return;
+    }
+  }
+  loop.setWriteInterest(conn->socket, false);
+  if (conn->closing) {
+    drop(conn); // the close frame or refusal has gone out
+  }
+}
+
+void WebSocketServer::handleMessage(const ConnectionPtr &conn,
+                                    const std::string &payload) {
+  JsonValue message;
+  if (!JsonReader::parse(payload, message) || !message.isObject()) {
+    enqueue(conn, textFrame("error", "{\"error\":\"Invalid JSON\"}"));
+    return;
+  }
+  std::string type;
+  if (!message["type"].get(type)) {
+    enqueue(conn, textFrame("error", "{\"error\":\"Missing message type\"}"));
+    return;
+  }
+
+  if (type == "chat" || type == "private") {
+    std::string content;
+    if (!message["content"].get(content) || content.empty()) {
+      enqueue(conn, textFrame("error", "{\"error\":\"Content is required\"}"));
+      return;
+    }
+    // Delivery happens through the ChatManager listener like any other
+    // message, so the sender sees its own message echoed back
+    if (type == "chat") {
+      chatManager.sendMessage(conn->userId, conn->username, content);
+    } else {
+      int targetUserId;
+      if (!message["targetUserId"].get(targetUserId)) {
+        enqueue(conn,
+                textFrame("error", "{\"error\":\"Target user ID is required\"}"));
+        return;
+      }
+      chatManager.sendPrivateMessage(conn->userId, conn->username,
+                                     targetUserId, content);
+    }
+  } else if (type == "typing") {
+    // Typing indicators are relayed, never stored
+    int targetUserId = -1;
+    message["targetUserId"].getOptional(targetUserId);
+    std::string data = "{\"userId\":" + std::to_string(conn->userId) +
+                       ",\"username\":\"" +
+                       NetworkUtils::escapeJSON(conn->username) +
+                       "\",\"targetUserId\":" + std::to_string(targetUserId) +
+                       "}";
+    eventBus.publish({targetUserId > 0 ? PubSub::userTopic(targetUserId)
+                                       : PubSub::TOPIC_CHAT},
+                     "typing", data, conn->userId);
+  } else {
+    enqueue(conn, textFrame("error", "{\"error\":\"Unknown message type\"}"));
+  }
+}
+
+void WebSocketServer::enqueue(const ConnectionPtr &conn,
+                              const std::shared_ptr<const std::string> &frame) {
+  if (conn->closing) {
+    return;
+  }
+  if (conn->output.frameCount() >= SEND_QUEUE_LIMIT) {
+    // Slow consumer: drop it rather than buffer without bound; the client
+    // resyncs when it reconnects
+    closeConnection(conn, CLOSE_POLICY, "send queue full");
+    return;
+  }
+  conn->output.add(frame);
+}
+
+void WebSocketServer::closeConnection(const ConnectionPtr &conn, uint16_t code,
+                                      const std::string &reason) {
+  if (conn->closing) {
+    return;
+  }
+  conn->closing = true;
+  conn->output.add(std::make_shared<const std::string>(
+      encodeFrame(OP_CLOSE, closePayload(code, reason))));
+  // A peer that stops reading does not hold the connection open
+  loop.timers().cancel(conn->timer);
+  conn->timer = loop.timers().schedule(loop.now() + CLOSE_TIMEOUT,
+                                       [this, conn] {
+                                         conn->timer = 0;
+                                         drop(conn);
+                                       });
+}
+
+void WebSocketServer::refuse(const ConnectionPtr &conn,
+                             const std::string &status) {
+  // The handshake timer still bounds how long this may take to go out
+  conn->closing = true;
+  conn->output.add(std::make_shared<const std::string>(httpError(status)));
+}
+
+void WebSocketServer::drop(const ConnectionPtr &conn) {
+  if (conn->socket == INVALID_SOCKET_HANDLE) {
+    return;
+  }
+  loop.timers().cancel(conn->timer);
+  conn->timer = 0;
+  if (conn->subscription) {
+    pubSub.unsubscribe(conn->subscription);
+  }
+  if (conn->open) {
+    --openConnections;
+  }
+  connections.erase(conn);
+
+  SocketHandle socket = conn->socket;
+  conn->socket = INVALID_SOCKET_HANDLE;
+  loop.unwatch(socket);
+  SocketAbstraction::closeSocket(socket);
+}
+
+void WebSocketServer::closeAll() {
+  loop.unwatch(listenSocket);
+  SocketAbstraction::closeSocket(listenSocket);
+  listenSocket = INVALID_SOCKET_HANDLE;
+
+  // One non-blocking attempt at a close frame each, then the sockets go
+  std::vector<ConnectionPtr> open(connections.begin(), connections.end());
+  for (const auto &conn : open) {
+    if (conn->open) {
+      closeConnection(conn, CLOSE_GOING_AWAY, "server shutting down");
+      flush(conn);
+    }
+    drop(conn);
+  }
+}
+
+std::string WebSocketServer::encodeFrame(uint8_t opcode,
+                                         const std::string &payload) {
+  std::string frame;
+  frame.reserve(payload.size() + 10);
+  frame += static_cast<char>(0x80 | opcode); // FIN, never fragmented
+  size_t length = payload.size();
+  if (length < 126) {
+    frame += static_cast<char>(length);
+  } else if (length <= 0xFFFF) {
+    frame += static_cast<char>(126);
+    frame += static_cast<char>((length >> 8) & 0xFF);
+    frame += static_cast<char>(length & 0xFF);
+  } else {
+    frame += static_cast<char>(127);
+    for (int i = 7; i >= 0; --i) {
+      frame += static_cast<char>((uint64_t(length) >> (i * 8)) & 0xFF);
+    }
+  }
+  return frame + payload;
+}
+
+std::shared_ptr<const std::string>
+WebSocketServer::textFrame(const std::string &type, const std::string &data) {
+  return std::make_shared<const std::string>(encodeFrame(
+      OP_TEXT, "{\"type\":\"" + type + "\",\"data\":" + data + "}"));
+}
@@ -0,0 +1,89 @@
+#include "../include/WorkerPool.hpp"
+#include <iostream>
+
+namespace {
+// The pool and queue of the calling thread, if it is a worker
+thread_local const WorkerPool *currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+} // namespace
+
+WorkerPool::WorkerPool(size_t threadCount)
+    : queued(0), sleeping(0), nextWorker(0), stolen(0), stopping(false) {
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+  // Started only once every queue exists, since workers steal from all
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers[i]->thread = std::thread(&WorkerPool::workerLoop, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  taskReady.notify_all();
+  for (auto &worker : workers) {
+    worker->thread.join();
+  }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+  Worker &target = currentPool == this
+                       ? *workers[currentIndex]
+                       : *workers[nextWorker++ % workers.size()];
+  {
+    std::lock_guard<std::mutex> lock(target.mutex);
+    target.tasks.push_back(std::move(task));
+    queued.fetch_add(1); // under the lock, so a taker never sees it first
+  }
+  if (sleeping.load() > 0) {
+    // Taking the lock orders this with a sleeper's check of queued
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    taskReady.notify_one();
+  }
+}
+
+bool WorkerPool::takeTask(size_t index, std::function<void()> &task) {
+  for (size_t i = 0; i < workers.size(); ++i) {
+    Worker &worker = *workers[(index + i) % workers.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      queued.fetch_sub(1);
+      if (i != 0) {
+        ++stolen;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::workerLoop(size_t index) {
+  currentPool = this;
+  currentIndex = index;
+  while (true) {
+    std::function<void()> task;
+    if (!takeTask(index, task)) {
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      ++sleeping;
+      taskReady.wait(lock, [this] { return stopping || queued.load() > 0; });
+      --sleeping;
+      if (queued.load() == 0) {
+        return; // stopping and drained
+      }
+      continue;
+    }
+    try {
+      task();
+    } catch (const std::exception &e) {
+      std::cerr << "Worker task failed: " << e.what() << std::endl;
+    }
+  }
+}
@@ -1,25 +1,166 @@
 // Enhanced JIRA-like Client with Error Handling - Cross-Platform
+#include "../include/BinaryProtocol.hpp"
+#include "../include/Framing.hpp"
 #include "../include/NetworkUtils.hpp"
 #include "../include/SocketAbstraction.hpp"
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <thread>
 
 std::string username;
 int userId = -1;
 bool authenticated = false;
+// --binary: speak BinaryProtocol and render its typed messages here
+bool binaryMode = false;
+// Held for a whole frame, so a PONG from the receiver thread never lands
+// inside a command the main thread is sending
+std::mutex sendMutex;
+
+// Sends one encoded frame in full; returns false if the connection failed
+bool sendFrame(SocketHandle sock, const std::string &frame) {
+  std::lock_guard<std::mutex> lock(sendMutex);
+  size_t offset = 0;
+  while (offset < frame.size()) {
+    int sent = SocketAbstraction::sendData(sock, frame.data() + offset,
+                                           frame.size() - offset);
+    if (sent <= 0) {
+      return false;
+    }
+    offset += static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+// Renders a binary message the way the server words it in text mode;
+// returns false for messages the text protocol would not show
+bool renderBinary(const std::string &message, std::string &out) {
+  BinaryReader reader(message);
+  BinaryProtocol::Type type;
+  if (!BinaryProtocol::readType(reader, type)) {
+    return false;
+  }
+  switch (type) {
+  case BinaryProtocol::Type::TEXT:
+    return reader.readString(out);
+  case BinaryProtocol::Type::TASK_LIST: {
+    uint64_t count = 0;
+    if (!reader.readVarint(count)) {
+      return false;
+    }
+    out = "[TASKS] " + std::to_string(count) + " task(s):\n";
+    Task task;
+    for (uint64_t i = 0; i < count && BinaryProtocol::readTask(reader, task);
+         ++i) {
+      out += task.toString() + "\n";
+    }
+    return reader.ok();
+  }
+  case BinaryProtocol::Type::TASK: {
+    uint8_t change = 0;
+    Task task;
+    if (!reader.readByte(change) || !BinaryProtocol::readTask(reader, task)) {
+      return false;
+    }
+    out = "[TASK] " + task.toString();
+    return true;
+  }
+  case BinaryProtocol::Type::TASKS: {
+    uint8_t change = 0;
+    uint64_t count = 0;
+    if (!reader.readByte(change) || !reader.readVarint(count)) {
+      return false;
+    }
+    out = "[TASK] " + std::to_string(count) + " task(s) changed:";
+    Task task;
+    for (uint64_t i = 0; i < count && BinaryProtocol::readTask(reader, task);
+         ++i) {
+      out += "\n" + task.toString();
+    }
+    return reader.ok();
+  }
+  case BinaryProtocol::Type::CHAT: {
+    Chat chat;
+    if (!BinaryProtocol::readChat(reader, chat)) {
+      return false;
+    }
+    if (chat.getType() == MessageType::GENERAL) {
+      out = "[" + chat.getSenderName() + "] " + chat.getContent();
+    } else if (chat.getType() == MessageType::PRIVATE) {
+      out = "[PM from " + chat.getSenderName() + "] " + chat.getContent();
+    } else {
+      return false;
+    }
+    return true;
+  }
+  case BinaryProtocol::Type::PRESENCE: {
+    User user;
+    if (!BinaryProtocol::readPresence(reader, user)) {
+      return false;
+    }
+    out = "[SYSTEM] " + user.getUsername() +
+          (user.getOnlineStatus() ? " is now online" : " disconnected");
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+// Answers the server's heartbeat, so an idle client is not taken for dead
+void answerPing(SocketHandle sock) {
+  std::string pong;
+  if (binaryMode) {
+    Framing::encodeBinary(pong, BinaryProtocol::pong());
+  } else {
+    Framing::encode(pong, Framing::PONG);
+  }
+  sendFrame(sock, pong);
+}
 
 void receiveMessages(SocketHandle sock) {
-  char buffer[1024];
+  char buffer[4096];
+  FrameReader frames;
+  std::string message;
+  std::string rendered;
   while (true) {
     try {
-      int bytes =
-          SocketAbstraction::receiveData(sock, buffer, sizeof(buffer) - 1);
+      int bytes = SocketAbstraction::receiveData(sock, buffer, sizeof(buffer));
       if (bytes > 0) {
-        buffer[bytes] = '\0';
-        std::cout << "\n" << buffer << "\n> ";
-        std::cout.flush();
+        frames.append(buffer, bytes);
+        bool shown = false; // re-prompt only if something was printed
+        while (frames.next(message)) {
+          if (frames.getMode() == FrameReader::Mode::LENGTH_PREFIXED) {
+            BinaryReader reader(message);
+            BinaryProtocol::Type type;
+            if (BinaryProtocol::readType(reader, type) &&
+                type == BinaryProtocol::Type::PING) {
+              answerPing(sock);
+            } else if (renderBinary(message, rendered)) {
+              std::cout << "\n" << rendered << "\n";
+              shown = true;
+            }
+            continue;
+          }
+          if (message == Framing::PING) {
+            answerPing(sock);
+            continue;
+          }
+          unsigned version = 0;
+          if (binaryMode && BinaryProtocol::parseUpgrade(message, version)) {
+            // Everything after the server's reply is binary
+            frames.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+            continue;
+          }
+          std::cout << "\n" << message << "\n";
+          shown = true;
+        }
+        if (shown) {
+          std::cout << "> ";
+          std::cout.flush();
+        }
       } else if (bytes == 0) {
         std::cout << "\n[SYSTEM] Connection closed by server\n";
         break;
@@ -72,7 +213,8 @@ void showHelp() {
   std::cout << "================================================\n\n";
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+  binaryMode = argc > 1 && std::string(argv[1]) == "--binary";
   try {
     // Initialize socket subsystem (required on Windows)
     if (!SocketAbstraction::initialize()) {
@@ -96,6 +238,10 @@ int main() {
       return -1;
     }
 
+    if (binaryMode) {
+      sendFrame(sock, Framing::encode(BinaryProtocol::upgradeLine()));
+    }
+
     std::thread receiver(receiveMessages, sock);
     receiver.detach();
 
@@ -120,10 +266,13 @@ int main() {
         continue;
 
       try {
-        std::string message = NetworkUtils::formatMessage("CMD", input);
-        int sent =
-            SocketAbstraction::sendData(sock, message.c_str(), message.size());
-        if (sent < 0) {
+        std::string message;
+        if (binaryMode) {
+          Framing::encodeBinary(message, BinaryProtocol::command(input));
+        } else {
+          message = Framing::encode(NetworkUtils::formatMessage("CMD", input));
+        }
+        if (!sendFrame(sock, message)) {
           std::cerr << "Failed to send message: "
                     << SocketAbstraction::getLastError() << std::endl;
           break;
@@ -0,0 +1,106 @@
+// JSON serialization benchmark - task listings as GET /api/tasks sends them
+//
+// Serializes the same tasks twice: once the way responses were built
+// before JsonWriter (ostringstream per task, then copied into the list and
+// the envelope), once through NetworkUtils::writeTask into one reserved
+// buffer. Reports the best time of several runs and checks that both
+// produce the same bytes. Server and network time are not included.
+//
+// Usage: json_bench [tasks] [runs]
+#include "../include/JsonWriter.hpp"
+#include "../include/NetworkUtils.hpp"
+#include "../include/Task.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+// The pre-JsonWriter serializer, kept only for comparison
+std::string streamTask(const Task &task) {
+  std::ostringstream oss;
+  oss << "{"
+      << "\"id\":" << task.getTaskId() << ","
+      << "\"title\":\"" << NetworkUtils::escapeJSON(task.getTitle()) << "\","
+      << "\"description\":\""
+      << NetworkUtils::escapeJSON(task.getDescription()) << "\","
+      << "\"status\":\"" << task.getStatusString() << "\","
+      << "\"priority\":\"" << task.getPriorityString() << "\","
+      << "\"assigneeId\":" << task.getAssigneeId() << ","
+      << "\"reporterId\":" << task.getReporterId() << ","
+      << "\"projectKey\":\"" << NetworkUtils::escapeJSON(task.getProjectKey())
+      << "\","
+      << "\"deadline\":\"" << task.getDeadlineString() << "\","
+      << "\"isOverdue\":" << (task.isOverdue() ? "true" : "false") << ","
+      << "\"daysUntilDeadline\":" << task.getDaysUntilDeadline() << "}";
+  return oss.str();
+}
+
+std::string streamResponse(const std::vector<Task> &tasks) {
+  std::ostringstream oss;
+  oss << "[";
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    oss << streamTask(tasks[i]);
+    if (i < tasks.size() - 1)
+      oss << ",";
+  }
+  oss << "]";
+  return "{\"success\":true,\"message\":\"Tasks retrieved\",\"data\":" +
+         oss.str() + "}";
+}
+
+std::string writerResponse(const std::vector<Task> &tasks) {
+  std::string out;
+  out.reserve(64 + tasks.size() * 256);
+  JsonWriter json(out);
+  json.beginObject()
+      .field("success", true)
+      .field("message", "Tasks retrieved")
+      .key("data")
+      .beginArray();
+  for (const auto &task : tasks) {
+    NetworkUtils::writeTask(json, task);
+  }
+  json.endArray().endObject();
+  return out;
+}
+
+template <typename F> double bestMillis(int runs, F serialize) {
+  double best = 1e300;
+  for (int i = 0; i < runs; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    std::string body = serialize();
+    std::chrono::duration<double, std::milli> took =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, took.count());
+  }
+  return best;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  int runs = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  std::vector<Task> tasks;
+  tasks.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    int id = static_cast<int>(i + 1);
+    tasks.emplace_back(id, "Task number " + std::to_string(id),
+                       "Some \"quoted\" description text for the task", 2,
+                       "PROJ", static_cast<int>(i % 30) - 5);
+  }
+
+  std::string before = streamResponse(tasks);
+  std::string after = writerResponse(tasks);
+  std::printf("%zu tasks, %zu bytes, outputs %s\n", count, after.size(),
+              before == after ? "identical" : "DIFFER");
+  double streamed = bestMillis(runs, [&] { return streamResponse(tasks); });
+  double written = bestMillis(runs, [&] { return writerResponse(tasks); });
+  std::printf("ostringstream %8.1f ms\n", streamed);
+  std::printf("JsonWriter    %8.1f ms  (%.1fx)\n", written, streamed / written);
+  return before == after ? 0 : 1;
+}
@@ -1,11 +1,18 @@
 // Enhanced JIRA-like Server with Error Handling - Cross-Platform
+#include "../include/BinaryProtocol.hpp"
 #include "../include/ChatManager.hpp"
+#include "../include/EventBus.hpp"
 #include "../include/HTTPServer.hpp"
+#include "../include/JsonWriter.hpp"
 #include "../include/NetworkUtils.hpp"
+#include "../include/PubSub.hpp"
 #include "../include/SocketAbstraction.hpp"
+#include "../include/TCPServer.hpp"
 #include "../include/TaskManager.hpp"
 #include "../include/User.hpp"
+#include "../include/UserManager.hpp"
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <map>
 #include <mutex>
@@ -14,40 +21,142 @@
 #include <thread>
 #include <vector>
 
-std::mutex serverMutex;
+// Each piece of shared state carries its own lock: the managers synchronize
+// internally and clientsMutex only guards the connection list. Sends only
+// queue output for the TCP server's event loop, so they never block.
+std::mutex clientsMutex;
 TaskManager taskManager;
 ChatManager chatManager;
+UserManager userManager;
+PubSub pubSub;
+// Every manager change reaches TCP, SSE and WebSocket clients through here
+EventBus eventBus(taskManager, chatManager, userManager, pubSub);
+
+// Reads a count from the environment, e.g. TCP_REACTORS=4
+unsigned envCount(const char *name, unsigned fallback) {
+  const char *value = std::getenv(name);
+  if (value == nullptr) {
+    return fallback;
+  }
+  try {
+    return static_cast<unsigned>(std::stoul(value));
+  } catch (const std::exception &) {
+    std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+    return fallback;
+  }
+}
+
+TCPServer::Options tcpOptions() {
+  TCPServer::Options options;
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  options.reactors = envCount("TCP_REACTORS", cores);
+  options.workerThreads = envCount("TCP_WORKERS", std::max(2u, cores));
+  options.sessionQueueLimit =
+      envCount("TCP_SESSION_QUEUE",
+               static_cast<unsigned>(options.sessionQueueLimit));
+  options.pinToCpus = envCount("TCP_PIN_CPUS", 0) != 0;
+  const char *backend = std::getenv("TCP_IO_BACKEND");
+  if (backend != nullptr && std::string(backend) == "io_uring") {
+    options.backend = TCPServer::IoBackend::IO_URING;
+  }
+  options.maxConnections = envCount("TCP_MAX_CONNECTIONS", 0);
+  options.admission.maxInFlight = envCount(
+      "TCP_MAX_IN_FLIGHT", static_cast<unsigned>(options.admission.maxInFlight));
+  options.admission.maxQueueWait = std::chrono::milliseconds(
+      envCount("TCP_MAX_QUEUE_WAIT_MS",
+               static_cast<unsigned>(options.admission.maxQueueWait.count())));
+  options.heartbeatInterval = std::chrono::seconds(envCount(
+      "TCP_HEARTBEAT_S",
+      static_cast<unsigned>(options.heartbeatInterval.count())));
+  options.heartbeatTimeout = std::chrono::seconds(envCount(
+      "TCP_HEARTBEAT_TIMEOUT_S",
+      static_cast<unsigned>(options.heartbeatTimeout.count())));
+  options.idleTimeout = std::chrono::seconds(envCount("TCP_IDLE_TIMEOUT_S", 0));
+  options.output.highWater = envCount(
+      "TCP_OUTPUT_HIGH_WATER", static_cast<unsigned>(options.output.highWater));
+  const char *policy = std::getenv("TCP_SLOW_CONSUMER");
+  if (policy != nullptr) {
+    std::string name(policy);
+    if (name == "drop_oldest") {
+      options.output.policy = OutboundQueue::Policy::DROP_OLDEST;
+    } else if (name == "coalesce") {
+      options.output.policy = OutboundQueue::Policy::COALESCE;
+    } else if (name == "disconnect") {
+      options.output.policy = OutboundQueue::Policy::DISCONNECT;
+    } else {
+      std::cerr << "Ignoring invalid TCP_SLOW_CONSUMER=" << name << std::endl;
+    }
+  }
+  return options;
+}
+
+// REST API: HTTP_MAX_IN_FLIGHT requests and HTTP_MAX_QUEUE_WAIT_MS of
+// queueing before requests are refused by priority with 503
+AdmissionControl::Limits httpAdmission() {
+  AdmissionControl::Limits limits;
+  limits.maxInFlight =
+      envCount("HTTP_MAX_IN_FLIGHT",
+               static_cast<unsigned>(HTTPServer::DEFAULT_MAX_IN_FLIGHT));
+  limits.maxQueueWait = std::chrono::milliseconds(
+      envCount("HTTP_MAX_QUEUE_WAIT_MS",
+               static_cast<unsigned>(limits.maxQueueWait.count())));
+  return limits;
+}
+
+// CLI clients: one reactor per core (TCP_REACTORS overrides, TCP_PIN_CPUS=1
+// pins each to its core, TCP_IO_BACKEND=io_uring swaps epoll for io_uring),
+// commands on a work-stealing pool of TCP_WORKERS threads. Past
+// TCP_MAX_CONNECTIONS clients, TCP_MAX_IN_FLIGHT commands or
+// TCP_MAX_QUEUE_WAIT_MS of queueing, work is refused by priority (see
+// commandPriority). Clients silent for TCP_HEARTBEAT_S are pinged and
+// closed if TCP_HEARTBEAT_TIMEOUT_S passes without an answer, and with
+// TCP_IDLE_TIMEOUT_S set, closed after that long without a command. Each
+// connection may have TCP_SESSION_QUEUE commands waiting, and queues at most
+// TCP_OUTPUT_HIGH_WATER bytes before TCP_SLOW_CONSUMER (drop_oldest,
+// coalesce or disconnect) applies.
+TCPServer tcpServer(pubSub, tcpOptions());
 std::vector<ClientInfo> clients;
-std::map<std::string, User> users;
 int nextUserId = 1;
 
 void initializeUsers() {
-  users.insert(
-      {"admin", User(1, "admin", "admin@company.com", UserRole::ADMIN)});
-  users.insert(
-      {"pm1", User(2, "pm1", "pm1@company.com", UserRole::PROJECT_MANAGER)});
-  users.insert(
-      {"dev1", User(3, "dev1", "dev1@company.com", UserRole::DEVELOPER)});
-  users.insert(
-      {"tester1", User(4, "tester1", "tester1@company.com", UserRole::TESTER)});
+  userManager.addUser("admin",
+                      User(1, "admin", "admin@company.com", UserRole::ADMIN));
+  userManager.addUser(
+      "pm1", User(2, "pm1", "pm1@company.com", UserRole::PROJECT_MANAGER));
+  userManager.addUser(
+      "dev1", User(3, "dev1", "dev1@company.com", UserRole::DEVELOPER));
+  userManager.addUser(
+      "tester1", User(4, "tester1", "tester1@company.com", UserRole::TESTER));
   nextUserId = 5;
 }
 
-ClientInfo *findClient(SocketHandle socketId) {
-  try {
-    for (auto &client : clients) {
-      if (client.socketId == socketId)
-        return &client;
+bool getClient(SocketHandle socketId, ClientInfo &out) {
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  for (const auto &client : clients) {
+    if (client.socketId == socketId) {
+      out = client;
+      return true;
+    }
+  }
+  return false;
+}
+
+void markAuthenticated(SocketHandle socketId, int userId,
+                       const std::string &username) {
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  for (auto &client : clients) {
+    if (client.socketId == socketId) {
+      client.userId = userId;
+      client.username = username;
+      client.authenticated = true;
+      return;
     }
-  } catch (const std::exception &e) {
-    std::cerr << "Error finding client: " << e.what() << std::endl;
   }
-  return nullptr;
 }
 
 std::vector<std::string> getOnlineUsers() {
   std::vector<std::string> onlineUsers;
-  for (const auto &pair : users) {
+  for (const auto &pair : userManager.getAllUsers()) {
     if (pair.second.getOnlineStatus()) {
       onlineUsers.push_back(pair.first + " (" + pair.second.getRoleString() +
                             ")");
@@ -57,23 +166,158 @@ std::vector<std::string> getOnlineUsers() {
 }
 
 bool sendSafeMessage(SocketHandle socket, const std::string &message) {
+  return tcpServer.send(socket, message);
+}
+
+// Binary clients get one TASK_LIST message, text clients a listing under
+// heading with one line per task
+void sendTasks(SocketHandle socket, const std::vector<Task> &tasks,
+               const std::string &heading, const std::string &none,
+               const std::string &bullet = "") {
+  if (tcpServer.protocol(socket) == TCPServer::Protocol::BINARY) {
+    tcpServer.sendBinary(socket, BinaryProtocol::taskList(tasks));
+    return;
+  }
+  std::string response = heading + "\n";
+  if (tasks.empty()) {
+    response += none + "\n";
+  } else {
+    for (const auto &task : tasks) {
+      response += bullet + task.toString() + "\n";
+    }
+  }
+  sendSafeMessage(socket, response);
+}
+
+// Same cap as POST /api/tasks/bulk. Ranges in /bulk are expanded, so a
+// typo like 1-1000000000 is refused.
+constexpr size_t MAX_BULK_TASKS = HTTPServer::MAX_BULK_TASKS;
+
+std::string tooManyTasks() {
+  return "[ERROR] Too many tasks (max " + std::to_string(MAX_BULK_TASKS) + ")";
+}
+
+// Task IDs as "1,4,10-20"; false if malformed or empty, or with tooMany set
+// if there are more than MAX_BULK_TASKS
+bool parseTaskIds(const std::string &list, std::vector<int> &ids,
+                  bool &tooMany) {
+  tooMany = false;
   try {
-    int result =
-        SocketAbstraction::sendData(socket, message.c_str(), message.size());
-    return result != -1;
+    for (const auto &item : NetworkUtils::splitString(list, ',')) {
+      size_t dash = item.find('-', 1);
+      int first = std::stoi(item.substr(0, dash));
+      int last =
+          dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+      if (first < 1 || last < first) {
+        return false;
+      }
+      if (ids.size() + static_cast<size_t>(last - first) >= MAX_BULK_TASKS) {
+        tooMany = true;
+        return false;
+      }
+      for (int id = first; id <= last; ++id) {
+        ids.push_back(id);
+      }
+    }
   } catch (const std::exception &e) {
-    std::cerr << "Error sending message: " << e.what() << std::endl;
     return false;
   }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return !ids.empty();
+}
+
+// /bulk status|priority|assign <value> <ids>, or
+// /bulk create <title> | <desc> ; <title> | <desc> ...
+// Each batch is one TaskManager call: one lock, one save, one event
+void processBulk(SocketHandle clientSock, const ClientInfo &client,
+                 const std::string &command,
+                 const std::vector<std::string> &parts) {
+  const std::string &action = parts[1];
+  if (action == "create") {
+    std::vector<NewTask> newTasks;
+    std::string list = command.substr(command.find("create") + 6);
+    for (const auto &entry : NetworkUtils::splitString(list, ';')) {
+      if (newTasks.size() == MAX_BULK_TASKS) {
+        sendSafeMessage(clientSock, tooManyTasks());
+        return;
+      }
+      size_t pos = entry.find('|');
+      NewTask newTask;
+      newTask.title = NetworkUtils::trim(entry.substr(0, pos));
+      if (pos != std::string::npos) {
+        newTask.description = NetworkUtils::trim(entry.substr(pos + 1));
+      }
+      newTasks.push_back(std::move(newTask));
+    }
+    auto created = taskManager.createTasks(newTasks, client.userId);
+    sendSafeMessage(clientSock, "[BULK] Created " +
+                                    std::to_string(created.size()) +
+                                    " task(s)");
+    return;
+  }
+
+  std::vector<int> ids;
+  bool tooMany = false;
+  if (parts.size() < 4 || !parseTaskIds(parts[3], ids, tooMany)) {
+    sendSafeMessage(clientSock,
+                    tooMany ? tooManyTasks()
+                            : "[ERROR] Usage: /bulk status|priority|assign "
+                              "<value> <ids, e.g. 1,4,10-20>");
+    return;
+  }
+  std::vector<Task> changed;
+  if (action == "status") {
+    TaskStatus status;
+    if (!Task::parseStatus(parts[2], status)) {
+      sendSafeMessage(
+          clientSock,
+          "[ERROR] Invalid status. Use: TODO, PROGRESS, REVIEW, DONE, BLOCKED");
+      return;
+    }
+    changed = taskManager.updateTasksStatus(ids, status, client.userId);
+  } else if (action == "priority") {
+    TaskPriority priority;
+    if (!Task::parsePriority(parts[2], priority)) {
+      sendSafeMessage(
+          clientSock,
+          "[ERROR] Invalid priority. Use: LOW, MEDIUM, HIGH, CRITICAL");
+      return;
+    }
+    changed = taskManager.updateTasksPriority(ids, priority, client.userId);
+  } else if (action == "assign") {
+    User assigner;
+    userManager.getUser(client.username, assigner);
+    if (!assigner.hasPermission("assign_task")) {
+      sendSafeMessage(
+          clientSock,
+          "[ERROR] Only Project Managers and Admins can assign tasks");
+      return;
+    }
+    int assigneeId = -1;
+    try {
+      assigneeId = std::stoi(parts[2]);
+    } catch (const std::exception &e) {
+      sendSafeMessage(clientSock, "[ERROR] Invalid user ID");
+      return;
+    }
+    changed = taskManager.assignTasks(ids, assigneeId, client.userId);
+  } else {
+    sendSafeMessage(clientSock, "[ERROR] Unknown bulk action. Use: create, "
+                                "status, priority, assign");
+    return;
+  }
+  sendSafeMessage(clientSock, "[BULK] Updated " +
+                                  std::to_string(changed.size()) + " of " +
+                                  std::to_string(ids.size()) + " task(s)");
 }
 
 void processCommand(SocketHandle clientSock, const std::string &command) {
   try {
-    std::lock_guard<std::mutex> lock(serverMutex);
-
-    ClientInfo *client = findClient(clientSock);
-    if (!client)
+    ClientInfo clientInfo;
+    if (!getClient(clientSock, clientInfo))
       return;
+    ClientInfo *client = &clientInfo;
 
     std::vector<std::string> parts = NetworkUtils::splitString(command, ' ');
     if (parts.empty())
@@ -86,20 +330,24 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
       std::string username = parts[1];
       std::string password = parts[2];
 
-      if (users.find(username) != users.end() &&
+      User user;
+      if (userManager.getUser(username, user) &&
           NetworkUtils::authenticateUser(username, password)) {
-        client->userId = users[username].getUserId();
+        client->userId = user.getUserId();
         client->username = username;
         client->authenticated = true;
-        users[username].setOnlineStatus(true);
-        users[username].setSocketId(clientSock);
+        markAuthenticated(clientSock, client->userId, username);
+        tcpServer.subscribe(clientSock, client->userId,
+                            {PubSub::TOPIC_CHAT, PubSub::TOPIC_TASKS,
+                             PubSub::TOPIC_PRESENCE,
+                             PubSub::userTopic(client->userId)});
+        userManager.setOnlineStatus(username, true);
+        userManager.setSocketId(username, clientSock);
 
         response = "[SYSTEM] Welcome " + username + "! You are now logged in.";
         sendSafeMessage(clientSock, response);
 
         chatManager.sendSystemMessage(username + " joined the system");
-        NetworkUtils::broadcastToAll(clients,
-                                     "[SYSTEM] " + username + " is now online");
 
         auto onlineUsers = getOnlineUsers();
         std::string usersList = "[ONLINE] Users online: ";
@@ -151,19 +399,16 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
         }
       }
 
+      // Clients hear about the new task from the event bus
       int taskId = taskManager.createTask(title, desc, client->userId, "PROJ",
                                           deadlineDays);
-      response = "[TASK] Created task PROJ-" + std::to_string(taskId) + ": " +
-                 title + " (Deadline: " + std::to_string(deadlineDays) +
-                 " days)";
-
-      NetworkUtils::broadcastToAll(clients, response);
       chatManager.sendTaskUpdate(client->userId, client->username, taskId,
                                  "Task created: " + title);
     } else if (cmd == "/assign" && parts.size() >= 3) {
       // PERMISSION CHECK: Only PM and Admin can assign tasks
       std::string assignerUsername = client->username;
-      User &assignerUser = users[assignerUsername];
+      User assignerUser;
+      userManager.getUser(assignerUsername, assignerUser);
 
       if (!assignerUser.hasPermission("assign_task")) {
         sendSafeMessage(
@@ -176,11 +421,7 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
         int taskId = std::stoi(parts[1]);
         int assigneeId = std::stoi(parts[2]);
 
-        if (taskManager.assignTask(taskId, assigneeId, client->userId)) {
-          response = "[TASK] Task " + std::to_string(taskId) +
-                     " assigned to user " + std::to_string(assigneeId);
-          NetworkUtils::broadcastToAll(clients, response);
-        } else {
+        if (!taskManager.assignTask(taskId, assigneeId, client->userId)) {
           sendSafeMessage(clientSock, "[ERROR] Failed to assign task");
         }
       } catch (const std::exception &e) {
@@ -201,45 +442,24 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
         else if (statusStr == "BLOCKED")
           status = TaskStatus::BLOCKED;
 
-        if (taskManager.updateTaskStatus(taskId, status, client->userId)) {
-          response = "[TASK] Task " + std::to_string(taskId) +
-                     " status updated to " + statusStr;
-          NetworkUtils::broadcastToAll(clients, response);
-        }
+        taskManager.updateTaskStatus(taskId, status, client->userId);
       } catch (const std::exception &e) {
         sendSafeMessage(clientSock, "[ERROR] Invalid task ID");
       }
+    } else if (cmd == "/bulk" && parts.size() >= 3) {
+      processBulk(clientSock, *client, command, parts);
     } else if (cmd == "/list") {
-      auto tasks = taskManager.getAllTasks();
-      response = "[TASKS] Current Tasks:\n";
-      if (tasks.empty()) {
-        response += "No tasks found.\n";
-      } else {
-        for (const auto &task : tasks) {
-          response += task.toString() + "\n";
-        }
-      }
-      sendSafeMessage(clientSock, response);
+      sendTasks(clientSock, taskManager.getAllTasks(),
+                "[TASKS] Current Tasks:", "No tasks found.");
     } else if (cmd == "/mytasks") {
-      auto tasks = taskManager.getTasksByAssignee(client->userId);
-      response = "[MY TASKS] Your assigned tasks:\n";
-      if (tasks.empty()) {
-        response += "No tasks assigned to you.\n";
-      } else {
-        for (const auto &task : tasks) {
-          response += task.toString() + "\n";
-        }
-      }
-      sendSafeMessage(clientSock, response);
+      sendTasks(clientSock, taskManager.getTasksByAssignee(client->userId),
+                "[MY TASKS] Your assigned tasks:", "No tasks assigned to you.");
     } else if (cmd == "/comment" && parts.size() >= 3) {
       try {
         int taskId = std::stoi(parts[1]);
         std::string comment = command.substr(command.find(parts[2]));
 
-        if (taskManager.addTaskComment(taskId, comment, client->userId)) {
-          response = "[TASK] Comment added to task " + std::to_string(taskId);
-          NetworkUtils::broadcastToAll(clients, response);
-        } else {
+        if (!taskManager.addTaskComment(taskId, comment, client->userId)) {
           sendSafeMessage(clientSock, "[ERROR] Failed to add comment");
         }
       } catch (const std::exception &e) {
@@ -266,11 +486,7 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
           return;
         }
 
-        if (taskManager.updateTaskPriority(taskId, priority, client->userId)) {
-          response = "[TASK] Task " + std::to_string(taskId) +
-                     " priority updated to " + priorityStr;
-          NetworkUtils::broadcastToAll(clients, response);
-        } else {
+        if (!taskManager.updateTaskPriority(taskId, priority, client->userId)) {
           sendSafeMessage(clientSock, "[ERROR] Failed to update priority");
         }
       } catch (const std::exception &e) {
@@ -279,8 +495,6 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
     } else if (cmd == "/chat" && parts.size() >= 2) {
       std::string message = command.substr(6);
       chatManager.sendMessage(client->userId, client->username, message);
-      response = "[" + client->username + "] " + message;
-      NetworkUtils::broadcastToAll(clients, response);
     } else if (cmd == "/pm" && parts.size() >= 3) {
       std::string target = parts[1];
       std::string message = command.substr(command.find(parts[2]));
@@ -289,19 +503,16 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
       std::string targetUsername;
 
       // Try to find by username first
-      if (users.find(target) != users.end()) {
-        targetId = users[target].getUserId();
+      targetId = userManager.getUserId(target);
+      if (targetId != -1) {
         targetUsername = target;
       } else {
         // Try to parse as user ID
         try {
           int id = std::stoi(target);
-          for (const auto &user : users) {
-            if (user.second.getUserId() == id) {
-              targetId = id;
-              targetUsername = user.first;
-              break;
-            }
+          targetUsername = userManager.getUsernameById(id);
+          if (!targetUsername.empty()) {
+            targetId = id;
           }
         } catch (const std::exception &e) {
           // Not a valid number, continue with username search
@@ -316,8 +527,6 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
 
       chatManager.sendPrivateMessage(client->userId, client->username, targetId,
                                      message);
-      NetworkUtils::sendToUser(clients, targetId,
-                               "[PM from " + client->username + "] " + message);
       response = "[PM sent to " + targetUsername + "] " + message;
       sendSafeMessage(clientSock, response);
     } else if (cmd == "/online") {
@@ -333,19 +542,15 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
       sendSafeMessage(clientSock, response);
     } else if (cmd == "/dashboard") {
       // DASHBOARD: Generate comprehensive project dashboard
-      response = taskManager.generateDashboard(users);
+      response = taskManager.generateDashboard(userManager.getAllUsers());
       sendSafeMessage(clientSock, response);
     } else if (cmd == "/recommend") {
       // SMART ASSIGNMENT: Recommend best assignee
-      int recommendedId = taskManager.recommendBestAssignee(users);
+      int recommendedId =
+          taskManager.recommendBestAssignee(userManager.getAllUsers());
       if (recommendedId != -1) {
-        std::string recommendedUser;
-        for (const auto &user : users) {
-          if (user.second.getUserId() == recommendedId) {
-            recommendedUser = user.first;
-            break;
-          }
-        }
+        std::string recommendedUser =
+            userManager.getUsernameById(recommendedId);
         response =
             "[RECOMMEND] Best assignee: " + recommendedUser +
             " (ID: " + std::to_string(recommendedId) +
@@ -359,16 +564,10 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
     } else if (cmd == "/overdue") {
       // Show overdue tasks
       auto overdueTasks = taskManager.getOverdueTasks();
-      response = "[OVERDUE] Overdue tasks (" +
-                 std::to_string(overdueTasks.size()) + "):\n";
-      if (overdueTasks.empty()) {
-        response += "No overdue tasks.\n";
-      } else {
-        for (const auto &task : overdueTasks) {
-          response += "- " + task.toString() + "\n";
-        }
-      }
-      sendSafeMessage(clientSock, response);
+      sendTasks(clientSock, overdueTasks,
+                "[OVERDUE] Overdue tasks (" +
+                    std::to_string(overdueTasks.size()) + "):",
+                "No overdue tasks.", "- ");
     } else if (cmd == "/help") {
       // FIX: Add help command handler
       response = "\n=== ENHANCED JIRA-like Task Manager Commands ===\n";
@@ -382,6 +581,11 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
       response += "  /status <taskId> <status>     - Update status\n";
       response += "  /priority <taskId> <priority> - Set priority\n";
       response += "  /comment <taskId> <comment>   - Add comment\n";
+      response += "  /bulk status|priority|assign <value> <ids>\n";
+      response += "                                - Change many tasks, "
+                  "e.g. /bulk status DONE 1-20,25\n";
+      response += "  /bulk create <title> | <desc> ; <title> ...\n";
+      response += "                                - Create many tasks\n";
       response += "  /list                         - List all tasks\n";
       response += "  /mytasks                      - Show my tasks\n\n";
       response += "SMART FEATURES:\n";
@@ -407,77 +611,65 @@ void processCommand(SocketHandle clientSock, const std::string &command) {
   }
 }
 
-void handleClient(SocketHandle clientSock) {
-  try {
-    ClientInfo client{clientSock, -1, "", false};
-
-    {
-      std::lock_guard<std::mutex> lock(serverMutex);
-      clients.push_back(client);
-    }
-
-    std::string welcome = "[SYSTEM] Connected to JIRA-like Task Manager. "
-                          "Please login with /login <username> <password>";
-    if (!sendSafeMessage(clientSock, welcome)) {
-      SocketAbstraction::closeSocket(clientSock);
-      return;
-    }
-
-    char buffer[1024];
-    while (true) {
-      int bytes = SocketAbstraction::receiveData(clientSock, buffer,
-                                                 sizeof(buffer) - 1);
-      if (bytes <= 0)
-        break;
-
-      buffer[bytes] = '\0';
-      std::string input(buffer);
+void handleConnect(SocketHandle clientSock) {
+  {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.push_back(ClientInfo{clientSock, -1, "", false});
+  }
+  sendSafeMessage(clientSock, "[SYSTEM] Connected to JIRA-like Task Manager. "
+                              "Please login with /login <username> <password>");
+}
 
-      while (!input.empty() && (input.back() == '\n' || input.back() == '\r')) {
-        input.pop_back();
-      }
+void handleInput(SocketHandle clientSock, const std::string &input) {
+  bool binary = tcpServer.protocol(clientSock) == TCPServer::Protocol::BINARY;
+  std::string command;
+  if (NetworkUtils::parseCommand(input, binary, command)) {
+    processCommand(clientSock, command);
+  }
+}
 
-      if (!input.empty()) {
-        auto parsed = NetworkUtils::parseMessage(input);
-        if (parsed.first == "CMD" || parsed.first.empty()) {
-          processCommand(clientSock,
-                         parsed.second.empty() ? input : parsed.second);
-        }
-      }
-    }
-  } catch (const std::exception &e) {
-    std::cerr << "Error handling client: " << e.what() << std::endl;
+// Under load, logging in and chatting keep working longest and listings
+// are refused first
+AdmissionControl::Priority commandPriority(const std::string &input) {
+  // Binary commands come without the "CMD:" prefix; either way the name
+  // is the first word
+  size_t start = input.compare(0, 4, "CMD:") == 0 ? 4 : 0;
+  std::string cmd = input.substr(start, input.find(' ', start) - start);
+  if (cmd == "/login" || cmd == "/chat" || cmd == "/pm" || cmd == "/quit") {
+    return AdmissionControl::Priority::HIGH;
+  }
+  if (cmd == "/list" || cmd == "/mytasks" || cmd == "/overdue" ||
+      cmd == "/dashboard" || cmd == "/recommend" || cmd == "/online") {
+    return AdmissionControl::Priority::LOW;
   }
+  return AdmissionControl::Priority::NORMAL;
+}
 
-  // Cleanup on disconnect
+void handleDisconnect(SocketHandle clientSock) {
   try {
-    std::lock_guard<std::mutex> lock(serverMutex);
-
-    ClientInfo *disconnectedClient = nullptr;
-    for (auto &client : clients) {
-      if (client.socketId == clientSock) {
-        disconnectedClient = &client;
-        break;
+    ClientInfo disconnectedClient{clientSock, -1, "", false};
+    {
+      std::lock_guard<std::mutex> lock(clientsMutex);
+      for (const auto &client : clients) {
+        if (client.socketId == clientSock) {
+          disconnectedClient = client;
+          break;
+        }
       }
+
+      clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                   [clientSock](const ClientInfo &c) {
+                                     return c.socketId == clientSock;
+                                   }),
+                    clients.end());
     }
 
-    clients.erase(std::remove_if(clients.begin(), clients.end(),
-                                 [clientSock](const ClientInfo &c) {
-                                   return c.socketId == clientSock;
-                                 }),
-                  clients.end());
-
-    if (disconnectedClient && disconnectedClient->authenticated) {
-      users[disconnectedClient->username].setOnlineStatus(false);
-      NetworkUtils::broadcastToAll(clients, "[SYSTEM] " +
-                                                disconnectedClient->username +
-                                                " disconnected");
+    if (disconnectedClient.authenticated) {
+      userManager.setOnlineStatus(disconnectedClient.username, false);
     }
   } catch (const std::exception &e) {
     std::cerr << "Error during cleanup: " << e.what() << std::endl;
   }
-
-  SocketAbstraction::closeSocket(clientSock);
 }
 
 int main() {
@@ -489,11 +681,13 @@ int main() {
     }
 
     initializeUsers();
+    eventBus.start();
 
     std::cout << "=== JIRA-like Task Manager - Dual Server Mode ==="
               << std::endl;
     std::cout << "TCP Socket Server: port 8080 (for CLI clients)" << std::endl;
     std::cout << "HTTP API Server: port 8081 (for frontend)" << std::endl;
+    std::cout << "WebSocket Server: port 8082 (for frontend)" << std::endl;
     std::cout << "Available users: admin, pm1, dev1, tester1" << std::endl;
     std::cout << "================================================="
               << std::endl;
@@ -501,8 +695,33 @@ int main() {
     // Start HTTP API server in separate thread
     std::thread httpThread([&]() {
       try {
-        HTTPServer httpServer(taskManager, chatManager, users, serverMutex);
+        HTTPServer httpServer(taskManager, chatManager, userManager, pubSub,
+                              eventBus, httpAdmission());
+        httpServer.setSessionTimeout(std::chrono::seconds(
+            envCount("HTTP_SESSION_TIMEOUT_S",
+                     HTTPServer::SESSION_TIMEOUT_SECONDS)));
+        httpServer.setConnectionStats([] {
+          TCPServer::QueueStats stats = tcpServer.queueStats();
+          TCPServer::LoadStats load = tcpServer.loadStats();
+          std::string json;
+          JsonWriter writer(json);
+          writer.beginObject()
+              .field("tcpConnections", tcpServer.connectionCount())
+              .field("queuedBytes", stats.queuedBytes)
+              .field("deepestQueue", stats.deepestQueue)
+              .field("dropped", stats.dropped)
+              .field("coalesced", stats.coalesced)
+              .field("slowDisconnects", stats.slowDisconnects)
+              .field("rejectedConnections", load.rejectedConnections)
+              .field("deadConnections", load.deadConnections)
+              .field("idleConnections", load.idleConnections)
+              .key("admission");
+          NetworkUtils::writeAdmission(writer, load.commands);
+          writer.endObject();
+          return json;
+        });
         httpServer.setupRoutes();
+        httpServer.startWebSocket(8082);
         httpServer.start(8081);
       } catch (const std::exception &e) {
         std::cerr << "HTTP Server error: " << e.what() << std::endl;
@@ -510,51 +729,19 @@ int main() {
     });
     httpThread.detach();
 
-    // Continue with TCP server in main thread
-    SocketHandle serverSock = SocketAbstraction::createSocket();
-    if (!SocketAbstraction::isValidSocket(serverSock)) {
-      std::cerr << "Failed to create socket" << std::endl;
-      SocketAbstraction::cleanup();
-      return -1;
-    }
-
-    if (!SocketAbstraction::setReuseAddress(serverSock)) {
-      std::cerr << "Failed to set socket options" << std::endl;
-      SocketAbstraction::closeSocket(serverSock);
-      SocketAbstraction::cleanup();
-      return -1;
-    }
-
-    if (!SocketAbstraction::bindSocket(serverSock, 8080)) {
-      std::cerr << "Bind failed" << std::endl;
-      SocketAbstraction::closeSocket(serverSock);
-      SocketAbstraction::cleanup();
-      return -1;
-    }
-
-    if (!SocketAbstraction::listenSocket(serverSock, 10)) {
-      std::cerr << "Listen failed" << std::endl;
-      SocketAbstraction::closeSocket(serverSock);
-      SocketAbstraction::cleanup();
-      return -1;
-    }
-
-    std::cout << "TCP Socket Server running on port 8080..." << std::endl;
     std::cout << "Starting HTTP API server on port 8081..." << std::endl;
     std::cout << "Server started successfully. Waiting for connections..."
               << std::endl;
 
-    while (true) {
-      SocketHandle clientSock = SocketAbstraction::acceptSocket(serverSock);
-      if (SocketAbstraction::isValidSocket(clientSock)) {
-        std::cout << "New client connected" << std::endl;
-        std::thread(handleClient, clientSock).detach();
-      } else {
-        std::cerr << "Accept failed" << std::endl;
-      }
+    // Continue with TCP server in main thread
+    tcpServer.setHandlers(
+        {handleConnect, handleInput, handleDisconnect, commandPriority});
+    if (!tcpServer.start(8080)) {
+      std::cerr << "Failed to start TCP server" << std::endl;
+      SocketAbstraction::cleanup();
+      return -1;
     }
 
-    SocketAbstraction::closeSocket(serverSock);
     SocketAbstraction::cleanup();
   } catch (const std::exception &e) {
     std::cerr << "Server error: " << e.what() << std::endl;
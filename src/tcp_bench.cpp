@@ -0,0 +1,152 @@
+// TCP server IO benchmark - epoll vs io_uring reactors
+//
+// Runs an in-process TCPServer whose command handler echoes each input,
+// then drives it from one client thread: every connection keeps one
+// message in flight and sends the next as soon as the echo is back.
+// Reports round trips per second and the server's system calls per
+// message, taken from TCPServer::ioStats().
+//
+// Usage: tcp_bench [connections] [seconds] [reactors]
+#include "../include/Framing.hpp"
+#include "../include/PubSub.hpp"
+#include "../include/SocketAbstraction.hpp"
+#include "../include/TCPServer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+const std::string MESSAGE = Framing::encode("/ping benchmark-payload-0123");
+
+struct Result {
+  bool ran;
+  uint64_t roundTrips;
+  uint64_t syscalls;
+  double seconds;
+};
+
+// Echo clients against a running server; returns completed round trips
+uint64_t drive(uint16_t port, int connections, double seconds) {
+  EventPoller poller;
+  std::unordered_map<SocketHandle, size_t> pending; // bytes still expected
+  for (int i = 0; i < connections; ++i) {
+    SocketHandle socket = SocketAbstraction::createSocket();
+    if (!SocketAbstraction::connectSocket(socket, "127.0.0.1", port)) {
+      SocketAbstraction::closeSocket(socket);
+      continue;
+    }
+    SocketAbstraction::setNoDelay(socket);
+    SocketAbstraction::setNonBlocking(socket);
+    poller.add(socket);
+    pending[socket] = MESSAGE.size();
+    SocketAbstraction::sendData(socket, MESSAGE.data(), MESSAGE.size());
+  }
+
+  uint64_t roundTrips = 0;
+  std::vector<EventPoller::Event> events;
+  char buffer[4096];
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double>(seconds);
+  while (std::chrono::steady_clock::now() < deadline) {
+    poller.wait(events, 100);
+    for (const auto &event : events) {
+      if (!event.readable) {
+        continue;
+      }
+      while (true) {
+        int bytes =
+            SocketAbstraction::receiveData(event.socket, buffer, sizeof(buffer));
+        if (bytes <= 0) {
+          break;
+        }
+        size_t &left = pending[event.socket];
+        left -= std::min<size_t>(left, bytes);
+        if (left == 0) {
+          ++roundTrips;
+          left = MESSAGE.size();
+          SocketAbstraction::sendData(event.socket, MESSAGE.data(),
+                                      MESSAGE.size());
+        }
+      }
+    }
+  }
+  for (const auto &pair : pending) {
+    poller.remove(pair.first);
+    SocketAbstraction::closeSocket(pair.first);
+  }
+  return roundTrips;
+}
+
+Result run(TCPServer::IoBackend backend, uint16_t port, int connections,
+           double seconds, size_t reactors) {
+  PubSub pubSub;
+  TCPServer::Options options;
+  options.reactors = reactors;
+  options.workerThreads = 2;
+  options.backend = backend;
+  TCPServer server(pubSub, options);
+  server.setHandlers({nullptr,
+                      [&server](SocketHandle socket, const std::string &input) {
+                        server.send(socket, input);
+                      },
+                      nullptr, nullptr});
+
+  std::thread loop([&server, port] { server.start(port); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  if (server.backend() != backend) {
+    server.stop();
+    loop.join();
+    return {false, 0, 0, 0};
+  }
+
+  // Connection setup is not part of the measurement
+  TCPServer::IoStats before = server.ioStats();
+  auto started = std::chrono::steady_clock::now();
+  uint64_t roundTrips = drive(port, connections, seconds);
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - started)
+                       .count();
+  TCPServer::IoStats after = server.ioStats();
+
+  server.stop();
+  loop.join();
+  return {true, roundTrips, after.syscalls - before.syscalls, elapsed};
+}
+
+void report(const char *name, const Result &result) {
+  if (!result.ran) {
+    std::printf("%-9s unavailable on this system\n", name);
+    return;
+  }
+  double perSecond = result.roundTrips / result.seconds;
+  double perMessage =
+      result.roundTrips ? double(result.syscalls) / result.roundTrips : 0.0;
+  std::printf("%-9s %10.0f msgs/sec %8.2f syscalls/msg (%llu round trips)\n",
+              name, perSecond, perMessage,
+              static_cast<unsigned long long>(result.roundTrips));
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int connections = argc > 1 ? std::atoi(argv[1]) : 64;
+  double seconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+  size_t reactors = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+
+  if (!SocketAbstraction::initialize()) {
+    std::cerr << "Failed to initialize sockets" << std::endl;
+    return 1;
+  }
+  std::printf("%d connections, %.1fs per backend, %zu reactor(s)\n",
+              connections, seconds, reactors);
+  report("epoll", run(TCPServer::IoBackend::EPOLL, 18080, connections, seconds,
+                      reactors));
+  report("io_uring", run(TCPServer::IoBackend::IO_URING, 18081, connections,
+                         seconds, reactors));
+  SocketAbstraction::cleanup();
+  return 0;
+}
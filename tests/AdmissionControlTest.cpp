@@ -0,0 +1,41 @@
+#include "../include/AdmissionControl.hpp"
+#include "Test.hpp"
+
+namespace {
+// How many items of one priority an idle controller admits
+size_t admitted(size_t maxInFlight, AdmissionControl::Priority priority) {
+  AdmissionControl::Limits limits;
+  limits.maxInFlight = maxInFlight;
+  AdmissionControl admission(limits);
+  size_t count = 0;
+  while (count <= maxInFlight && admission.tryAdmit(priority)) {
+    ++count;
+  }
+  return count;
+}
+} // namespace
+
+TEST(AdmissionControlSplitsTheBudgetByPriority) {
+  CHECK(admitted(64, AdmissionControl::Priority::HIGH) == 64);
+  CHECK(admitted(64, AdmissionControl::Priority::NORMAL) == 48);
+  CHECK(admitted(64, AdmissionControl::Priority::LOW) == 32);
+}
+
+TEST(AdmissionControlAdmitsEveryPriorityUnderSmallLimits) {
+  for (size_t limit = 1; limit <= 3; ++limit) {
+    CHECK(admitted(limit, AdmissionControl::Priority::HIGH) == limit);
+    CHECK(admitted(limit, AdmissionControl::Priority::NORMAL) >= 1);
+    CHECK(admitted(limit, AdmissionControl::Priority::LOW) >= 1);
+  }
+}
+
+TEST(AdmissionControlReleaseMakesRoom) {
+  AdmissionControl::Limits limits;
+  limits.maxInFlight = 1;
+  AdmissionControl admission(limits);
+  CHECK(admission.tryAdmit(AdmissionControl::Priority::LOW));
+  CHECK(!admission.tryAdmit(AdmissionControl::Priority::HIGH));
+  admission.release();
+  CHECK(admission.tryAdmit(AdmissionControl::Priority::LOW));
+  CHECK(admission.stats().shed == 1);
+}
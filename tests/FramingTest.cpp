@@ -0,0 +1,160 @@
+#include "../include/BinaryProtocol.hpp"
+#include "../include/Framing.hpp"
+#include "Test.hpp"
+#include <cstdint>
+#include <string>
+
+namespace {
+std::string bytes(std::initializer_list<unsigned char> values) {
+  return std::string(values.begin(), values.end());
+}
+} // namespace
+
+TEST(VarintRoundTrips) {
+  const uint64_t values[] = {0,          1,          127,        128,
+                             300,        16383,      16384,      UINT32_MAX,
+                             1ull << 56, UINT64_MAX - 1, UINT64_MAX};
+  for (uint64_t value : values) {
+    std::string encoded;
+    Framing::putVarint(encoded, value);
+    CHECK(encoded.size() <= Framing::MAX_VARINT_SIZE);
+    uint64_t decoded = 0;
+    CHECK(Framing::getVarint(encoded.data(), encoded.size(), decoded) ==
+          encoded.size());
+    CHECK(decoded == value);
+  }
+  std::string small;
+  Framing::putVarint(small, 127);
+  CHECK(small.size() == 1);
+}
+
+TEST(VarintRejectsTruncatedInput) {
+  uint64_t value = 0;
+  std::string encoded;
+  Framing::putVarint(encoded, UINT64_MAX);
+  for (size_t length = 0; length < encoded.size(); ++length) {
+    CHECK(Framing::getVarint(encoded.data(), length, value) == 0);
+  }
+}
+
+TEST(VarintRejectsOverlongValues) {
+  uint64_t value = 0;
+  // Eleven bytes: longer than any uint64_t
+  std::string eleven(10, '\x80');
+  eleven += '\x01';
+  CHECK(Framing::getVarint(eleven.data(), eleven.size(), value) == 0);
+
+  // Ten bytes whose last one carries bits past the 64th
+  std::string wide(9, '\xff');
+  wide += '\x02';
+  CHECK(Framing::getVarint(wide.data(), wide.size(), value) == 0);
+  wide.back() = '\x7f';
+  CHECK(Framing::getVarint(wide.data(), wide.size(), value) == 0);
+
+  // The same length with only bit 63 set is UINT64_MAX
+  wide.back() = '\x01';
+  CHECK(Framing::getVarint(wide.data(), wide.size(), value) == 10);
+  CHECK(value == UINT64_MAX);
+}
+
+TEST(BinaryReaderRejectsLengthsPastTheBuffer) {
+  std::string message;
+  BinaryWriter writer(message);
+  writer.writeString("hello");
+  message.pop_back();
+  BinaryReader reader(message);
+  std::string text;
+  CHECK(!reader.readString(text));
+  CHECK(!reader.ok());
+
+  // A length near 2^64 must not wrap the bounds check
+  std::string huge;
+  Framing::putVarint(huge, UINT64_MAX);
+  huge += "abc";
+  BinaryReader hugeReader(huge);
+  CHECK(!hugeReader.readString(text));
+
+  // Once failed, every later read fails as well
+  uint8_t byte = 0;
+  CHECK(!hugeReader.readByte(byte));
+}
+
+TEST(BinaryReaderRejectsOverlongAndOutOfRangeFields) {
+  std::string overlong(11, '\x80');
+  BinaryReader reader(overlong);
+  uint64_t value = 0;
+  CHECK(!reader.readVarint(value));
+
+  std::string message;
+  BinaryWriter writer(message);
+  writer.writeSigned(static_cast<int64_t>(INT32_MAX) + 1);
+  writer.writeSigned(-5);
+  BinaryReader intReader(message);
+  int number = 0;
+  CHECK(!intReader.readInt(number));
+
+  std::string negative;
+  BinaryWriter(negative).writeSigned(-5);
+  BinaryReader negativeReader(negative);
+  CHECK(negativeReader.readInt(number) && number == -5);
+  CHECK(negativeReader.atEnd());
+}
+
+TEST(FrameReaderSplitsPrefixedFrames) {
+  std::string stream;
+  Framing::encodeBinary(stream, "first");
+  Framing::encodeBinary(stream, "");
+  Framing::encodeBinary(stream, std::string(300, 'x'));
+
+  FrameReader reader;
+  reader.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+  std::string frame;
+  // Byte by byte: a frame only comes out once it is complete
+  size_t frames = 0;
+  for (char c : stream) {
+    reader.append(&c, 1);
+    while (reader.next(frame)) {
+      ++frames;
+    }
+  }
+  CHECK(frames == 3);
+  CHECK(frame == std::string(300, 'x'));
+  CHECK(!reader.overflowed());
+}
+
+TEST(FrameReaderRejectsBadPrefixes) {
+  std::string frame;
+
+  FrameReader tooLong;
+  tooLong.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+  std::string prefix;
+  Framing::putVarint(prefix, FrameReader::MAX_FRAME_SIZE + 1);
+  tooLong.append(prefix.data(), prefix.size());
+  CHECK(!tooLong.next(frame));
+  CHECK(tooLong.overflowed());
+
+  FrameReader overlong;
+  overlong.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+  std::string garbage(Framing::MAX_VARINT_SIZE, '\xff');
+  overlong.append(garbage.data(), garbage.size());
+  CHECK(!overlong.next(frame));
+  CHECK(overlong.overflowed());
+
+  // A short prefix may still be completed by the next read
+  FrameReader partial;
+  partial.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+  std::string start = bytes({0x80, 0x80});
+  partial.append(start.data(), start.size());
+  CHECK(!partial.next(frame));
+  CHECK(!partial.overflowed());
+}
+
+TEST(FrameReaderUnescapesLines) {
+  std::string stream = Framing::encode("two\nlines \\ and\r") + "telnet\r\n";
+  FrameReader reader;
+  reader.append(stream.data(), stream.size());
+  std::string frame;
+  CHECK(reader.next(frame) && frame == "two\nlines \\ and\r");
+  CHECK(reader.next(frame) && frame == "telnet");
+  CHECK(!reader.next(frame));
+}
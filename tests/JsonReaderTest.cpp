@@ -0,0 +1,129 @@
+#include "../include/JsonReader.hpp"
+#include "Test.hpp"
+#include <string>
+
+namespace {
+bool parses(const std::string &text) {
+  JsonValue root;
+  return JsonReader::parse(text, root);
+}
+
+// The decoded value of a one-string document
+std::string decode(const std::string &literal) {
+  JsonValue root;
+  std::string out = "<unparsed>";
+  if (JsonReader::parse(literal, root)) {
+    root.get(out);
+  }
+  return out;
+}
+} // namespace
+
+TEST(JsonReaderAcceptsValidDocuments) {
+  const char *documents[] = {
+      "{}", "[]", "0", "-0.5e+10", "1E3", "\"x\"", "true", "false", "null",
+      " {\"a\" : 1 , \"b\":[1,2,{\"c\":\"}\"}]} ", "[[[]]]", "\"\\/\\b\\f\"",
+  };
+  for (const char *document : documents) {
+    CHECK(parses(document));
+  }
+}
+
+TEST(JsonReaderRejectsMalformedInput) {
+  const char *documents[] = {
+      "",         " ",        "{\"a\"}",  "{\"a\":}",   "[1,]",    "{,}",
+      "01",       "1.",       ".5",       "+1",         "1e",      "-",
+      "tru",      "nul",      "True",     "{a:1}",      "[1 2]",   "{} x",
+      "\"\\x\"",  "\"a\nb\"", "'a'",      "\"\\u12G4\"", "[1],[2]", "{\"a\":1,}",
+  };
+  for (const char *document : documents) {
+    CHECK(!parses(document));
+  }
+  JsonValue root;
+  std::string error;
+  CHECK(!JsonReader::parse("[1,]", root, &error));
+  CHECK(error.find("offset 3") != std::string::npos);
+}
+
+TEST(JsonReaderRejectsEveryTruncation) {
+  const std::string document =
+      R"({"title":"a \"b\" \u00e9","n":-12.5e3,"ok":true,"none":null,)"
+      R"("list":[1,{"k":[]},"\ud83d\ude00"]})";
+  CHECK(parses(document));
+  for (size_t length = 0; length < document.size(); ++length) {
+    CHECK(!parses(document.substr(0, length)));
+  }
+}
+
+TEST(JsonReaderBoundsNesting) {
+  auto nested = [](int depth, char open, char close) {
+    return std::string(depth, open) + std::string(depth, close);
+  };
+  CHECK(parses(nested(JsonReader::MAX_DEPTH, '[', ']')));
+  CHECK(!parses(nested(JsonReader::MAX_DEPTH + 1, '[', ']')));
+
+  std::string objects;
+  for (int i = 0; i <= JsonReader::MAX_DEPTH; ++i) {
+    objects += "{\"a\":";
+  }
+  objects += "1" + std::string(JsonReader::MAX_DEPTH + 1, '}');
+  CHECK(!parses(objects));
+
+  // Far past the limit: refused without running out of stack
+  CHECK(!parses(nested(1000000, '[', ']')));
+  CHECK(!parses(std::string(1000000, '[')));
+}
+
+TEST(JsonReaderDecodesSurrogatePairs) {
+  CHECK(decode(R"("\u00e9")") == "\xC3\xA9");
+  CHECK(decode(R"("\u20AC")") == "\xE2\x82\xAC");
+  CHECK(decode(R"("\ud83d\ude00")") == "\xF0\x9F\x98\x80");
+  CHECK(decode(R"("\uDBFF\uDFFF")") == "\xF4\x8F\xBF\xBF");
+  CHECK(decode(R"("a\ud83d\ude00b")") == "a\xF0\x9F\x98\x80" "b");
+}
+
+TEST(JsonReaderReplacesLoneSurrogates) {
+  const std::string replacement = "\xEF\xBF\xBD";
+  CHECK(decode(R"("\ud800")") == replacement);
+  CHECK(decode(R"("\ud800x")") == replacement + "x");
+  CHECK(decode(R"("\udc00")") == replacement);
+  CHECK(decode(R"("\ude00\ud83d")") == replacement + replacement);
+  CHECK(decode(R"("\ud800\ud800")") == replacement + replacement);
+  CHECK(decode(R"("\ud800\u0041")") == replacement + "A");
+  CHECK(decode(R"("\ud800\n")") == replacement + "\n");
+  CHECK(!parses(R"("\ud800\uZZZZ")"));
+  CHECK(!parses(R"("\ud800\u")"));
+}
+
+TEST(JsonReaderTypedReads) {
+  JsonValue root;
+  const std::string document =
+      R"({"n":42,"f":1.5,"big":3000000000,"neg":-7,"b":true,"nil":null,)"
+      R"("k\u0065y":"esc","arr":[1,"two",{"k":[3]},4],"n":0})";
+  CHECK(JsonReader::parse(document, root));
+  int number = 0;
+  std::string text;
+  bool flag = false;
+  CHECK(root["n"].get(number) && number == 42); // first of a repeated key
+  CHECK(!root["f"].get(number));
+  CHECK(!root["big"].get(number));
+  CHECK(root["neg"].get(number) && number == -7);
+  CHECK(!root["n"].get(text));
+  CHECK(root["b"].get(flag) && flag);
+  CHECK(root["key"].get(text) && text == "esc");
+
+  number = 9;
+  CHECK(root["nil"].getOptional(number) && number == 9);
+  CHECK(root["absent"].getOptional(number) && number == 9);
+  CHECK(!root["key"].getOptional(number));
+
+  CHECK(root["arr"].size() == 4);
+  std::string joined;
+  for (const auto &element : root["arr"]) {
+    joined += std::string(element.text()) + ";";
+  }
+  CHECK(joined == R"(1;"two";{"k":[3]};4;)");
+  CHECK(root["arr"]["k"].isMissing());
+  CHECK(root["n"].size() == 0);
+  CHECK(root["n"].begin() == root["n"].end());
+}
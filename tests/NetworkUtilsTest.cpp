@@ -0,0 +1,47 @@
+#include "../include/BinaryProtocol.hpp"
+#include "../include/Framing.hpp"
+#include "../include/NetworkUtils.hpp"
+#include "Test.hpp"
+#include <string>
+
+namespace {
+// What TCPServer hands the command handler for a binary COMMAND frame
+std::string receivedCommand(const std::string &input) {
+  std::string frame;
+  Framing::encodeBinary(frame, BinaryProtocol::command(input));
+  FrameReader reader;
+  reader.setMode(FrameReader::Mode::LENGTH_PREFIXED);
+  reader.append(frame.data(), frame.size());
+  std::string message;
+  std::string text;
+  BinaryProtocol::Type type;
+  if (!reader.next(message)) {
+    return "";
+  }
+  BinaryReader fields(message);
+  if (!BinaryProtocol::readType(fields, type) ||
+      type != BinaryProtocol::Type::COMMAND || !fields.readString(text)) {
+    return "";
+  }
+  return text;
+}
+} // namespace
+
+TEST(ParseCommandKeepsColonsInBinaryCommands) {
+  const std::string inputs[] = {"/create Fix bug | desc deadline:3",
+                                "/chat hi: there", "/list"};
+  for (const auto &input : inputs) {
+    std::string command;
+    CHECK(NetworkUtils::parseCommand(receivedCommand(input), true, command));
+    CHECK(command == input);
+  }
+}
+
+TEST(ParseCommandStripsTheTextPrefix) {
+  std::string command;
+  CHECK(NetworkUtils::parseCommand("CMD:/chat hi: there", false, command));
+  CHECK(command == "/chat hi: there");
+  CHECK(NetworkUtils::parseCommand("/list", false, command));
+  CHECK(command == "/list");
+  CHECK(!NetworkUtils::parseCommand("MSG:hello", false, command));
+}
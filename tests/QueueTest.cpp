@@ -0,0 +1,86 @@
+#include "../include/BoundedQueue.hpp"
+#include "../include/RingBuffer.hpp"
+#include "Test.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(BoundedQueueIsFifoAndBounded) {
+  BoundedQueue<int> queue(5);
+  CHECK(queue.capacity() == 8);
+  for (int i = 0; i < 8; ++i) {
+    CHECK(queue.tryPush(i));
+  }
+  CHECK(!queue.tryPush(8));
+  CHECK(queue.size() == 8);
+  int value = -1;
+  for (int i = 0; i < 8; ++i) {
+    CHECK(queue.tryPop(value) && value == i);
+  }
+  CHECK(!queue.tryPop(value));
+
+  // Wrapping around the cells keeps the order
+  for (int round = 0; round < 100; ++round) {
+    CHECK(queue.tryPush(round));
+    CHECK(queue.tryPop(value) && value == round);
+  }
+}
+
+TEST(BoundedQueueLosesNothingUnderContention) {
+  BoundedQueue<long> queue(64);
+  const int producers = 4;
+  const long perProducer = 50000;
+  std::atomic<long> sum{0};
+  std::atomic<long> popped{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (long i = 1; i <= perProducer; ++i) {
+        while (!queue.tryPush(p * perProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      long value = 0;
+      while (popped.load() < producers * perProducer) {
+        if (queue.tryPop(value)) {
+          sum += value;
+          ++popped;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  long total = producers * perProducer;
+  CHECK(popped.load() == total);
+  CHECK(sum.load() == total * (total + 1) / 2);
+}
+
+TEST(RingBufferKeepsTheNewestContiguous) {
+  RingBuffer<int> ring(4);
+  size_t count = 0;
+  CHECK(ring.tail(10, count) != nullptr && count == 0);
+  for (int i = 1; i <= 10; ++i) {
+    ring.push(i);
+    // Every window is one pointer range, oldest first, across the wrap
+    const int *view = ring.tail(10, count);
+    CHECK(count == static_cast<size_t>(i < 4 ? i : 4));
+    for (size_t j = 0; j < count; ++j) {
+      CHECK(view[j] == i - static_cast<int>(count) + 1 + static_cast<int>(j));
+    }
+  }
+  const int *newest = ring.tail(2, count);
+  CHECK(count == 2 && newest[0] == 9 && newest[1] == 10);
+  CHECK(ring.size() == 4);
+
+  RingBuffer<int> single(0);
+  CHECK(single.capacity() == 1);
+  single.push(1);
+  single.push(2);
+  CHECK(*single.tail(5, count) == 2 && count == 1);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <iostream>
+#include <vector>
+
+/**
+ * Minimal test harness for the unit_tests executable. TEST(name) defines
+ * and registers a case; CHECK records a failure and carries on, so one run
+ * reports every broken expectation. unit_tests [prefix] runs the cases
+ * whose name starts with prefix, which is how CTest splits them up.
+ */
+struct TestCase {
+  const char *name;
+  void (*run)();
+};
+
+std::vector<TestCase> &testCases();
+extern int testFailures;
+
+struct TestRegistrar {
+  TestRegistrar(const char *name, void (*run)()) {
+    testCases().push_back({name, run});
+  }
+};
+
+#define TEST(name)                                                             \
+  static void name();                                                          \
+  static TestRegistrar name##Registrar(#name, name);                           \
+  static void name()
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ++testFailures;                                                          \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition        \
+                << ") failed" << std::endl;                                    \
+    }                                                                          \
+  } while (0)
@@ -0,0 +1,31 @@
+#include "Test.hpp"
+#include <cstring>
+
+std::vector<TestCase> &testCases() {
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+int testFailures = 0;
+
+int main(int argc, char *argv[]) {
+  const char *prefix = argc > 1 ? argv[1] : "";
+  size_t run = 0;
+  for (const auto &test : testCases()) {
+    if (std::strncmp(test.name, prefix, std::strlen(prefix)) != 0) {
+      continue;
+    }
+    int before = testFailures;
+    test.run();
+    std::cout << (testFailures == before ? "ok     " : "FAILED ") << test.name
+              << std::endl;
+    ++run;
+  }
+  if (run == 0) {
+    std::cerr << "No tests match '" << prefix << "'" << std::endl;
+    return 1;
+  }
+  std::cout << run << " tests, " << testFailures << " failed checks"
+            << std::endl;
+  return testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include "../include/TimingWheel.hpp"
+#include "Test.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace {
+using Clock = TimingWheel::Clock;
+const Clock::duration TICK = std::chrono::milliseconds(1);
+const Clock::time_point START{};
+
+Clock::time_point at(uint64_t ticks) { return START + TICK * ticks; }
+} // namespace
+
+TEST(TimingWheelFiresOnTimeNotEarly) {
+  TimingWheel wheel(TICK, START);
+  int fired = 0;
+  wheel.schedule(at(5), [&] { ++fired; });
+  CHECK(wheel.advance(at(4)) == 0);
+  CHECK(wheel.advance(at(5)) == 1);
+  CHECK(fired == 1);
+  CHECK(wheel.empty());
+
+  // Part of a tick rounds up
+  wheel.schedule(at(7) + TICK / 2, [&] { ++fired; });
+  CHECK(wheel.advance(at(7)) == 0);
+  CHECK(wheel.advance(at(8)) == 1);
+}
+
+TEST(TimingWheelCascadesFromEveryLevel) {
+  // One deadline per level, each just past a wheel boundary
+  const uint64_t deadlines[] = {
+      200,
+      TimingWheel::SLOTS + 3,
+      TimingWheel::SLOTS * TimingWheel::SLOTS + 5,
+      TimingWheel::SLOTS * TimingWheel::SLOTS * TimingWheel::SLOTS + 7,
+  };
+  for (uint64_t deadline : deadlines) {
+    TimingWheel wheel(TICK, START);
+    int fired = 0;
+    wheel.schedule(at(deadline), [&] { ++fired; });
+    CHECK(wheel.advance(at(deadline - 1)) == 0);
+    CHECK(wheel.advance(at(deadline)) == 1);
+    CHECK(fired == 1);
+  }
+}
+
+TEST(TimingWheelFiresEachTimerAtItsTick) {
+  TimingWheel wheel(TICK, START);
+  const uint64_t horizon = 3 * TimingWheel::SLOTS * TimingWheel::SLOTS;
+  const uint64_t step = 13;
+  uint64_t now = 0;
+  size_t late = 0;
+  size_t fired = 0;
+  for (uint64_t i = 1; i <= 2000; ++i) {
+    uint64_t deadline = (i * 7919) % horizon + 1;
+    wheel.schedule(at(deadline), [&, deadline] {
+      ++fired;
+      if (now < deadline || now >= deadline + step) {
+        ++late;
+      }
+    });
+  }
+  while (!wheel.empty()) {
+    now += step;
+    wheel.advance(at(now));
+  }
+  CHECK(fired == 2000);
+  CHECK(late == 0);
+}
+
+TEST(TimingWheelReschedulesFromCallbacks) {
+  TimingWheel wheel(TICK, START);
+  std::vector<uint64_t> beats;
+  uint64_t now = 0;
+  // A heartbeat that re-arms itself, crossing several level-0 turns
+  std::function<void()> beat = [&] {
+    beats.push_back(now);
+    if (beats.size() < 5) {
+      wheel.schedule(at(now + 100), beat);
+    }
+  };
+  wheel.schedule(at(100), beat);
+  for (now = 1; now <= 1000; ++now) {
+    wheel.advance(at(now));
+  }
+  CHECK((beats == std::vector<uint64_t>{100, 200, 300, 400, 500}));
+  CHECK(wheel.empty());
+
+  // A deadline already reached fires on the next tick, not the current one
+  int fired = 0;
+  wheel.schedule(at(1001), [&] {
+    wheel.schedule(at(0), [&] { ++fired; });
+  });
+  CHECK(wheel.advance(at(1001)) == 1);
+  CHECK(fired == 0);
+  CHECK(wheel.advance(at(1005)) == 1);
+  CHECK(fired == 1);
+
+  // Re-arming into a far level from a callback cascades back down
+  uint64_t far = 0;
+  wheel.schedule(at(1010), [&] {
+    wheel.schedule(at(1010 + 70000), [&] { ++far; });
+  });
+  CHECK(wheel.advance(at(1010)) == 1);
+  CHECK(wheel.advance(at(1010 + 69999)) == 0);
+  CHECK(wheel.advance(at(1010 + 70000)) == 1);
+  CHECK(far == 1);
+}
+
+TEST(TimingWheelCancelsFromCallbacks) {
+  // Two timers in one slot, each cancelling the other: whichever runs
+  // first must stop the second
+  TimingWheel wheel(TICK, START);
+  int fired = 0;
+  TimingWheel::TimerId first = 0;
+  TimingWheel::TimerId second = 0;
+  first = wheel.schedule(at(10), [&] {
+    ++fired;
+    CHECK(wheel.cancel(second));
+  });
+  second = wheel.schedule(at(10), [&] {
+    ++fired;
+    CHECK(wheel.cancel(first));
+  });
+  CHECK(wheel.advance(at(10)) == 1);
+  CHECK(fired == 1);
+  CHECK(wheel.empty());
+}
+
+TEST(TimingWheelIgnoresStaleIds) {
+  TimingWheel wheel(TICK, START);
+  TimingWheel::TimerId first = wheel.schedule(at(1), [] {});
+  CHECK(wheel.advance(at(1)) == 1);
+  CHECK(!wheel.cancel(first));
+  CHECK(!wheel.cancel(0));
+
+  // The freed node is reused under a new id; the old one must miss it
+  TimingWheel::TimerId reused = wheel.schedule(at(5), [] {});
+  CHECK(reused != first);
+  CHECK(!wheel.cancel(first));
+  CHECK(wheel.size() == 1);
+  CHECK(wheel.cancel(reused));
+  CHECK(!wheel.cancel(reused));
+}
+
+TEST(TimingWheelReportsTheNextDeadline) {
+  TimingWheel wheel(TICK, START);
+  CHECK(wheel.timeUntilNext(at(0)) == Clock::duration::max());
+  wheel.schedule(at(10), [] {});
+  CHECK(wheel.timeUntilNext(at(0)) <= TICK * 10);
+  CHECK(wheel.timeUntilNext(at(0)) > Clock::duration::zero());
+  CHECK(wheel.timeUntilNext(at(20)) == Clock::duration::zero());
+}